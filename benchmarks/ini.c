@@ -0,0 +1,107 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for reading and writing large ini files
+ *
+ * The time should grow linearly with the number of lines. Writing
+ * a single changed key should only take the time to copy the file.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+#define NR_KEYS 100
+
+static const size_t sections[] = { 50, 100, 200, 300 };
+
+static void benchmarkWriteFile (const char * file, size_t nr)
+{
+	FILE * f = fopen (file, "w");
+	if (!f)
+	{
+		fprintf (stderr, "could not write %s\n", file);
+		exit (1);
+	}
+	for (size_t i = 0; i < nr; ++i)
+	{
+		fprintf (f, "[section%zu]\n", i);
+		for (size_t j = 0; j < NR_KEYS - 1; ++j)
+		{
+			fprintf (f, "key%zu = value %zu\n", j, j);
+		}
+	}
+	fclose (f);
+}
+
+static void benchmarkIni (KeySet * modules, const char * file, size_t nr)
+{
+	char msg[BUF_SIZ];
+	char tmpFile[KEY_NAME_LENGTH + 1];
+	snprintf (tmpFile, KEY_NAME_LENGTH, "%s.tmp", file);
+	Plugin * plugin = elektraPluginOpen ("ini", modules, ksNew (0, KS_END), 0);
+	if (!plugin)
+	{
+		fprintf (stderr, "could not open ini\n");
+		exit (1);
+	}
+	benchmarkWriteFile (file, nr);
+
+	Key * parentKey = keyNew ("user/benchmark", KEY_VALUE, file, KEY_END);
+	KeySet * ks = ksNew (0, KS_END);
+
+	printf ("%zu lines\n", nr * NR_KEYS);
+	timeInit ();
+	plugin->kdbGet (plugin, ks, parentKey);
+	snprintf (msg, BUF_SIZ, "get %zd keys", ksGetSize (ks));
+	timePrint (msg);
+
+	// as after kdbGet(), only the changed section gets written
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != 0)
+	{
+		keyClearSync (cur);
+	}
+	keySetString (ksLookupByName (ks, "user/benchmark/section0/key0", 0), "changed");
+	keySetString (parentKey, tmpFile);
+	timeInit ();
+	plugin->kdbSet (plugin, ks, parentKey);
+	timePrint ("set one key");
+
+	keySetString (parentKey, file);
+	plugin->kdbGet (plugin, ks, parentKey);
+	keySetString (parentKey, tmpFile);
+	timeInit ();
+	plugin->kdbSet (plugin, ks, parentKey);
+	timePrint ("set all keys");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	elektraPluginClose (plugin, 0);
+	unlink (file);
+	unlink (tmpFile);
+}
+
+int main ()
+{
+	char file[] = "/tmp/elektra-benchmark-XXXXXX";
+	int fd = mkstemp (file);
+	if (fd == -1)
+	{
+		fprintf (stderr, "could not create file\n");
+		return 1;
+	}
+	close (fd);
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+
+	for (size_t i = 0; i < sizeof (sections) / sizeof (sections[0]); ++i)
+	{
+		benchmarkIni (modules, file, sections[i]);
+	}
+
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
@@ -48,6 +48,29 @@ void benchmarkLookupByName ()
 	}
 }
 
+KeySet * lookupKeys;
+
+void benchmarkCreateLookupKeys ()
+{
+	lookupKeys = ksDeepDup (large);
+}
+
+void benchmarkLookup ()
+{
+	Key * current;
+	ksRewind (lookupKeys);
+	while ((current = ksNext (lookupKeys)) != 0)
+	{
+		ksLookup (large, current, 0);
+	}
+}
+
+void benchmarkLookupIndex ()
+{
+	elektraKsHashIndex (large, 1);
+	benchmarkLookup ();
+}
+
 void benchmarkReread ()
 {
 	kdbGet (kdb, large, key);
@@ -107,6 +130,21 @@ int main ()
 	benchmarkLookupByName ();
 	timePrint ("Lookup key database");
 
+	benchmarkCreateLookupKeys ();
+	timePrint ("Create lookup keys");
+
+	benchmarkLookup ();
+	timePrint ("Binary search lookup");
+
+	benchmarkLookupIndex ();
+	timePrint ("Hash index lookup");
+
+	benchmarkLookupIndex ();
+	timePrint ("Hash index lookup (built)");
+
+	elektraKsHashIndex (large, 0);
+	ksDel (lookupKeys);
+
 	benchmarkReread ();
 	timePrint ("Re read key database");
 
@@ -0,0 +1,103 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for resolving the mountpoint of keys with the trie
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+#define NR_LOOKUPS 1000000
+
+static const size_t mountpoints[] = { 10, 100, 1000 };
+
+Trie * trie;
+KeySet * lookupKeys;
+
+static Backend * benchmarkBackend (const char * name)
+{
+	Backend * backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (name, KEY_END);
+	backend->refcounter = 1;
+	keyIncRef (backend->mountpoint);
+	return backend;
+}
+
+void benchmarkMount (size_t nr)
+{
+	char name[KEY_NAME_LENGTH + 1];
+
+	trie = elektraTrieInsert (0, "user/", benchmarkBackend ("user"));
+	trie = elektraTrieInsert (trie, "system/", benchmarkBackend ("system"));
+	for (size_t i = 0; i < nr; ++i)
+	{
+		// similar to real mountpoints: some common prefixes, some nested ones
+		snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zu/", i % 2 ? "user" : "system", i % 7, i);
+		trie = elektraTrieInsert (trie, name, benchmarkBackend (name));
+		if (i % 10 == 0)
+		{
+			snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zu/nested/", i % 2 ? "user" : "system", i % 7, i);
+			trie = elektraTrieInsert (trie, name, benchmarkBackend (name));
+		}
+	}
+}
+
+void benchmarkCreateLookupKeys (size_t nr)
+{
+	char name[KEY_NAME_LENGTH + 1];
+
+	lookupKeys = ksNew (nr * 4, KS_END);
+	for (size_t i = 0; i < nr; ++i)
+	{
+		const char * ns = i % 2 ? "user" : "system";
+		snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zu", ns, i % 7, i);
+		ksAppendKey (lookupKeys, keyNew (name, KEY_END));
+		snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zu/some/deep/key", ns, i % 7, i);
+		ksAppendKey (lookupKeys, keyNew (name, KEY_END));
+		snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zu/nested/key", ns, i % 7, i);
+		ksAppendKey (lookupKeys, keyNew (name, KEY_END));
+		snprintf (name, KEY_NAME_LENGTH, "%s/sw/org%zu/app%zux/not/mounted", ns, i % 7, i);
+		ksAppendKey (lookupKeys, keyNew (name, KEY_END));
+	}
+}
+
+void benchmarkLookup ()
+{
+	Key * current;
+	size_t found = 0;
+	for (size_t i = 0; i < NR_LOOKUPS; i += ksGetSize (lookupKeys))
+	{
+		ksRewind (lookupKeys);
+		while ((current = ksNext (lookupKeys)) != 0)
+		{
+			if (elektraTrieLookup (trie, current)) ++found;
+		}
+	}
+	if (!found) fprintf (stderr, "no mountpoint found\n");
+}
+
+int main ()
+{
+	char msg[BUF_SIZ];
+
+	for (size_t i = 0; i < sizeof (mountpoints) / sizeof (mountpoints[0]); ++i)
+	{
+		printf ("%zu mountpoints\n", mountpoints[i]);
+
+		timeInit ();
+		benchmarkMount (mountpoints[i]);
+		timePrint ("Mounted");
+
+		benchmarkCreateLookupKeys (mountpoints[i]);
+		timePrint ("Created lookup keys");
+
+		benchmarkLookup ();
+		snprintf (msg, BUF_SIZ, "%d lookups", NR_LOOKUPS);
+		timePrint (msg);
+
+		ksDel (lookupKeys);
+		elektraTrieClose (trie, 0);
+		timePrint ("Closed");
+	}
+}
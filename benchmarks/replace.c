@@ -0,0 +1,66 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for replacing keys of a key set with ksAppendKey()
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+KeySet * replacements[2];
+
+void benchmarkAddMeta ()
+{
+	Key * current;
+	ksRewind (large);
+	while ((current = ksNext (large)) != 0)
+	{
+		keySetMeta (current, "type", "string");
+		keySetMeta (current, "check/type", "string");
+	}
+}
+
+void benchmarkCreateReplacements ()
+{
+	replacements[0] = ksDeepDup (large);
+	replacements[1] = ksDeepDup (large);
+}
+
+void benchmarkReplace ()
+{
+	Key * current;
+	for (int i = 0; i < NR; ++i)
+	{
+		// alternate, so that every append really replaces a key
+		KeySet * from = replacements[i % 2];
+		ksRewind (from);
+		while ((current = ksNext (from)) != 0)
+		{
+			ksAppendKey (large, current);
+		}
+	}
+}
+
+int main ()
+{
+	timeInit ();
+	benchmarkCreate ();
+	timePrint ("Created empty keyset");
+
+	benchmarkFillup ();
+	timePrint ("New large keyset");
+
+	benchmarkAddMeta ();
+	timePrint ("Added meta data");
+
+	benchmarkCreateReplacements ();
+	timePrint ("Created replacements");
+
+	benchmarkReplace ();
+	timePrint ("Replaced keys");
+
+	ksDel (replacements[0]);
+	ksDel (replacements[1]);
+	ksDel (large);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file
+ *
+ * @brief Benchmark for writing configuration files from several threads
+ *
+ * Every thread writes its own file with the resolver, so the threads
+ * should neither conflict nor wait for each other: with more threads
+ * the same number of commits per thread should take about the same time.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <benchmarks.h>
+
+#include <pthread.h>
+
+#define NR_COMMITS 100
+
+static const size_t threads[] = { 1, 2, 4, 8 };
+
+typedef struct
+{
+	Plugin * plugin;
+	KeySet * ks;
+	size_t conflicts;
+} Writer;
+
+static void * benchmarkWriter (void * data)
+{
+	Writer * writer = data;
+	Plugin * plugin = writer->plugin;
+	Key * parentKey = keyNew ("system/benchmark", KEY_END);
+
+	for (size_t i = 0; i < NR_COMMITS; ++i)
+	{
+		plugin->kdbGet (plugin, writer->ks, parentKey);
+		if (plugin->kdbSet (plugin, writer->ks, parentKey) != 1)
+		{
+			plugin->kdbError (plugin, writer->ks, parentKey);
+			++writer->conflicts;
+			continue;
+		}
+
+		// what a storage plugin would do
+		FILE * f = fopen (keyString (parentKey), "w");
+		if (f)
+		{
+			fprintf (f, "commit %zu\n", i);
+			fclose (f);
+		}
+		plugin->kdbSet (plugin, writer->ks, parentKey);
+	}
+
+	keyDel (parentKey);
+	return 0;
+}
+
+static void benchmarkWrite (KeySet * modules, const char * dir, size_t nr)
+{
+	char name[KEY_NAME_LENGTH + 1];
+	char msg[BUF_SIZ];
+	Writer * writers = elektraCalloc (nr * sizeof (Writer));
+	pthread_t * workers = elektraCalloc (nr * sizeof (pthread_t));
+
+	for (size_t i = 0; i < nr; ++i)
+	{
+		snprintf (name, KEY_NAME_LENGTH, "%s/file%zu.ecf", dir, i);
+		KeySet * conf = ksNew (1, keyNew ("system/path", KEY_VALUE, name, KEY_END), KS_END);
+		writers[i].plugin = elektraPluginOpen ("resolver", modules, conf, 0);
+		writers[i].ks = ksNew (1, keyNew ("system/benchmark/key", KEY_VALUE, "value", KEY_END), KS_END);
+		if (!writers[i].plugin)
+		{
+			fprintf (stderr, "could not open resolver\n");
+			exit (1);
+		}
+	}
+
+	timeInit ();
+	for (size_t i = 0; i < nr; ++i)
+	{
+		pthread_create (&workers[i], 0, benchmarkWriter, &writers[i]);
+	}
+
+	size_t conflicts = 0;
+	for (size_t i = 0; i < nr; ++i)
+	{
+		pthread_join (workers[i], 0);
+		conflicts += writers[i].conflicts;
+	}
+	snprintf (msg, BUF_SIZ, "%zu threads", nr);
+	timePrint (msg);
+	printf ("%20s: %20zu of %d\n", "Conflicts", conflicts, (int)nr * NR_COMMITS);
+
+	for (size_t i = 0; i < nr; ++i)
+	{
+		elektraPluginClose (writers[i].plugin, 0);
+		ksDel (writers[i].ks);
+		snprintf (name, KEY_NAME_LENGTH, "%s/file%zu.ecf", dir, i);
+		unlink (name);
+	}
+	elektraFree (writers);
+	elektraFree (workers);
+}
+
+int main ()
+{
+	char dir[] = "/tmp/elektra-benchmark-XXXXXX";
+	if (!mkdtemp (dir))
+	{
+		fprintf (stderr, "could not create directory\n");
+		return 1;
+	}
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+
+	printf ("%d commits per thread\n", NR_COMMITS);
+	for (size_t i = 0; i < sizeof (threads) / sizeof (threads[0]); ++i)
+	{
+		benchmarkWrite (modules, dir, threads[i]);
+	}
+
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+	rmdir (dir);
+}
@@ -180,6 +180,10 @@ set (KDB_DB_INIT "elektra.ecf" CACHE STRING
 		"This configuration file will be used for bootstrapping."
 		)
 
+set (KDB_DB_CACHE ".cache/elektra" CACHE STRING
+		"This path will be appended after the resolved home directory. The bootstrap configuration will be cached there if system/elektra/cache is set, empty disables the cache."
+		)
+
 set (KDB_DEFAULT_STORAGE "dump" CACHE STRING
 	"This storage plugin will be used initially (as default and for bootstrapping).")
 
@@ -14,6 +14,7 @@
 #include <keyio.hpp>
 
 #include <keyset.hpp>
+#include <keysetview.hpp>
 
 namespace kdb
 {
@@ -62,6 +63,39 @@ inline std::ostream & operator<< (std::ostream & os, kdb::KeySet const & cks)
 	return os;
 }
 
+/**
+ * @brief Outputs line per line the keynames of a view
+ *
+ * Uses the same format as the output of a keyset.
+ *
+ * @param os the stream to write to
+ * @param view the keys which should be streamed
+ *
+ * @return the stream
+ */
+inline std::ostream & operator<< (std::ostream & os, kdb::KeySetView const & view)
+{
+	for (kdb::Key k : view)
+	{
+		os << k;
+		if (os.flags () & std::ios_base::skipws)
+		{
+			os << '\n';
+		}
+		else
+		{
+			os << '\0';
+		}
+
+		if (os.flags () & std::ios_base::unitbuf)
+		{
+			os << std::flush;
+		}
+	}
+
+	return os;
+}
+
 /**
  * @brief Reads line per line key names and appends those keys to ks.
  *
@@ -0,0 +1,170 @@
+/**
+ * @file
+ *
+ * @brief Non-owning view on the keys below a key
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifndef ELEKTRA_KEYSETVIEW_HPP
+#define ELEKTRA_KEYSETVIEW_HPP
+
+#include <iterator>
+#include <string>
+
+#include <key.hpp>
+#include <keyset.hpp>
+
+#include <kdbproposal.h>
+
+namespace kdb
+{
+
+class KeySetViewIterator;
+
+/**
+ * @brief A view on all keys below (or same as) a key.
+ *
+ * Contains the keys ks.cut(root) would return, but
+ * without copying or modifying the keyset.
+ * Creating the view needs two binary searches.
+ *
+ * The view does not own the keyset, it gets invalid
+ * when the keyset is modified or destroyed.
+ *
+ * @code
+KeySetView view (ks, root);
+for (Key k : view)
+{
+	std::cout << k.getName () << std::endl;
+}
+ * @endcode
+ *
+ * \note a cascading root leads to an empty view,
+ * use one view per namespace instead.
+ */
+class KeySetView
+{
+public:
+	inline KeySetView (KeySet const & ks, Key const & root);
+
+	inline size_t size () const;
+	inline Key at (size_t pos) const;
+
+	inline Key lookup (Key const & k) const;
+	inline Key lookup (std::string const & name) const;
+
+	typedef KeySetViewIterator iterator;
+	typedef KeySetViewIterator const_iterator;
+
+	inline iterator begin () const;
+	inline iterator end () const;
+
+private:
+	ckdb::ElektraKeySetView view; ///< the range within the keyset
+};
+
+/**
+ * For C++ forward iteration over KeySetViews.
+ */
+class KeySetViewIterator
+{
+public:
+	typedef Key value_type;
+	typedef ssize_t difference_type;
+	typedef Key pointer;
+	typedef Key reference;
+	typedef std::forward_iterator_tag iterator_category;
+
+	KeySetViewIterator (KeySetView const & v, size_t c) : view (&v), current (c)
+	{
+	}
+
+	reference operator* () const
+	{
+		return view->at (current);
+	}
+	pointer operator-> () const
+	{
+		return view->at (current);
+	}
+	KeySetViewIterator & operator++ ()
+	{
+		++current;
+		return *this;
+	}
+	KeySetViewIterator operator++ (int)
+	{
+		return KeySetViewIterator (*view, current++);
+	}
+
+	bool operator== (KeySetViewIterator const & other) const
+	{
+		return view == other.view && current == other.current;
+	}
+	bool operator!= (KeySetViewIterator const & other) const
+	{
+		return !(*this == other);
+	}
+
+private:
+	KeySetView const * view;
+	size_t current;
+};
+
+/**
+ * @copydoc elektraKsView()
+ */
+inline KeySetView::KeySetView (KeySet const & ks, Key const & root)
+{
+	if (ckdb::elektraKsView (ks.getKeySet (), root.getKey (), &view) == -1)
+	{
+		view.ks = ks.getKeySet ();
+		view.begin = view.end = 0;
+	}
+}
+
+/**
+ * @copydoc elektraKsViewSize()
+ */
+inline size_t KeySetView::size () const
+{
+	return ckdb::elektraKsViewSize (&view);
+}
+
+/**
+ * @copydoc elektraKsViewAt()
+ */
+inline Key KeySetView::at (size_t pos) const
+{
+	return Key (ckdb::elektraKsViewAt (&view, pos));
+}
+
+/**
+ * @copydoc elektraKsViewLookup()
+ */
+inline Key KeySetView::lookup (Key const & k) const
+{
+	return Key (ckdb::elektraKsViewLookup (&view, k.getKey ()));
+}
+
+/**
+ * @copydoc elektraKsViewLookupByName()
+ */
+inline Key KeySetView::lookup (std::string const & name) const
+{
+	return Key (ckdb::elektraKsViewLookupByName (&view, name.c_str ()));
+}
+
+inline KeySetView::iterator KeySetView::begin () const
+{
+	return KeySetViewIterator (*this, 0);
+}
+
+inline KeySetView::iterator KeySetView::end () const
+{
+	return KeySetViewIterator (*this, size ());
+}
+}
+
+#endif
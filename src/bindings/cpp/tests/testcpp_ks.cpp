@@ -8,6 +8,8 @@
 
 #include <tests.hpp>
 
+#include <keysetview.hpp>
+
 #include <memory>
 
 #include <algorithm>
@@ -820,3 +822,35 @@ TEST (ks, vaargs)
 	succeed_if (ks.lookup ("user/a"), "could not find key");
 	succeed_if (ks.lookup ("user/b"), "could not find key");
 }
+
+TEST (ks, view)
+{
+	KeySet ks (20, *Key ("user/a", KEY_END), *Key ("user/b", KEY_END), *Key ("user/b/x", KEY_END), *Key ("user/b/y/z", KEY_END),
+		   *Key ("user/ba", KEY_END), *Key ("user/c", KEY_END), KS_END);
+
+	KeySetView view (ks, Key ("user/b", KEY_END));
+	ASSERT_EQ (view.size (), 3);
+	std::vector<std::string> names;
+	for (Key k : view)
+	{
+		names.push_back (k.getName ());
+	}
+	ASSERT_EQ (names.size (), 3);
+	EXPECT_EQ (names[0], "user/b");
+	EXPECT_EQ (names[1], "user/b/x");
+	EXPECT_EQ (names[2], "user/b/y/z");
+
+	EXPECT_EQ (view.at (1).getName (), "user/b/x");
+	EXPECT_FALSE (view.at (3));
+	EXPECT_TRUE (view.lookup ("user/b/y/z"));
+	EXPECT_FALSE (view.lookup ("user/c"));
+	EXPECT_FALSE (view.lookup ("user/ba"));
+	EXPECT_EQ (ks.size (), 6) << "view must not modify the keyset";
+
+	KeySetView empty (ks, Key ("user/d", KEY_END));
+	EXPECT_EQ (empty.size (), 0);
+	EXPECT_TRUE (empty.begin () == empty.end ());
+
+	KeySetView cascading (ks, Key ("/b", KEY_END));
+	EXPECT_EQ (cascading.size (), 0);
+}
@@ -112,6 +112,16 @@ KeySet * elektraPluginGetConfig (Plugin * handle);
 void elektraPluginSetData (Plugin * plugin, void * handle);
 void * elektraPluginGetData (Plugin * plugin);
 
+typedef struct _ElektraArena ElektraArena;
+
+ElektraArena * elektraArenaNew (size_t chunkSize);
+Key * elektraArenaKeyNew (ElektraArena * arena, const char * name, ...);
+Key * elektraArenaKeyDup (ElektraArena * arena, const Key * source);
+int elektraArenaAdopt (ElektraArena * arena, void * memory, size_t size, void (*release) (void * memory, size_t size));
+Key * elektraArenaKeyView (ElektraArena * arena, const char * name, size_t nameSize, size_t unescapedSize, const void * value,
+			   size_t valueSize);
+void elektraArenaDel (ElektraArena * arena);
+
 
 #define PLUGINVERSION "1"
 
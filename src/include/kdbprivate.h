@@ -24,6 +24,21 @@
     it says how much can actually be stored.*/
 #define KEYSET_SIZE 16
 
+/** How many bytes of a value can be stored within a new key
+    without an extra allocation. */
+#define KEY_INLINE_VALUE_SIZE 32
+
+/** How many bytes of a name (escaped and unescaped) can be stored
+    within a key created without name (e.g. meta keys). */
+#define KEY_INLINE_NAME_SIZE 32
+
+/** Maximum size of the buffer stored within a key. Longer names
+    and values are allocated separately. */
+#define KEY_INLINE_MAX_SIZE 512
+
+/** Alignment of values stored within a key (and of keys within an arena). */
+#define KEY_INLINE_ALIGN (2 * sizeof (void *))
+
 /** How many plugins can exist in an backend. */
 #define NR_OF_PLUGINS 10
 
@@ -39,6 +54,9 @@
 /** Trie optimization */
 #define APPROXIMATE_NR_OF_BACKENDS 16
 
+/** Children a trie node can have without an index */
+#define ELEKTRA_TRIE_SMALL 16
+
 /**The maximum of how many characters an integer
   needs as decimal number.*/
 #define MAX_LEN_INT 31
@@ -150,11 +168,16 @@ typedef enum {
  * @ingroup backend
  */
 typedef enum {
-	KS_FLAG_SYNC = 1 /*!<
+	KS_FLAG_SYNC = 1, /*!<
 		 KeySet need sync.
 		 If keys were popped from the Keyset
 		 this flag will be set, so that the backend will sync
 		 the keys to database.*/
+	KS_FLAG_HASH_INDEX = 1 << 1 /*!<
+		 Lookups should use a hash index.
+		 The index is built lazily on the first lookup
+		 and dropped whenever keys change their position.
+		 @see elektraKsHashIndex() */
 } ksflag_t;
 
 
@@ -213,6 +236,14 @@ struct _Key
 	 */
 	keyflag_t flags;
 
+	/**
+	 * Size of the buffer directly after the key structure
+	 * which can hold the name and a short value.
+	 * Name and value stored there must not be freed.
+	 * @see elektraKeyIsInline()
+	 */
+	unsigned int inlineSize;
+
 	/**
 	 * In how many keysets the key resists.
 	 * keySetName() is only allowed if ksReference is 0.
@@ -224,6 +255,29 @@ struct _Key
 	 * All the key's meta information.
 	 */
 	KeySet * meta;
+
+	/**
+	 * Cached value of the meta data "owner" (or NULL), points
+	 * into the value of the meta key.
+	 * Used when sorting keys, so that comparing keys with the
+	 * same name does not need a meta data lookup.
+	 * @see elektraKeyUpdateOwner()
+	 */
+	const char * owner;
+
+	/**
+	 * The arena the key was allocated from, or NULL
+	 * if the key was allocated on its own.
+	 * @see elektraArenaNew()
+	 */
+	ElektraArena * arena;
+
+	/**
+	 * Where changes of the key are recorded, or NULL
+	 * if no key set tracks the key.
+	 * @see elektraKsTrack()
+	 */
+	struct _KeySetChanges * changes;
 };
 
 
@@ -254,8 +308,46 @@ struct _KeySet
 	 * Some control and internal flags.
 	 */
 	ksflag_t flags;
+
+	/**
+	 * Hash index over the unescaped key names.
+	 * Only used if #KS_FLAG_HASH_INDEX is set, 0 otherwise.
+	 */
+	struct _KeySetIndex * index;
+
+	/**
+	 * Ring of key sets sharing the same array (see ksDup()),
+	 * both are 0 if the array is not shared.
+	 * The array is copied before it gets modified.
+	 * @see elektraKsUnshare()
+	 */
+	struct _KeySet * sharedPrev;
+	struct _KeySet * sharedNext;
+
+	/**
+	 * The keys changed, added or removed since kdbGet(),
+	 * 0 if the key set is not tracked.
+	 * @see elektraKsTrack()
+	 */
+	struct _KeySetChanges * changes;
 };
 
+/**
+ * The names of the keys changed since a key set is tracked.
+ *
+ * Shared by the tracked key set and its keys,
+ * freed together with the last of them.
+ *
+ * @see elektraKsTrack()
+ * @ingroup backend
+ */
+typedef struct _KeySetChanges
+{
+	size_t references; /*!< number of keys and key sets referring to it */
+	int complete;      /*!< 0 if changes might not have been recorded */
+	KeySet * names;    /*!< a key without value for every changed name */
+} KeySetChanges;
+
 
 /**
  * Helper for identifying global plugin positions
@@ -305,6 +397,15 @@ struct _KDB
 	Backend * initBackend; /*!< The init backend for bootstrapping.*/
 
 	Plugin * globalPlugins[NR_GLOBAL_PLUGINS];
+
+	size_t threads; /*!< How many threads kdbGet() may use to run backends in parallel
+			(from system/elektra/threads, 0 or 1 to run them sequentially).*/
+
+	char * cache; /*!< The directory where kdbGet() caches the keys parsed by storage plugins
+			(from system/elektra/cache) or NULL if there is no cache.*/
+
+	int cacheBootstrap; /*!< While bootstrapping: the cache is only written if the keys
+			contain system/elektra/cache, i.e. the user opted in to caching.*/
 };
 
 
@@ -356,6 +457,13 @@ struct _Backend
 	   More than three is not possible, because a backend
 	   can be only mounted in dir, system and user each once
 	   OR only in spec.*/
+
+	KeySet * config; /*!< The configuration of a backend whose plugins
+	   are not opened yet, NULL otherwise.
+	   @see elektraBackendOpenLazy(), elektraBackendLoad() */
+
+	KeySet * modules; /*!< The modules to open the plugins with,
+	   only set together with config. */
 };
 
 /**
@@ -393,6 +501,12 @@ struct _Plugin
 
 	void * data; /*!< This handle can be used for a plugin to store
      any data its want to. */
+
+	int threadsafe; /*!< Cached contract clause infos/threadsafe:
+     0 not yet asked, 1 may run in parallel, -1 must not. */
+
+	int cacheable; /*!< Cached contract clause infos/cacheable:
+     0 not yet asked, 1 kdbGet() may be replaced by the cache, -1 must not. */
 };
 
 
@@ -402,14 +516,22 @@ struct _Plugin
  * fast. This is exactly what needs to be done when using kdbGet() and kdbSet()
  * in a hierarchy where backends are mounted - you need the backend mounted
  * closest to the parentKey.
+ *
+ * The trie is a radix tree: every node stands for a part of a name
+ * (the text) and only has as many children as different characters
+ * follow its text. Nodes with few children find them by comparing
+ * their first characters, nodes with many children use an index.
  */
 struct _Trie
 {
-	struct _Trie * children[KDB_MAX_UCHAR]; /*!< The children building up the trie recursively */
-	char * text[KDB_MAX_UCHAR];		/*!< Text identifying this node */
-	size_t textlen[KDB_MAX_UCHAR];		/*!< Length of the text */
-	Backend * value[KDB_MAX_UCHAR];		/*!< Pointer to a backend */
-	Backend * empty_value;			/*!< Pointer to a backend for the empty string "" */
+	Backend * value;			 /*!< Pointer to a backend mounted at the name ending with this node */
+	struct _Trie ** children;		 /*!< The children building up the trie recursively */
+	unsigned short * index;			 /*!< Position + 1 of the child per character, only for many children */
+	unsigned char first[ELEKTRA_TRIE_SMALL]; /*!< First character of every child, only for few children */
+	size_t size;				 /*!< Number of children */
+	size_t alloc;				 /*!< Allocated number of children */
+	size_t textlen;				 /*!< Length of the text */
+	char * text;				 /*!< Text identifying this node, allocated together with the node */
 };
 
 typedef enum {
@@ -475,13 +597,17 @@ int elektraSplitMerge (Split * split, KeySet * dest);
 /* for kdbSet() algorithm */
 int elektraSplitCheckSize (Split * split);
 int elektraSplitDivide (Split * split, KDB * handle, KeySet * ks);
+int elektraSplitDivideChanges (Split * split, KDB * handle, KeySet * ks, KeySet * changes, Key ** errorKey);
 int elektraSplitSync (Split * split);
+int elektraSplitSyncState (Split * split);
 void elektraSplitPrepare (Split * split);
 int elektraSplitUpdateSize (Split * split);
 
 
 /*Backend handling*/
 Backend * elektraBackendOpen (KeySet * elektra_config, KeySet * modules, Key * errorKey);
+Backend * elektraBackendOpenLazy (KeySet * elektra_config, KeySet * modules, Key * errorKey);
+int elektraBackendLoad (Backend * backend, Key * errorKey);
 Backend * elektraBackendOpenMissing (Key * mountpoint);
 Backend * elektraBackendOpenDefault (KeySet * modules, const char * file, Key * errorKey);
 Backend * elektraBackendOpenModules (KeySet * modules, Key * errorKey);
@@ -498,6 +624,8 @@ int elektraProcessPlugins (Plugin ** plugins, KeySet * modules, KeySet * referen
 Plugin * elektraPluginOpen (const char * backendname, KeySet * modules, KeySet * config, Key * errorKey);
 int elektraPluginClose (Plugin * handle, Key * errorKey);
 Plugin * elektraPluginMissing (void);
+int elektraPluginThreadSafe (Plugin * handle);
+int elektraPluginCacheable (Plugin * handle);
 Plugin * elektraPluginVersion (void);
 
 /*Trie handling*/
@@ -506,8 +634,13 @@ int elektraTrieClose (Trie * trie, Key * errorKey);
 Backend * elektraTrieLookup (Trie * trie, const Key * key);
 Trie * elektraTrieInsert (Trie * trie, const char * name, Backend * value);
 
+/*Cache of the keys storage plugins parsed*/
+int elektraCacheGet (const char * dir, Backend * backend, Key * parentKey, KeySet * returned);
+int elektraCacheSet (const char * dir, Backend * backend, Key * parentKey, KeySet * returned);
+
 /*Mounting handling */
 int elektraMountOpen (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey);
+int elektraMountOpenLazy (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey);
 int elektraMountDefault (KDB * kdb, KeySet * modules, int inFallback, Key * errorKey);
 int elektraMountModules (KDB * kdb, KeySet * modules, Key * errorKey);
 int elektraMountVersion (KDB * kdb, Key * errorKey);
@@ -521,6 +654,20 @@ int keyInit (Key * key);
 void keyVInit (Key * key, const char * keyname, va_list ap);
 
 int keyClearSync (Key * key);
+void elektraKeyUpdateOwner (Key * key);
+
+int elektraKeyIsInline (const Key * key, const void * buffer);
+int elektraKeyIsBorrowed (const Key * key, const void * buffer);
+char * elektraKeyInlineValue (Key * key, size_t size);
+int elektraKeyReserveName (Key * key, size_t size, size_t keep);
+Key * elektraKeyVNewIn (ElektraArena * arena, const char * name, va_list va);
+Key * elektraKeyDupIn (ElektraArena * arena, const Key * source);
+Key * elektraKeyViewIn (ElektraArena * arena, const char * name, size_t nameSize, size_t unescapedSize, const void * value,
+			size_t valueSize);
+
+void * elektraArenaAlloc (ElektraArena * arena, size_t size);
+void elektraArenaRelease (ElektraArena * arena);
+int elektraArenaIsAdopted (const ElektraArena * arena, const void * buffer);
 
 /*Private helper for keyset*/
 int ksInit (KeySet * ks);
@@ -537,6 +684,25 @@ int elektraKeyLock (Key * key, enum elektraLockOptions what);
 
 ssize_t ksSearchInternal (const KeySet * ks, const Key * toAppend);
 
+/*Hash index for keysets*/
+ssize_t elektraKsIndexLookup (KeySet * ks, const Key * key);
+int elektraKsIndexLookupCascading (KeySet * ks, const Key * key, const char * const * namespaces, ssize_t * positions);
+void elektraKsIndexAppend (KeySet * ks, size_t pos);
+void elektraKsIndexInvalidate (KeySet * ks);
+void elektraKsIndexDel (KeySet * ks);
+
+int elektraKsUnshare (KeySet * ks);
+size_t elektraKsSortUnique (Key ** array, size_t size);
+
+/*Tracking of changed keys*/
+void elektraKeyChanged (Key * key);
+int elektraKsTrack (KeySet * ks);
+KeySetChanges * elektraKsUntrack (KeySet * ks);
+KeySet * elektraKsChanges (const KeySet * ks);
+void elektraKsChangesAdd (KeySetChanges * changes, const Key * key);
+void elektraKsChangesAttach (KeySetChanges * changes, Key * key);
+void elektraKsChangesRelease (KeySetChanges * changes);
+
 /*Used for internal memcpy/memmove*/
 ssize_t elektraMemcpy (Key ** array1, Key ** array2, size_t size);
 ssize_t elektraMemmove (Key ** array1, Key ** array2, size_t size);
@@ -63,9 +63,42 @@ ssize_t elektraKeySetName (Key * key, const char * newName, option_t options);
 
 KeySet * elektraKeyGetMetaKeySet (const Key * key);
 
+Key * keyMetaAtom (const char * metaName);
+const Key * keyGetMetaAtom (const Key * key, const Key * atom);
+
+int elektraKsHashIndex (KeySet * ks, int enable);
+
 Key * ksPrev (KeySet * ks);
 Key * ksPopAtCursor (KeySet * ks, cursor_t c);
 
+/**
+ * @brief Non-owning view on the keys below a key
+ *
+ * @see elektraKsView()
+ * @ingroup proposal
+ */
+typedef struct
+{
+	KeySet * ks;  ///< the viewed key set
+	size_t begin; ///< position of the first key within the view
+	size_t end;   ///< position after the last key within the view
+} ElektraKeySetView;
+
+int elektraKsView (KeySet * ks, const Key * root, ElektraKeySetView * view);
+size_t elektraKsViewSize (const ElektraKeySetView * view);
+Key * elektraKsViewAt (const ElektraKeySetView * view, size_t pos);
+Key * elektraKsViewLookup (const ElektraKeySetView * view, const Key * key);
+Key * elektraKsViewLookupByName (const ElektraKeySetView * view, const char * name);
+
+typedef struct _ElektraKsBuilder ElektraKsBuilder;
+
+ElektraKsBuilder * elektraKsBuilderNew (size_t alloc);
+ssize_t elektraKsBuilderAdd (ElektraKsBuilder * builder, Key * toAdd);
+ssize_t elektraKsBuilderFinish (ElektraKsBuilder * builder, KeySet * ks);
+void elektraKsBuilderDel (ElektraKsBuilder * builder);
+
+int elektraKdbPrewarm (KDB * handle, Key * parentKey);
+
 #ifdef __cplusplus
 }
 }
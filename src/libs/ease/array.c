@@ -11,6 +11,7 @@
 #include <kdb.h>
 #include <kdbease.h>
 #include <kdbhelper.h>
+#include <kdbproposal.h>
 #include <kdbtypes.h>
 
 #include <ctype.h>
@@ -220,8 +221,22 @@ KeySet * elektraArrayGet (const Key * arrayParent, KeySet * keys)
 
 	if (!keys) return 0;
 
-	KeySet * arrayKeys = ksNew (ksGetSize (keys), KS_END);
-	elektraKsFilter (arrayKeys, keys, &arrayFilter, (void *)arrayParent);
+	ElektraKeySetView view;
+	if (elektraKsView (keys, arrayParent, &view) == -1)
+	{
+		// cascading parent: the array elements may be in every namespace
+		KeySet * arrayKeys = ksNew (ksGetSize (keys), KS_END);
+		elektraKsFilter (arrayKeys, keys, &arrayFilter, (void *)arrayParent);
+		return arrayKeys;
+	}
+
+	// only the keys below the parent need to be checked
+	KeySet * arrayKeys = ksNew (elektraKsViewSize (&view), KS_END);
+	for (size_t i = 0; i < elektraKsViewSize (&view); ++i)
+	{
+		Key * cur = elektraKsViewAt (&view, i);
+		if (arrayFilter (cur, (void *)arrayParent)) ksAppendKey (arrayKeys, keyDup (cur));
+	}
 	return arrayKeys;
 }
 
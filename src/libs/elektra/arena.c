@@ -0,0 +1,375 @@
+/**
+ * @file
+ *
+ * @brief Arena allocator for keys created by storage plugins.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#include "kdbinternal.h"
+
+/** Size of a chunk if 0 is passed to elektraArenaNew() */
+#define ELEKTRA_ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+/** Smallest size of a chunk */
+#define ELEKTRA_ARENA_MIN_CHUNK_SIZE 1024
+
+/**
+ * @internal
+ *
+ * Header of a chunk, the memory handed out follows directly.
+ * The padding keeps the memory after the header aligned.
+ */
+typedef union _ElektraArenaChunk {
+	union _ElektraArenaChunk * next;
+	char padding[KEY_INLINE_ALIGN];
+} ElektraArenaChunk;
+
+/**
+ * @internal
+ *
+ * A bump allocator for keys.
+ *
+ * The arena stays alive as long as its owner did not call
+ * elektraArenaDel() or any key allocated from it still exists.
+ * Then all chunks are freed at once.
+ */
+struct _ElektraArena
+{
+	ElektraArenaChunk * chunks; /*!< list of chunks, the first one is used for allocations */
+	char * pos;		    /*!< next free byte in the first chunk */
+	char * end;		    /*!< end of the first chunk */
+	size_t chunkSize;	   /*!< usable size of a regular chunk */
+	size_t references;	  /*!< the owner plus every key allocated from the arena, changed atomically */
+	char * adopted;		    /*!< memory adopted with elektraArenaAdopt(), or 0 */
+	size_t adoptedSize;	 /*!< size of the adopted memory */
+	void (*release) (void * memory, size_t size); /*!< frees the adopted memory */
+};
+
+/**
+ * @internal
+ *
+ * Allocate a new chunk and link it into the arena.
+ *
+ * @param arena the arena to add the chunk to
+ * @param size usable size of the chunk
+ * @param current if the chunk should be used for subsequent allocations
+ *
+ * @return the usable memory of the chunk
+ * @retval 0 on memory error
+ */
+static char * elektraArenaAddChunk (ElektraArena * arena, size_t size, int current)
+{
+	ElektraArenaChunk * chunk = elektraMalloc (sizeof (ElektraArenaChunk) + size);
+	if (!chunk) return 0;
+
+	char * memory = (char *)(chunk + 1);
+	if (current || !arena->chunks)
+	{
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		if (current)
+		{
+			arena->pos = memory;
+			arena->end = memory + size;
+		}
+	}
+	else
+	{
+		// keep the current chunk at the front
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+	}
+
+	return memory;
+}
+
+/**
+ * @internal
+ *
+ * Free all chunks and the arena itself.
+ */
+static void elektraArenaFree (ElektraArena * arena)
+{
+	ElektraArenaChunk * chunk = arena->chunks;
+	while (chunk)
+	{
+		ElektraArenaChunk * next = chunk->next;
+		elektraFree (chunk);
+		chunk = next;
+	}
+	if (arena->release) arena->release (arena->adopted, arena->adoptedSize);
+	elektraFree (arena);
+}
+
+/**
+ * @internal
+ *
+ * Allocate memory for one key from the arena.
+ *
+ * Every successful allocation holds a reference to the arena,
+ * which needs to be given back with elektraArenaRelease().
+ *
+ * @param arena the arena to allocate from
+ * @param size the number of bytes needed
+ *
+ * @return memory aligned like malloc() would align it
+ * @retval 0 on memory error
+ */
+void * elektraArenaAlloc (ElektraArena * arena, size_t size)
+{
+	size = (size + KEY_INLINE_ALIGN - 1) / KEY_INLINE_ALIGN * KEY_INLINE_ALIGN;
+
+	char * memory = 0;
+	if (size <= (size_t) (arena->end - arena->pos))
+	{
+		memory = arena->pos;
+		arena->pos += size;
+	}
+	else if (size > arena->chunkSize / 4)
+	{
+		// would waste too much of a regular chunk
+		memory = elektraArenaAddChunk (arena, size, 0);
+	}
+	else
+	{
+		memory = elektraArenaAddChunk (arena, arena->chunkSize, 1);
+		if (memory) arena->pos += size;
+	}
+
+	if (memory) __atomic_add_fetch (&arena->references, 1, __ATOMIC_RELAXED);
+	return memory;
+}
+
+/**
+ * @internal
+ *
+ * Give back one reference to the arena.
+ *
+ * Called by keyDel() for keys allocated from the arena.
+ * The memory of all keys is freed with the last reference.
+ * Keys of one arena may be deleted in different threads, so
+ * the counter is decremented atomically.
+ */
+void elektraArenaRelease (ElektraArena * arena)
+{
+	if (__atomic_sub_fetch (&arena->references, 1, __ATOMIC_ACQ_REL) == 0) elektraArenaFree (arena);
+}
+
+/**
+ * @internal
+ *
+ * Check if @p buffer is within the memory adopted by the arena.
+ *
+ * @retval 1 if @p buffer is within the adopted memory
+ * @retval 0 otherwise (or if nothing was adopted)
+ * @see elektraKeyIsBorrowed()
+ */
+int elektraArenaIsAdopted (const ElektraArena * arena, const void * buffer)
+{
+	const char * begin = arena->adopted;
+	return begin && (const char *)buffer >= begin && (const char *)buffer < begin + arena->adoptedSize;
+}
+
+/**
+ * @internal
+ *
+ * Check a name in adopted memory like keySetName() would compute it.
+ *
+ * @param name the escaped name directly followed by the unescaped name
+ * @param nameSize the size of the escaped name
+ * @param unescapedSize the size of the unescaped name
+ *
+ * @retval 1 if the escaped name is valid and the unescaped name was
+ *         derived from it
+ * @retval 0 otherwise
+ * @retval -1 on memory error
+ */
+static int elektraArenaValidName (const char * name, size_t nameSize, size_t unescapedSize)
+{
+	// the escaped name has no null within and unescaping adds at most one byte
+	if (memchr (name, '\0', nameSize) != name + nameSize - 1) return 0;
+	if (unescapedSize > nameSize + 1 || !elektraValidateKeyName (name, nameSize)) return 0;
+
+	char buffer[256];
+	char * unescaped = nameSize + 1 <= sizeof (buffer) ? buffer : elektraMalloc (nameSize + 1);
+	if (!unescaped) return -1;
+
+	int valid = elektraUnescapeKeyName (name, unescaped) == unescapedSize && !memcmp (unescaped, name + nameSize, unescapedSize);
+	if (unescaped != buffer) elektraFree (unescaped);
+	return valid;
+}
+
+/**
+ * @brief Create a new arena to allocate keys from.
+ *
+ * Storage plugins which create many keys at once (e.g. while
+ * parsing a configuration file) can allocate them from an arena.
+ * Such keys are used like any other key, but instead of one
+ * allocation per key only one allocation per chunk is done.
+ * When all keys and the arena itself are deleted, the memory is
+ * freed chunk by chunk, not key by key.
+ *
+ * Keys may be appended to other key sets or be referenced
+ * otherwise. The arena (and thus all its chunks and the memory
+ * adopted with elektraArenaAdopt()) is kept alive until the last
+ * key allocated from it is deleted: a single surviving key pins
+ * the memory of all keys. So only use an arena for keys which
+ * share their lifetime, e.g. the keys returned by a single
+ * kdbGet() of a storage plugin.
+ *
+ * Creating keys within an arena is not thread-safe. Keys of the
+ * arena may be used and deleted in different threads afterwards,
+ * like keys allocated with keyNew().
+ *
+ * @param chunkSize the size of the chunks to allocate, 0 for a default
+ *
+ * @return the new arena
+ * @retval 0 on memory error
+ * @see elektraArenaKeyNew(), elektraArenaKeyDup(), elektraArenaDel()
+ */
+ElektraArena * elektraArenaNew (size_t chunkSize)
+{
+	ElektraArena * arena = elektraCalloc (sizeof (ElektraArena));
+	if (!arena) return 0;
+
+	if (chunkSize == 0) chunkSize = ELEKTRA_ARENA_DEFAULT_CHUNK_SIZE;
+	if (chunkSize < ELEKTRA_ARENA_MIN_CHUNK_SIZE) chunkSize = ELEKTRA_ARENA_MIN_CHUNK_SIZE;
+	arena->chunkSize = chunkSize;
+	arena->references = 1;
+
+	return arena;
+}
+
+/**
+ * @brief Give up the ownership of an arena.
+ *
+ * No keys can be created from the arena afterwards.
+ * Keys created from the arena are not affected, the memory
+ * is freed as soon as the last of them is deleted.
+ *
+ * @param arena the arena to delete (may be NULL)
+ */
+void elektraArenaDel (ElektraArena * arena)
+{
+	if (!arena) return;
+	elektraArenaRelease (arena);
+}
+
+/**
+ * @brief Create a key within an arena.
+ *
+ * Same as keyNew(), but the key is allocated from @p arena.
+ *
+ * @param arena the arena to allocate the key from, if NULL
+ *        the key is allocated like keyNew() does
+ * @param name the name of the key (or NULL) followed by keyNew() arguments
+ *
+ * @return the new key
+ * @retval 0 on memory error
+ * @see keyNew()
+ */
+Key * elektraArenaKeyNew (ElektraArena * arena, const char * name, ...)
+{
+	va_list va;
+	va_start (va, name);
+	Key * key = elektraKeyVNewIn (arena, name, va);
+	va_end (va);
+
+	return key;
+}
+
+/**
+ * @brief Duplicate a key into an arena.
+ *
+ * Same as keyDup(), but the key is allocated from @p arena.
+ * The key gets some extra room for its name, because parsers
+ * usually dup a parent key and append to its name.
+ *
+ * @param arena the arena to allocate the key from, if NULL
+ *        the key is allocated like keyDup() does
+ * @param source the key to duplicate
+ *
+ * @return the duplicated key
+ * @retval 0 on memory error or NULL source
+ * @see keyDup()
+ */
+Key * elektraArenaKeyDup (ElektraArena * arena, const Key * source)
+{
+	return elektraKeyDupIn (arena, source);
+}
+
+/**
+ * @brief Let the arena take over memory, e.g. a mapped file.
+ *
+ * Keys created with elektraArenaKeyView() may use names and values
+ * within the adopted memory without copying them. Such names and
+ * values are never freed or modified by the keys: when a key gets
+ * a new name or value, it allocates its own memory instead
+ * (copy-on-write).
+ *
+ * The memory is released together with the arena, i.e. after
+ * elektraArenaDel() was called and the last key of the arena
+ * was deleted. Only one block of memory can be adopted.
+ *
+ * @param arena the arena to pass the memory to
+ * @param memory the memory to adopt
+ * @param size the size of @p memory
+ * @param release called with @p memory and @p size to free it, may be NULL
+ *
+ * @retval 0 on success
+ * @retval -1 on NULL pointers or if the arena already adopted memory
+ * @see elektraArenaKeyView()
+ */
+int elektraArenaAdopt (ElektraArena * arena, void * memory, size_t size, void (*release) (void * memory, size_t size))
+{
+	if (!arena || !memory) return -1;
+	if (arena->adopted) return -1;
+
+	arena->adopted = memory;
+	arena->adoptedSize = size;
+	arena->release = release;
+	return 0;
+}
+
+/**
+ * @brief Create a key viewing its name and value in adopted memory.
+ *
+ * The name consists of the escaped name (with its terminating
+ * null) directly followed by the unescaped name, as returned by
+ * keyName() and keyUnescapedName(). The memory may come from an
+ * untrusted file, so the unescaped name is computed again and
+ * compared with the stored one. Only the validation allocates,
+ * and only for names longer than 255 bytes.
+ *
+ * @param arena the arena which adopted the memory with the name and value
+ * @param name the escaped and unescaped name of the key
+ * @param nameSize the size of the escaped name, see keyGetNameSize()
+ * @param unescapedSize the size of the unescaped name, see keyGetUnescapedNameSize()
+ * @param value the value of the key, see keyValue()
+ * @param valueSize the size of the value, 0 for a key without value
+ *
+ * @return the new key
+ * @retval 0 on memory error, if the name is invalid or if name
+ *         or value are not within adopted memory
+ * @see elektraArenaAdopt()
+ */
+Key * elektraArenaKeyView (ElektraArena * arena, const char * name, size_t nameSize, size_t unescapedSize, const void * value,
+			   size_t valueSize)
+{
+	if (!arena || !arena->adopted || !name) return 0;
+
+	const char * end = arena->adopted + arena->adoptedSize;
+	if (!elektraArenaIsAdopted (arena, name)) return 0;
+	if (nameSize < 2 || unescapedSize < 2 || nameSize + unescapedSize > (size_t) (end - name)) return 0;
+	if (name[nameSize - 1] != '\0' || name[nameSize + unescapedSize - 1] != '\0') return 0;
+
+	if (valueSize && (!elektraArenaIsAdopted (arena, value) || valueSize > (size_t) (end - (const char *)value))) return 0;
+	if (elektraArenaValidName (name, nameSize, unescapedSize) != 1) return 0;
+
+	return elektraKeyViewIn (arena, name, nameSize, unescapedSize, value, valueSize);
+}
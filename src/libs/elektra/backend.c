@@ -103,58 +103,29 @@ int elektraBackendSetMountpoint (Backend * backend, KeySet * elektraConfig, Key
 }
 
 
-/**Builds a backend out of the configuration supplied
- * from:
- *
-@verbatim
-system/elektra/mountpoints/<name>
-@endverbatim
- *
- * The root key must be like the above example. You do
- * not need to rewind the keyset. But every key must be
- * below the root key.
- *
- * The internal consistency will be checked in this
- * function. If necessary parts are missing, like
- * no plugins, they cant be loaded or similar 0
- * will be returned.
- *
- * ksCut() is perfectly suitable for cutting out the
- * configuration like needed.
- *
- * @note The given KeySet will be deleted within the function,
- * don't use it afterwards.
+/**
+ * @brief Opens the plugins of a backend
  *
- * @param elektraConfig the configuration to work with.
- *        It is used to build up this backend.
+ * @param backend the backend to add the plugins to
+ * @param elektraConfig the configuration below system/elektra/mountpoints/<name>
+ *        (the parts for the plugins are cut out)
  * @param modules used to load new modules or get references
  *        to existing one
- * @param errorKey the key where an error and warnings are added
+ * @param failure if a failure already occurred (suppresses further warnings)
+ * @param errorKey the key where warnings are added
  *
- * @return a pointer to a freshly allocated backend
- *         this could be the requested backend or a so called
- *         "missing backend".
- * @retval 0 if out of memory
- * @ingroup backend
+ * @retval 1 if something failed
+ * @retval 0 on success
  */
-Backend * elektraBackendOpen (KeySet * elektraConfig, KeySet * modules, Key * errorKey)
+static int elektraBackendOpenPlugins (Backend * backend, KeySet * elektraConfig, KeySet * modules, int failure, Key * errorKey)
 {
 	Key * cur;
-	KeySet * referencePlugins = 0;
+	KeySet * referencePlugins = ksNew (0, KS_END);
 	KeySet * systemConfig = 0;
-	int failure = 0;
 
-	referencePlugins = ksNew (0, KS_END);
 	ksRewind (elektraConfig);
-
 	Key * root = ksNext (elektraConfig);
 
-	Backend * backend = elektraBackendAllocate ();
-	if (elektraBackendSetMountpoint (backend, elektraConfig, errorKey) == -1)
-	{ // warning already set
-		failure = 1;
-	}
-
 	while ((cur = ksNext (elektraConfig)) != 0)
 	{
 		if (keyRel (root, cur) == 1)
@@ -207,6 +178,90 @@ Backend * elektraBackendOpen (KeySet * elektraConfig, KeySet * modules, Key * er
 		}
 	}
 
+	ksDel (systemConfig);
+	ksDel (referencePlugins);
+
+	return failure;
+}
+
+/**
+ * @brief Closes all plugins of a backend
+ *
+ * @retval -1 if closing a plugin failed
+ * @retval 0 on success
+ */
+static int elektraBackendClosePlugins (Backend * backend, Key * errorKey)
+{
+	int ret = 0;
+	int errorOccurred = 0;
+
+	for (int i = 0; i < NR_OF_PLUGINS; ++i)
+	{
+		ret = elektraPluginClose (backend->setplugins[i], errorKey);
+		if (ret == -1) ++errorOccurred;
+		backend->setplugins[i] = 0;
+
+		ret = elektraPluginClose (backend->getplugins[i], errorKey);
+		if (ret == -1) ++errorOccurred;
+		backend->getplugins[i] = 0;
+
+		ret = elektraPluginClose (backend->errorplugins[i], errorKey);
+		if (ret == -1) ++errorOccurred;
+		backend->errorplugins[i] = 0;
+	}
+
+	return errorOccurred ? -1 : 0;
+}
+
+/**Builds a backend out of the configuration supplied
+ * from:
+ *
+@verbatim
+system/elektra/mountpoints/<name>
+@endverbatim
+ *
+ * The root key must be like the above example. You do
+ * not need to rewind the keyset. But every key must be
+ * below the root key.
+ *
+ * The internal consistency will be checked in this
+ * function. If necessary parts are missing, like
+ * no plugins, they cant be loaded or similar 0
+ * will be returned.
+ *
+ * ksCut() is perfectly suitable for cutting out the
+ * configuration like needed.
+ *
+ * @note The given KeySet will be deleted within the function,
+ * don't use it afterwards.
+ *
+ * @param elektraConfig the configuration to work with.
+ *        It is used to build up this backend.
+ * @param modules used to load new modules or get references
+ *        to existing one
+ * @param errorKey the key where an error and warnings are added
+ *
+ * @return a pointer to a freshly allocated backend
+ *         this could be the requested backend or a so called
+ *         "missing backend".
+ * @retval 0 if out of memory
+ * @ingroup backend
+ */
+Backend * elektraBackendOpen (KeySet * elektraConfig, KeySet * modules, Key * errorKey)
+{
+	int failure = 0;
+
+	ksRewind (elektraConfig);
+	ksNext (elektraConfig);
+
+	Backend * backend = elektraBackendAllocate ();
+	if (elektraBackendSetMountpoint (backend, elektraConfig, errorKey) == -1)
+	{ // warning already set
+		failure = 1;
+	}
+
+	failure = elektraBackendOpenPlugins (backend, elektraConfig, modules, failure, errorKey);
+
 	if (failure)
 	{
 		Backend * tmpBackend = elektraBackendOpenMissing (backend->mountpoint);
@@ -214,13 +269,91 @@ Backend * elektraBackendOpen (KeySet * elektraConfig, KeySet * modules, Key * er
 		backend = tmpBackend;
 	}
 
-	ksDel (systemConfig);
 	ksDel (elektraConfig);
-	ksDel (referencePlugins);
 
 	return backend;
 }
 
+/**
+ * @brief Builds a backend without opening its plugins
+ *
+ * Like elektraBackendOpen(), but only the mountpoint is set up.
+ * The configuration is kept and the plugins are opened by
+ * elektraBackendLoad() when the backend is used the first time.
+ *
+ * @note The given KeySet will be deleted together with the backend,
+ * don't use it afterwards.
+ *
+ * @param elektraConfig the configuration to work with.
+ * @param modules used to load the modules later, must stay
+ *        valid as long as the backend is not loaded
+ * @param errorKey the key where warnings are added
+ *
+ * @return a pointer to a freshly allocated backend
+ *         or a "missing backend" if there is no mountpoint
+ * @retval 0 if out of memory
+ * @see elektraBackendLoad()
+ * @ingroup backend
+ */
+Backend * elektraBackendOpenLazy (KeySet * elektraConfig, KeySet * modules, Key * errorKey)
+{
+	ksRewind (elektraConfig);
+	ksNext (elektraConfig);
+
+	Backend * backend = elektraBackendAllocate ();
+	if (elektraBackendSetMountpoint (backend, elektraConfig, errorKey) == -1)
+	{
+		Backend * tmpBackend = elektraBackendOpenMissing (backend->mountpoint);
+		elektraBackendClose (backend, errorKey);
+		ksDel (elektraConfig);
+		return tmpBackend;
+	}
+
+	backend->config = elektraConfig;
+	backend->modules = modules;
+
+	return backend;
+}
+
+/**
+ * @brief Opens the plugins of a backend built by elektraBackendOpenLazy()
+ *
+ * Does nothing if the plugins are already open.
+ * If a plugin cannot be opened, the backend is turned into
+ * a "missing backend" in place, so that it stays mounted.
+ *
+ * @param backend the backend to load
+ * @param errorKey the key where warnings are added
+ *
+ * @retval -1 if the backend is missing now
+ * @retval 0 on success (or if already loaded)
+ * @ingroup backend
+ */
+int elektraBackendLoad (Backend * backend, Key * errorKey)
+{
+	if (!backend || !backend->config) return 0;
+
+	KeySet * elektraConfig = backend->config;
+	backend->config = 0;
+	int failure = elektraBackendOpenPlugins (backend, elektraConfig, backend->modules, 0, errorKey);
+	ksDel (elektraConfig);
+	backend->modules = 0;
+
+	if (!failure) return 0;
+
+	elektraBackendClosePlugins (backend, errorKey);
+	Plugin * plugin = elektraPluginMissing ();
+	if (plugin)
+	{
+		backend->getplugins[0] = plugin;
+		backend->setplugins[0] = plugin;
+		plugin->refcounter = 2;
+	}
+	keySetString (backend->mountpoint, "missing");
+
+	return -1;
+}
+
 /**
  * Opens the internal backend that indicates that a backend
  * is missing at that place.
@@ -435,7 +568,6 @@ int elektraBackendUpdateSize (Backend * backend, Key * parent, int size)
 int elektraBackendClose (Backend * backend, Key * errorKey)
 {
 	int ret = 0;
-	int errorOccurred = 0;
 
 	if (!backend) return -1;
 
@@ -448,21 +580,9 @@ int elektraBackendClose (Backend * backend, Key * errorKey)
 	keySetName (errorKey, keyName (backend->mountpoint));
 	keyDel (backend->mountpoint);
 
-	for (int i = 0; i < NR_OF_PLUGINS; ++i)
-	{
-		ret = elektraPluginClose (backend->setplugins[i], errorKey);
-		if (ret == -1) ++errorOccurred;
-
-		ret = elektraPluginClose (backend->getplugins[i], errorKey);
-		if (ret == -1) ++errorOccurred;
-
-		ret = elektraPluginClose (backend->errorplugins[i], errorKey);
-		if (ret == -1) ++errorOccurred;
-	}
+	ret = elektraBackendClosePlugins (backend, errorKey);
+	ksDel (backend->config);
 	elektraFree (backend);
 
-	if (errorOccurred)
-		return -1;
-	else
-		return 0;
+	return ret;
 }
@@ -0,0 +1,470 @@
+/**
+ * @file
+ *
+ * @brief Cache for the keys storage plugins parsed from files.
+ *
+ * kdbGet() stores the keys a backend returned after its storage
+ * plugin in a binary file below the cache directory
+ * (see system/elektra/cache). As long as the configuration file
+ * did not change, the next process maps the cache file and creates
+ * the keys without calling the plugins up to the storage plugin.
+ *
+ * The cache files are bound to the machine which wrote them,
+ * numbers are stored in the native byte order.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#ifdef HAVE_MMAP
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kdbinternal.h"
+
+#define ELEKTRA_CACHE_MAGIC "EKC"
+#define ELEKTRA_CACHE_VERSION 1
+
+/** Flags of a key within a cache file */
+#define ELEKTRA_CACHE_BINARY 1
+#define ELEKTRA_CACHE_VALUE 2
+
+/**
+ * @internal
+ *
+ * Header of a cache file, followed by the keys.
+ *
+ * The configuration file the keys were parsed from must still have
+ * the same device, inode, size and modification time.
+ */
+typedef struct
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t identity;  /*!< hash of parent, file and plugins (see elektraCacheIdentity()) */
+	uint64_t dev;       /*!< device of the configuration file */
+	uint64_t ino;       /*!< inode of the configuration file */
+	uint64_t size;      /*!< size of the configuration file */
+	int64_t mtimeSec;   /*!< modification time of the configuration file */
+	int64_t mtimeNsec;  /*!< nanoseconds of the modification time */
+	uint64_t keys;      /*!< number of keys following */
+	uint64_t dataSize;  /*!< number of bytes following */
+} ElektraCacheHeader;
+
+/**
+ * @internal
+ *
+ * Buffer a cache file is written to.
+ */
+typedef struct
+{
+	char * data;
+	size_t size;
+	size_t alloc;
+} ElektraCacheBuffer;
+
+static uint64_t elektraCacheHash (uint64_t hash, const char * str)
+{
+	// FNV-1a, including the null byte to separate strings
+	const unsigned char * c = (const unsigned char *)str;
+	do
+	{
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	} while (*c++);
+	return hash;
+}
+
+/**
+ * @internal
+ *
+ * Identifies what the cached keys depend on besides the file:
+ * the parent, the filename and all plugins up to the storage plugin
+ * together with their configuration.
+ */
+static uint64_t elektraCacheIdentity (Backend * backend, Key * parentKey)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hash = elektraCacheHash (hash, keyName (parentKey));
+	hash = elektraCacheHash (hash, keyString (parentKey));
+
+	for (size_t p = 1; p <= STORAGE_PLUGIN; ++p)
+	{
+		Plugin * plugin = backend->getplugins[p];
+		if (!plugin) continue;
+
+		hash = elektraCacheHash (hash, plugin->name);
+		Key * cur;
+		ksRewind (plugin->config);
+		while ((cur = ksNext (plugin->config)) != 0)
+		{
+			hash = elektraCacheHash (hash, keyName (cur));
+			hash = elektraCacheHash (hash, keyString (cur));
+		}
+	}
+	return hash;
+}
+
+/**
+ * @internal
+ *
+ * Fill the header with everything that has to match when loading.
+ *
+ * @retval 0 on success
+ * @retval -1 if the file cannot be cached
+ */
+static int elektraCacheHeader (Backend * backend, Key * parentKey, ElektraCacheHeader * header)
+{
+	struct stat buf;
+	const char * filename = keyString (parentKey);
+	if (filename[0] != '/' || stat (filename, &buf) == -1 || !S_ISREG (buf.st_mode)) return -1;
+
+	memset (header, 0, sizeof (ElektraCacheHeader));
+	memcpy (header->magic, ELEKTRA_CACHE_MAGIC, sizeof (header->magic));
+	header->version = ELEKTRA_CACHE_VERSION;
+	header->identity = elektraCacheIdentity (backend, parentKey);
+	header->dev = buf.st_dev;
+	header->ino = buf.st_ino;
+	header->size = buf.st_size;
+#if defined(__APPLE__)
+	header->mtimeSec = buf.st_mtimespec.tv_sec;
+	header->mtimeNsec = buf.st_mtimespec.tv_nsec;
+#else
+	header->mtimeSec = buf.st_mtim.tv_sec;
+	header->mtimeNsec = buf.st_mtim.tv_nsec;
+#endif
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * @return the name of the cache file for the identity, to be freed
+ */
+static char * elektraCacheFileName (const char * dir, uint64_t identity, const char * suffix)
+{
+	size_t size = strlen (dir) + 1 + 16 + strlen (suffix) + 1;
+	char * name = elektraMalloc (size);
+	if (name) snprintf (name, size, "%s/%016llx%s", dir, (unsigned long long)identity, suffix);
+	return name;
+}
+
+/**
+ * @internal
+ *
+ * Create the directory and all missing parents,
+ * only accessible by the user.
+ *
+ * @retval 0 on success
+ * @retval -1 on error
+ */
+static int elektraCacheMkdir (const char * dir)
+{
+	char * path = elektraStrDup (dir);
+	if (!path) return -1;
+
+	int ret = 0;
+	for (char * slash = strchr (path + 1, '/'); ret == 0; slash = strchr (slash + 1, '/'))
+	{
+		if (slash) *slash = '\0';
+		if (mkdir (path, 0700) == -1 && errno != EEXIST) ret = -1;
+		if (!slash) break;
+		*slash = '/';
+	}
+	elektraFree (path);
+	return ret;
+}
+
+static int elektraCacheWrite (ElektraCacheBuffer * buffer, const void * data, size_t size)
+{
+	if (buffer->size + size > buffer->alloc)
+	{
+		size_t alloc = buffer->alloc ? buffer->alloc * 2 : 4096;
+		while (alloc < buffer->size + size)
+			alloc *= 2;
+		if (elektraRealloc ((void **)&buffer->data, alloc) == -1) return -1;
+		buffer->alloc = alloc;
+	}
+	memcpy (buffer->data + buffer->size, data, size);
+	buffer->size += size;
+	return 0;
+}
+
+static int elektraCacheWriteSize (ElektraCacheBuffer * buffer, size_t size)
+{
+	uint32_t value = size;
+	if (value != size) return -1;
+	return elektraCacheWrite (buffer, &value, sizeof (value));
+}
+
+static int elektraCacheWriteString (ElektraCacheBuffer * buffer, const char * str)
+{
+	size_t len = strlen (str);
+	if (elektraCacheWriteSize (buffer, len) == -1) return -1;
+	return elektraCacheWrite (buffer, str, len + 1);
+}
+
+static int elektraCacheWriteKey (ElektraCacheBuffer * buffer, Key * key)
+{
+	unsigned char flags = 0;
+	if (keyIsBinary (key)) flags |= ELEKTRA_CACHE_BINARY;
+	if (key->data.v) flags |= ELEKTRA_CACHE_VALUE;
+
+	if (elektraCacheWriteString (buffer, keyName (key)) == -1) return -1;
+	if (elektraCacheWrite (buffer, &flags, sizeof (flags)) == -1) return -1;
+	if (elektraCacheWriteSize (buffer, key->data.v ? key->dataSize : 0) == -1) return -1;
+	if (key->data.v && elektraCacheWrite (buffer, key->data.v, key->dataSize) == -1) return -1;
+
+	if (elektraCacheWriteSize (buffer, key->meta ? ksGetSize (key->meta) : 0) == -1) return -1;
+	const Key * meta;
+	keyRewindMeta (key);
+	while ((meta = keyNextMeta (key)) != 0)
+	{
+		if (elektraCacheWriteString (buffer, keyName (meta)) == -1) return -1;
+		if (elektraCacheWriteString (buffer, keyString (meta)) == -1) return -1;
+	}
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Read position within a mapped cache file.
+ */
+typedef struct
+{
+	const char * pos;
+	const char * end;
+} ElektraCacheReader;
+
+static int elektraCacheReadSize (ElektraCacheReader * reader, size_t * size)
+{
+	uint32_t value;
+	if ((size_t) (reader->end - reader->pos) < sizeof (value)) return -1;
+	memcpy (&value, reader->pos, sizeof (value));
+	reader->pos += sizeof (value);
+	*size = value;
+	return 0;
+}
+
+static const char * elektraCacheReadData (ElektraCacheReader * reader, size_t size)
+{
+	if ((size_t) (reader->end - reader->pos) < size) return 0;
+	const char * data = reader->pos;
+	reader->pos += size;
+	return data;
+}
+
+static const char * elektraCacheReadString (ElektraCacheReader * reader)
+{
+	size_t len;
+	if (elektraCacheReadSize (reader, &len) == -1) return 0;
+	const char * str = elektraCacheReadData (reader, len + 1);
+	if (!str || str[len] != '\0') return 0;
+	return str;
+}
+
+static Key * elektraCacheReadKey (ElektraCacheReader * reader, ElektraArena * arena)
+{
+	const char * name = elektraCacheReadString (reader);
+	const char * flags = elektraCacheReadData (reader, 1);
+	size_t valueSize;
+	if (!name || !flags || elektraCacheReadSize (reader, &valueSize) == -1) return 0;
+	const char * value = elektraCacheReadData (reader, valueSize);
+	if (!value) return 0;
+
+	Key * key;
+	if (!(*flags & ELEKTRA_CACHE_VALUE))
+	{
+		key = elektraArenaKeyNew (arena, name, (*flags & ELEKTRA_CACHE_BINARY) ? KEY_BINARY : KEY_END, KEY_END);
+	}
+	else if (*flags & ELEKTRA_CACHE_BINARY)
+	{
+		key = elektraArenaKeyNew (arena, name, KEY_BINARY, KEY_SIZE, valueSize, KEY_VALUE, value, KEY_END);
+	}
+	else
+	{
+		if (!valueSize || value[valueSize - 1] != '\0') return 0;
+		key = elektraArenaKeyNew (arena, name, KEY_VALUE, value, KEY_END);
+	}
+	if (!key) return 0;
+
+	size_t metaSize;
+	if (elektraCacheReadSize (reader, &metaSize) == -1)
+	{
+		keyDel (key);
+		return 0;
+	}
+	for (size_t i = 0; i < metaSize; ++i)
+	{
+		const char * metaName = elektraCacheReadString (reader);
+		const char * metaValue = elektraCacheReadString (reader);
+		if (!metaName || !metaValue)
+		{
+			keyDel (key);
+			return 0;
+		}
+		keySetMeta (key, metaName, metaValue);
+	}
+	return key;
+}
+
+/**
+ * @internal
+ *
+ * @brief Create the keys a backend returned before, if its file did not change.
+ *
+ * Only cache files owned by the current user are used.
+ *
+ * @param dir the cache directory
+ * @param backend the backend, its plugins are part of the cache identity
+ * @param parentKey name of the backend's parent, the value is the resolved filename
+ * @param returned the (empty) keyset to add the keys to
+ *
+ * @retval 1 if the keys were added from the cache
+ * @retval 0 if there is no valid cache entry, @p returned is unchanged then
+ */
+int elektraCacheGet (const char * dir, Backend * backend, Key * parentKey, KeySet * returned)
+{
+	ElektraCacheHeader expected;
+	if (elektraCacheHeader (backend, parentKey, &expected) == -1) return 0;
+
+	char * name = elektraCacheFileName (dir, expected.identity, ".cache");
+	if (!name) return 0;
+	int fd = open (name, O_RDONLY | O_CLOEXEC);
+	elektraFree (name);
+	if (fd == -1) return 0;
+
+	struct stat buf;
+	if (fstat (fd, &buf) == -1 || buf.st_uid != geteuid () || (size_t)buf.st_size < sizeof (ElektraCacheHeader))
+	{
+		close (fd);
+		return 0;
+	}
+
+	size_t size = buf.st_size;
+	const char * map = mmap (0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED) return 0;
+
+	ElektraCacheHeader header;
+	memcpy (&header, map, sizeof (header));
+	expected.keys = header.keys;
+	expected.dataSize = header.dataSize;
+	if (memcmp (&header, &expected, sizeof (header)) || header.dataSize != size - sizeof (header))
+	{
+		munmap ((void *)map, size);
+		return 0;
+	}
+
+	ElektraCacheReader reader = { map + sizeof (header), map + size };
+	ElektraArena * arena = elektraArenaNew (header.dataSize);
+	ElektraKsBuilder * builder = elektraKsBuilderNew (header.keys);
+	int ret = builder ? 1 : 0;
+	for (uint64_t i = 0; ret && i < header.keys; ++i)
+	{
+		Key * key = elektraCacheReadKey (&reader, arena);
+		if (!key) ret = 0;
+		else if (elektraKsBuilderAdd (builder, key) == -1)
+		{
+			keyDel (key);
+			ret = 0;
+		}
+	}
+	if (ret && (reader.pos != reader.end || elektraKsBuilderFinish (builder, returned) == -1)) ret = 0;
+
+	elektraKsBuilderDel (builder);
+	elektraArenaDel (arena);
+	munmap ((void *)map, size);
+	return ret;
+}
+
+/**
+ * @internal
+ *
+ * @brief Store the keys a backend returned in the cache.
+ *
+ * The cache file is replaced atomically, errors are ignored
+ * because the cache is only an optimization.
+ *
+ * @param dir the cache directory, created if it does not exist
+ * @param backend the backend, its plugins are part of the cache identity
+ * @param parentKey name of the backend's parent, the value is the resolved filename
+ * @param returned the keys to store
+ *
+ * @retval 1 if the keys were stored
+ * @retval 0 otherwise
+ */
+int elektraCacheSet (const char * dir, Backend * backend, Key * parentKey, KeySet * returned)
+{
+	ElektraCacheHeader header;
+	if (elektraCacheHeader (backend, parentKey, &header) == -1) return 0;
+	header.keys = ksGetSize (returned);
+
+	ElektraCacheBuffer buffer = { 0, 0, 0 };
+	int ret = elektraCacheWrite (&buffer, &header, sizeof (header)) == 0;
+	for (size_t i = 0; ret && i < header.keys; ++i)
+	{
+		if (elektraCacheWriteKey (&buffer, returned->array[i]) == -1) ret = 0;
+	}
+	header.dataSize = buffer.size - sizeof (header);
+
+	char * name = elektraCacheFileName (dir, header.identity, ".cache");
+	char * tmp = elektraCacheFileName (dir, header.identity, ".XXXXXX");
+	int fd = -1;
+	if (ret && name && tmp)
+	{
+		memcpy (buffer.data, &header, sizeof (header));
+		fd = mkstemp (tmp);
+		if (fd == -1 && errno == ENOENT && elektraCacheMkdir (dir) == 0)
+		{
+			// mkstemp() might have changed the template
+			memcpy (tmp + strlen (tmp) - 6, "XXXXXX", 6);
+			fd = mkstemp (tmp);
+		}
+	}
+	if (fd != -1)
+	{
+		ret = write (fd, buffer.data, buffer.size) == (ssize_t)buffer.size;
+		if (close (fd) == -1) ret = 0;
+		if (!ret || rename (tmp, name) == -1)
+		{
+			unlink (tmp);
+			ret = 0;
+		}
+	}
+	else
+	{
+		ret = 0;
+	}
+
+	elektraFree (name);
+	elektraFree (tmp);
+	elektraFree (buffer.data);
+	return ret;
+}
+
+#endif
@@ -43,6 +43,10 @@
 #include <errno.h>
 #endif
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include <kdbinternal.h>
 
 
@@ -142,6 +146,64 @@ void elektraRemoveMetaData (Key * key, const char * searchfor)
 	}
 }
 
+/**
+ * @internal
+ *
+ * @brief Directory to cache the bootstrap configuration in
+ *
+ * The directory is KDB_DB_CACHE below the home directory,
+ * so every user has its own cache.
+ *
+ * @return the allocated directory name
+ * @retval 0 if the cache is disabled or there is no home directory
+ */
+static char * elektraOpenBootstrapCache (void)
+{
+#ifdef HAVE_MMAP
+	const char * home = getenv ("HOME");
+	if (!home || home[0] != '/' || KDB_DB_CACHE[0] == '\0') return 0;
+
+	size_t size = strlen (home) + sizeof ("/" KDB_DB_CACHE);
+	char * dir = elektraMalloc (size);
+	if (dir) snprintf (dir, size, "%s/" KDB_DB_CACHE, home);
+	return dir;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @internal
+ *
+ * @brief Get the bootstrap configuration with the default backend
+ *
+ * If @p handle has a cache directory, a cache file of the keys of
+ * the default backend is used if there is one for the unchanged
+ * file. A cache file is only written if the user opted in with
+ * system/elektra/cache in the bootstrap configuration, otherwise
+ * nothing gets written.
+ *
+ * @param handle with the default backend, without split
+ * @param [out] keys for bootstrapping
+ * @param errorKey key to add errors too
+ * @param step the value for @p errorKey, to see what failed
+ *
+ * @return the return value of kdbGet()
+ */
+static int elektraOpenBootstrapGet (KDB * handle, KeySet * keys, Key * errorKey, const char * step)
+{
+	handle->split = elektraSplitNew ();
+	elektraSplitAppend (handle->split, handle->defaultBackend, keyNew (KDB_SYSTEM_ELEKTRA, KEY_END), 2);
+
+	keySetName (errorKey, KDB_SYSTEM_ELEKTRA);
+	keySetString (errorKey, step);
+
+	handle->cacheBootstrap = 1;
+	int ret = kdbGet (handle, keys, errorKey);
+	handle->cacheBootstrap = 0;
+	return ret;
+}
+
 /**
  * @brief Bootstrap, first phase with fallback
  * @internal
@@ -154,20 +216,22 @@ void elektraRemoveMetaData (Key * key, const char * searchfor)
  * @retval 0 warning: could not get initial config
  * @retval 1 success
  * @retval 2 success in fallback mode
+ *
+ * If the bootstrap configuration contains system/elektra/cache, the
+ * keys parsed from the bootstrap file are cached (see
+ * elektraOpenBootstrapCache()), so as long as the file does not
+ * change, no storage plugin needs to parse the mountpoints.
  */
 int elektraOpenBootstrap (KDB * handle, KeySet * keys, Key * errorKey)
 {
 	handle->defaultBackend = elektraBackendOpenDefault (handle->modules, KDB_DB_INIT, errorKey);
 	if (!handle->defaultBackend) return -1;
 
-	handle->split = elektraSplitNew ();
-	elektraSplitAppend (handle->split, handle->defaultBackend, keyNew (KDB_SYSTEM_ELEKTRA, KEY_END), 2);
-
-	keySetName (errorKey, KDB_SYSTEM_ELEKTRA);
-	keySetString (errorKey, "kdbOpen(): get");
+	// only used for the bootstrap, system/elektra/cache is read afterwards
+	handle->cache = elektraOpenBootstrapCache ();
 
 	int funret = 1;
-	int ret = kdbGet (handle, keys, errorKey);
+	int ret = elektraOpenBootstrapGet (handle, keys, errorKey, "kdbOpen(): get");
 	int fallbackret = 0;
 	if (ret == 0 || ret == -1)
 	{
@@ -182,14 +246,12 @@ int elektraOpenBootstrap (KDB * handle, KeySet * keys, Key * errorKey)
 		if (!handle->defaultBackend)
 		{
 			elektraRemoveMetaData (errorKey, "error"); // fix errors from kdbGet()
+			elektraFree (handle->cache);
+			handle->cache = 0;
 			return -1;
 		}
-		handle->split = elektraSplitNew ();
-		elektraSplitAppend (handle->split, handle->defaultBackend, keyNew (KDB_SYSTEM_ELEKTRA, KEY_END), 2);
 
-		keySetName (errorKey, KDB_SYSTEM_ELEKTRA);
-		keySetString (errorKey, "kdbOpen(): get fallback");
-		fallbackret = kdbGet (handle, keys, errorKey);
+		fallbackret = elektraOpenBootstrapGet (handle, keys, errorKey, "kdbOpen(): get fallback");
 		keySetName (errorKey, "system/elektra/mountpoints");
 
 		KeySet * cutKeys = ksCut (keys, errorKey);
@@ -206,6 +268,9 @@ int elektraOpenBootstrap (KDB * handle, KeySet * keys, Key * errorKey)
 		funret = 0;
 	}
 
+	elektraFree (handle->cache);
+	handle->cache = 0;
+
 	elektraRemoveMetaData (errorKey, "error"); // fix errors from kdbGet()
 	return funret;
 }
@@ -239,6 +304,25 @@ int elektraOpenBootstrap (KDB * handle, KeySet * keys, Key * errorKey)
  * You don't need kdbOpen() if you only want to
  * manipulate plain in-memory Key or KeySet objects.
  *
+ * If system/elektra/threads is set to a number greater than 1,
+ * kdbGet() of the returned handle updates up to that many backends
+ * in parallel (only backends whose plugins opt in with infos/threadsafe = 1).
+ *
+ * If system/elektra/cache is set to an absolute path, kdbGet() of
+ * the returned handle caches the keys parsed by storage plugins in
+ * that directory (see elektraCacheGet()).
+ *
+ * With system/elektra/cache set, the bootstrap configuration itself
+ * (including the mountpoints) is cached, too: below KDB_DB_CACHE in
+ * the home directory of the user. It is parsed again only when the
+ * bootstrap file changed. Without system/elektra/cache, kdbOpen()
+ * does not write any file.
+ *
+ * The plugins of the mountpoints are not opened here, but with the
+ * first kdbGet() or kdbSet() below the mountpoint. So warnings about
+ * mountpoints which cannot be loaded are added to the parentKey
+ * of that call. Use elektraKdbPrewarm() to open them in advance.
+ *
  * @pre errorKey must be a valid key, e.g. created with keyNew()
  *
  * @param errorKey the key which holds errors and warnings which were issued
@@ -295,6 +379,22 @@ KDB * kdbOpen (Key * errorKey)
 		break;
 	}
 
+	// opt-in to update backends in parallel within kdbGet()
+	Key * threads = ksLookupByName (keys, KDB_SYSTEM_ELEKTRA "/threads", 0);
+	if (threads && isdigit ((unsigned char)keyString (threads)[0]))
+	{
+		char * end = 0;
+		unsigned long nr = strtoul (keyString (threads), &end, 10);
+		if (*end == '\0') handle->threads = nr;
+	}
+
+	// opt-in to cache the keys parsed by storage plugins
+	Key * cache = ksLookupByName (keys, KDB_SYSTEM_ELEKTRA "/cache", 0);
+	if (cache && keyString (cache)[0] == '/')
+	{
+		handle->cache = elektraStrDup (keyString (cache));
+	}
+
 	keySetString (errorKey, "kdbOpen(): mountGlobals");
 
 	if (elektraMountGlobals (handle, ksDup (keys), handle->modules, errorKey) == -1)
@@ -329,8 +429,9 @@ KDB * kdbOpen (Key * errorKey)
 	handle->split = elektraSplitNew ();
 
 	keySetString (errorKey, "kdbOpen(): mountOpen");
-	// Open the trie, keys will be deleted within elektraMountOpen
-	if (elektraMountOpen (handle, keys, handle->modules, errorKey) == -1)
+	// Open the trie, keys will be deleted within elektraMountOpenLazy
+	// plugins of the backends are opened on first use
+	if (elektraMountOpenLazy (handle, keys, handle->modules, errorKey) == -1)
 	{
 		ELEKTRA_ADD_WARNING (93, errorKey, "Initial loading of trie did not work");
 	}
@@ -427,6 +528,7 @@ int kdbClose (KDB * handle, Key * errorKey)
 		ELEKTRA_ADD_WARNING (47, errorKey, "modules were not open");
 	}
 
+	elektraFree (handle->cache);
 	elektraFree (handle);
 
 	keySetName (errorKey, keyName (initialParent));
@@ -436,6 +538,101 @@ int kdbClose (KDB * handle, Key * errorKey)
 	return 0;
 }
 
+/**
+ * @internal
+ *
+ * @brief Open the plugins of all backends of the split
+ *
+ * Backends which cannot be loaded are turned into missing backends,
+ * the warnings are added to the parentKey.
+ *
+ * @param split the split built by elektraSplitBuildup()
+ * @param parentKey the key for warnings
+ */
+static void elektraLoadBackends (Split * split, Key * parentKey)
+{
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		elektraBackendLoad (split->handles[i], parentKey);
+	}
+}
+
+/**
+ * @brief Open the plugins of all mountpoints below a key
+ *
+ * kdbOpen() does not open the plugins of the mountpoints, they are
+ * opened by the first kdbGet() or kdbSet() using them. Use this
+ * function to pay that cost in advance, e.g. during startup.
+ *
+ * @param handle the handle returned by kdbOpen()
+ * @param parentKey the key below which all mountpoints should be opened,
+ *        use "/" for all mountpoints. Warnings about mountpoints which
+ *        could not be loaded are added to it.
+ *
+ * @retval 0 on success (also if some mountpoints are missing now)
+ * @retval -1 on NULL pointers or if the mountpoints could not be determined
+ * @ingroup proposal
+ */
+int elektraKdbPrewarm (KDB * handle, Key * parentKey)
+{
+	if (!handle || !parentKey) return -1;
+
+	int ret = 0;
+	Key * initialParent = keyDup (parentKey);
+	Split * split = elektraSplitNew ();
+
+	if (elektraSplitBuildup (split, handle, parentKey) == -1)
+	{
+		ret = -1;
+	}
+	else
+	{
+		elektraLoadBackends (split, parentKey);
+	}
+
+	keySetName (parentKey, keyName (initialParent));
+	keyDel (initialParent);
+	elektraSplitDel (split);
+	return ret;
+}
+
+/**
+ * @internal
+ *
+ * @brief Track the changes of the keyset returned by kdbGet()
+ *
+ * Changes recorded before are kept, so that kdbSet() still
+ * writes them. Only changes within the updated backends are
+ * dropped, their keys were replaced by the fresh ones.
+ *
+ * @param split the split of kdbGet()
+ * @param handle to find the backends of the changes
+ * @param ks the keyset to track
+ * @param changes the changes of @p ks before kdbGet(), may be 0
+ */
+static void elektraGetTrackChanges (Split * split, KDB * handle, KeySet * ks, KeySetChanges * changes)
+{
+	KeySet * names = changes ? changes->names : 0;
+	KeySet * kept = names ? ksNew (ksGetSize (names), KS_END) : 0;
+
+	for (size_t i = 0; kept && i < names->size; ++i)
+	{
+		Key * cur = names->array[i];
+		Backend * backend = elektraMountGetBackend (handle, cur);
+		ssize_t found = backend ? elektraSplitSearchBackend (split, backend, cur) : -1;
+		if (found == -1 || !test_bit (split->syncbits[found], SPLIT_FLAG_SYNC)) ksAppendKey (kept, cur);
+	}
+
+	if (kept)
+	{
+		ksDel (names);
+		changes->names = kept;
+	}
+
+	ks->changes = changes;
+	elektraKsTrack (ks);
+}
+
 /**
  * @internal
  *
@@ -486,14 +683,108 @@ static int elektraGetCheckUpdateNeeded (Split * split, Key * parentKey)
 	return updateNeededOccurred;
 }
 
+#ifdef HAVE_MMAP
 /**
  * @internal
- * @brief Do the real update.
+ *
+ * Checks if the cache may replace the get plugins of a backend up to
+ * its storage plugin, i.e. if all of them are cacheable
+ * (see elektraPluginCacheable()).
+ */
+static int elektraGetCacheable (Backend * backend)
+{
+	if (!backend->getplugins[STORAGE_PLUGIN]) return 0;
+	for (size_t p = 1; p <= STORAGE_PLUGIN; ++p)
+	{
+		if (backend->getplugins[p] && !elektraPluginCacheable (backend->getplugins[p])) return 0;
+	}
+	return 1;
+}
+#endif
+
+/**
+ * @internal
+ * @brief Run the get plugins (except the resolver) of one backend.
+ *
+ * If the handle has a cache, the backend starts without keys and
+ * its plugins up to the storage plugin are cacheable, these plugins
+ * are replaced by the cache.
+ *
+ * @param split the split with the backend
+ * @param i the index of the backend within split
+ * @param parentKey the key for errors and warnings
+ * @param handle the handle with the cache directory
  *
  * @retval -1 on error
  * @retval 0 on success
  */
-static int elektraGetDoUpdate (Split * split, Key * parentKey)
+static int elektraGetDoUpdateBackend (Split * split, size_t i, Key * parentKey, KDB * handle)
+{
+	Backend * backend = split->handles[i];
+	ksRewind (split->keysets[i]);
+	keySetName (parentKey, keyName (split->parents[i]));
+	keySetString (parentKey, keyString (split->parents[i]));
+
+	size_t p = 1;
+#ifdef HAVE_MMAP
+	int cache = handle->cache && ksGetSize (split->keysets[i]) == 0 && elektraGetCacheable (backend);
+	if (cache && elektraCacheGet (handle->cache, backend, parentKey, split->keysets[i]) == 1)
+	{
+		// the file did not change, continue after the storage plugin
+		p = STORAGE_PLUGIN + 1;
+		cache = 0;
+	}
+	// warnings cannot be cached, so only results without warnings are stored
+	const Key * warnings = keyGetMeta (parentKey, "warnings");
+	char * warningsBefore = cache && warnings ? elektraStrDup (keyString (warnings)) : 0;
+#else
+	(void)handle;
+#endif
+
+	for (; p < NR_OF_PLUGINS; ++p)
+	{
+		int ret = 0;
+		if (backend->getplugins[p])
+		{
+			ret = backend->getplugins[p]->kdbGet (backend->getplugins[p], split->keysets[i], parentKey);
+		}
+		if (ret == -1)
+		{
+			// Ohh, an error occurred,
+			// lets stop the process.
+#ifdef HAVE_MMAP
+			elektraFree (warningsBefore);
+#endif
+			return -1;
+		}
+#ifdef HAVE_MMAP
+		if (cache && p == STORAGE_PLUGIN)
+		{
+			warnings = keyGetMeta (parentKey, "warnings");
+			int same = !warnings ? !warningsBefore : warningsBefore && !strcmp (keyString (warnings), warningsBefore);
+			// while bootstrapping, the configuration needs to opt in
+			int optIn = !handle->cacheBootstrap || ksLookupByName (split->keysets[i], KDB_SYSTEM_ELEKTRA "/cache", 0);
+			if (same && optIn)
+			{
+				elektraCacheSet (handle->cache, backend, parentKey, split->keysets[i]);
+			}
+		}
+#endif
+	}
+#ifdef HAVE_MMAP
+	elektraFree (warningsBefore);
+#endif
+	return 0;
+}
+
+/**
+ * @internal
+ * @brief Do the real update, one backend after the other.
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ */
+static int elektraGetDoUpdateSequential (Split * split, Key * parentKey, KDB * handle)
 {
 	const int bypassedSplits = 1;
 	for (size_t i = 0; i < split->size - bypassedSplits; i++)
@@ -503,27 +794,309 @@ static int elektraGetDoUpdate (Split * split, Key * parentKey)
 			// skip it, update is not needed
 			continue;
 		}
-		Backend * backend = split->handles[i];
-		ksRewind (split->keysets[i]);
-		keySetName (parentKey, keyName (split->parents[i]));
-		keySetString (parentKey, keyString (split->parents[i]));
+		if (elektraGetDoUpdateBackend (split, i, parentKey, handle) == -1)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * @internal
+ *
+ * Backends which are updated by the worker threads.
+ */
+typedef struct
+{
+	Split * split;
+	KDB * handle;
+	Backend ** jobs;    /*!< every backend once, in the order of split */
+	size_t size;	    /*!< number of jobs */
+	size_t next;	    /*!< the next job to take */
+	Key ** parents;	    /*!< per split entry: parentKey for the worker, 0 if not run in parallel */
+	int * rets;	    /*!< per split entry: the result of elektraGetDoUpdateBackend() */
+	pthread_mutex_t mutex; /*!< protects next */
+} ElektraGetPool;
+
+/**
+ * @internal
+ *
+ * Takes backends from the pool until all are done.
+ * The split entries of a backend are updated in split order,
+ * so that the same plugins never run in two threads at once.
+ */
+static void * elektraGetWorker (void * data)
+{
+	const int bypassedSplits = 1;
+	ElektraGetPool * pool = data;
+	Split * split = pool->split;
+
+	for (;;)
+	{
+		pthread_mutex_lock (&pool->mutex);
+		size_t job = pool->next++;
+		pthread_mutex_unlock (&pool->mutex);
+		if (job >= pool->size) return 0;
+
+		for (size_t i = 0; i < split->size - bypassedSplits; ++i)
+		{
+			if (split->handles[i] != pool->jobs[job] || !pool->parents[i]) continue;
+			pool->rets[i] = elektraGetDoUpdateBackend (split, i, pool->parents[i], pool->handle);
+			if (pool->rets[i] == -1) break;
+		}
+	}
+}
+
+/**
+ * @internal
+ *
+ * Adds the warnings of @p from to @p to, numbered after the warnings
+ * already present in @p to (like ELEKTRA_ADD_WARNING would do).
+ */
+static void elektraGetCopyWarnings (Key * to, Key * from)
+{
+	char buffer[] = "warnings/#00";
+	const Key * meta;
+
+	keyRewindMeta (from);
+	while ((meta = keyNextMeta (from)) != 0)
+	{
+		const char * name = keyName (meta);
+		if (strncmp (name, "warnings/#", 10) || strlen (name) < 12) continue;
+
+		if (name[12] == '\0')
+		{
+			const Key * current = keyGetMeta (to, "warnings");
+			if (current)
+			{
+				buffer[10] = keyString (current)[0];
+				buffer[11] = keyString (current)[1] + 1;
+				if (buffer[11] > '9')
+				{
+					buffer[11] = '0';
+					buffer[10]++;
+					if (buffer[10] > '9') buffer[10] = '0';
+				}
+			}
+			keySetMeta (to, "warnings", &buffer[10]);
+			keySetMeta (to, buffer, keyString (meta));
+		}
+		else
+		{
+			char * renamed = elektraFormat ("%s%s", buffer, name + 12);
+			keySetMeta (to, renamed, keyString (meta));
+			elektraFree (renamed);
+		}
+	}
+}
+
+/**
+ * @internal
+ *
+ * Checks if @p name is the name of meta data for warnings or errors.
+ */
+static int elektraGetIsReport (const char * name)
+{
+	if (!strncmp (name, "warnings", 8)) return name[8] == '\0' || name[8] == '/';
+	if (!strncmp (name, "error", 5)) return name[5] == '\0' || name[5] == '/';
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Copies the meta data of @p from to @p to, except warnings and errors.
+ */
+static void elektraGetCopyMeta (Key * to, Key * from)
+{
+	const Key * meta;
+
+	keyRewindMeta (from);
+	while ((meta = keyNextMeta (from)) != 0)
+	{
+		if (!elektraGetIsReport (keyName (meta))) keyCopyMeta (to, from, keyName (meta));
+	}
+}
+
+/**
+ * @internal
+ *
+ * Applies the changes a backend made to the meta data of its copy
+ * of the parentKey, except warnings and errors.
+ *
+ * @param to the parentKey of kdbGet()
+ * @param from the copy of the parentKey the backend worked with
+ * @param before the meta data @p from started with
+ */
+static void elektraGetMergeMeta (Key * to, Key * from, Key * before)
+{
+	const Key * meta;
+
+	elektraGetCopyMeta (to, from);
+	keyRewindMeta (before);
+	while ((meta = keyNextMeta (before)) != 0)
+	{
+		if (!keyGetMeta (from, keyName (meta))) keySetMeta (to, keyName (meta), 0);
+	}
+}
+
+/**
+ * @internal
+ * @brief Do the real update with backends running in parallel.
+ *
+ * Every backend gets its own copy of the parentKey, including
+ * its meta data (but without warnings and errors). After all
+ * threads finished, the changes of the meta data, warnings and
+ * errors are merged into @p parentKey in split order. So the
+ * result is the same as if the backends were updated one after
+ * the other: warnings of all backends up to the first failing
+ * one and its error. Only changes of the meta data of the
+ * parentKey by one backend are not seen by the plugins of other
+ * backends updated in parallel.
+ *
+ * Backends with a plugin which is not thread-safe
+ * (see elektraPluginThreadSafe()) are updated afterwards
+ * by the calling thread at their position in the split.
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ */
+static int elektraGetDoUpdateParallel (Split * split, Key * parentKey, KDB * handle)
+{
+	const int bypassedSplits = 1;
+	ElektraGetPool pool;
+	pool.split = split;
+	pool.handle = handle;
+	pool.size = 0;
+	pool.next = 0;
+	pool.jobs = elektraCalloc (split->size * sizeof (Backend *));
+	pool.parents = elektraCalloc (split->size * sizeof (Key *));
+	pool.rets = elektraCalloc (split->size * sizeof (int));
+	if (!pool.jobs || !pool.parents || !pool.rets)
+	{
+		elektraFree (pool.jobs);
+		elektraFree (pool.parents);
+		elektraFree (pool.rets);
+		return elektraGetDoUpdateSequential (split, parentKey, handle);
+	}
 
+	// the meta data every copy of parentKey starts with
+	Key * before = keyNew ("/", KEY_CASCADING_NAME, KEY_END);
+	elektraGetCopyMeta (before, parentKey);
+
+	for (size_t i = 0; i < split->size - bypassedSplits; ++i)
+	{
+		if (!test_bit (split->syncbits[i], SPLIT_FLAG_SYNC)) continue;
+
+		Backend * backend = split->handles[i];
+		int threadsafe = 1;
 		for (size_t p = 1; p < NR_OF_PLUGINS; ++p)
 		{
-			int ret = 0;
-			if (backend->getplugins[p])
+			if (backend->getplugins[p] && !elektraPluginThreadSafe (backend->getplugins[p])) threadsafe = 0;
+		}
+		if (!threadsafe) continue;
+
+		pool.parents[i] = keyDup (before);
+		keySetName (pool.parents[i], keyName (split->parents[i]));
+		keySetString (pool.parents[i], keyString (split->parents[i]));
+
+		size_t job = 0;
+		while (job < pool.size && pool.jobs[job] != backend)
+			++job;
+		if (job == pool.size) pool.jobs[pool.size++] = backend;
+	}
+
+	pthread_t * workers = 0;
+	size_t started = 0;
+	pthread_mutex_init (&pool.mutex, 0);
+	if (pool.size > 1)
+	{
+		// the calling thread works, too
+		size_t nrWorkers = (handle->threads < pool.size ? handle->threads : pool.size) - 1;
+		workers = elektraMalloc (nrWorkers * sizeof (pthread_t));
+		for (; workers && started < nrWorkers; ++started)
+		{
+			if (pthread_create (&workers[started], 0, elektraGetWorker, &pool)) break;
+		}
+	}
+
+	elektraGetWorker (&pool);
+	for (size_t w = 0; w < started; ++w)
+	{
+		pthread_join (workers[w], 0);
+	}
+	pthread_mutex_destroy (&pool.mutex);
+	elektraFree (workers);
+
+	int ret = 0;
+	for (size_t i = 0; i < split->size - bypassedSplits; ++i)
+	{
+		if (!test_bit (split->syncbits[i], SPLIT_FLAG_SYNC)) continue;
+
+		if (!pool.parents[i])
+		{
+			// not thread-safe, update it now
+			if (elektraGetDoUpdateBackend (split, i, parentKey, handle) == -1)
 			{
-				ret = backend->getplugins[p]->kdbGet (backend->getplugins[p], split->keysets[i], parentKey);
+				ret = -1;
+				break;
 			}
-			if (ret == -1)
+			continue;
+		}
+
+		elektraGetMergeMeta (parentKey, pool.parents[i], before);
+		elektraGetCopyWarnings (parentKey, pool.parents[i]);
+		keySetName (parentKey, keyName (pool.parents[i]));
+		keySetString (parentKey, keyString (pool.parents[i]));
+		if (pool.rets[i] == -1)
+		{
+			const Key * meta;
+			keyRewindMeta (pool.parents[i]);
+			while ((meta = keyNextMeta (pool.parents[i])) != 0)
 			{
-				// Ohh, an error occurred,
-				// lets stop the process.
-				return -1;
+				const char * name = keyName (meta);
+				if (!strncmp (name, "error", 5) && (name[5] == '\0' || name[5] == '/'))
+				{
+					keyCopyMeta (parentKey, pool.parents[i], name);
+				}
 			}
+			ret = -1;
+			break;
 		}
 	}
-	return 0;
+
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		keyDel (pool.parents[i]);
+	}
+	keyDel (before);
+	elektraFree (pool.jobs);
+	elektraFree (pool.parents);
+	elektraFree (pool.rets);
+	return ret;
+}
+
+#endif
+
+/**
+ * @internal
+ * @brief Do the real update.
+ *
+ * @param handle the handle with the number of threads which may be used
+ *        to update backends in parallel
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ */
+static int elektraGetDoUpdate (Split * split, Key * parentKey, KDB * handle)
+{
+#ifdef HAVE_PTHREAD
+	if (handle->threads > 1) return elektraGetDoUpdateParallel (split, parentKey, handle);
+#endif
+	return elektraGetDoUpdateSequential (split, parentKey, handle);
 }
 
 
@@ -583,6 +1156,10 @@ static int elektraGetDoUpdate (Split * split, Key * parentKey)
  * If you want to get the same keyset again, you need to open a
  * second handle to the key database using kdbOpen().
  *
+ * From now on, the keyset records which of its keys get changed,
+ * added or removed, so that kdbSet() only needs to look at them.
+ * Changes of keys which were retrieved again are forgotten.
+ *
  * @param handle contains internal information of @link kdbOpen() opened @endlink key database
  * @param parentKey is used to add warnings and set an error
  *         information. Additionally, its name is an hint which keys
@@ -643,11 +1220,13 @@ int kdbGet (KDB * handle, KeySet * ks, Key * parentKey)
 		ELEKTRA_SET_ERROR (38, parentKey, "error in elektraSplitBuildup");
 		goto error;
 	}
+	elektraLoadBackends (split, parentKey);
 
 	// Check if a update is needed at all
 	switch (elektraGetCheckUpdateNeeded (split, parentKey))
 	{
 	case 0: // We don't need an update so let's do nothing
+		if (!ks->changes) elektraKsTrack (ks);
 		keySetName (parentKey, keyName (initialParent));
 		elektraSplitUpdateFileName (split, handle, parentKey);
 		keyDel (initialParent);
@@ -668,7 +1247,7 @@ int kdbGet (KDB * handle, KeySet * ks, Key * parentKey)
 
 	/* Now do the real updating,
 	  but not for bypassed keys in split->size-1 */
-	if (elektraGetDoUpdate (split, parentKey) == -1)
+	if (elektraGetDoUpdate (split, parentKey, handle) == -1)
 	{
 		goto error;
 	}
@@ -681,9 +1260,11 @@ int kdbGet (KDB * handle, KeySet * ks, Key * parentKey)
 	}
 
 	/* We are finished, now just merge everything to returned */
+	KeySetChanges * changes = elektraKsUntrack (ks);
 	ksClear (ks);
 	elektraSplitMerge (split, ks);
 	ksRewind (ks);
+	elektraGetTrackChanges (split, handle, ks, changes);
 
 	keySetName (parentKey, keyName (initialParent));
 	if (handle->globalPlugins[POSTGETSTORAGE])
@@ -909,6 +1490,11 @@ static void elektraSetRollback (Split * split, Key * parentKey)
  * only changed keys are updated. If no key of a backend needs to be synced
  * any affairs to backends are omitted and 0 is returned.
  *
+ * If @p ks was returned by kdbGet(), it knows which keys were changed,
+ * added or removed since then. Only the backends of these keys are
+ * looked at, so the effort depends on the number of changes and not
+ * on the size of @p ks. Otherwise every key is checked.
+ *
  * @snippet kdbset.c set
  *
  * showElektraErrorDialog() and doElektraMerge() need to be implemented
@@ -973,18 +1559,25 @@ int kdbSet (KDB * handle, KeySet * ks, Key * parentKey)
 		ELEKTRA_SET_ERROR (38, parentKey, "error in elektraSplitBuildup");
 		goto error;
 	}
+	elektraLoadBackends (split, parentKey);
+
+	// the changes are known if ks was tracked since kdbGet()
+	KeySet * changes = elektraKsChanges (ks);
 
 	// 1.) Search for syncbits
-	int syncstate = elektraSplitDivide (split, handle, ks);
+	Key * withoutBackend = 0;
+	int syncstate = changes ? elektraSplitDivideChanges (split, handle, ks, changes, &withoutBackend)
+				: elektraSplitDivide (split, handle, ks);
 	if (syncstate == -1)
 	{
-		ELEKTRA_SET_ERROR (8, parentKey, keyName (ksCurrent (ks)));
+		if (!changes) withoutBackend = ksCurrent (ks);
+		ELEKTRA_SET_ERROR (8, parentKey, keyName (withoutBackend));
 		goto error;
 	}
 	ELEKTRA_ASSERT (syncstate == 0 || syncstate == 1);
 
-	// 2.) Search for changed sizes
-	syncstate |= elektraSplitSync (split);
+	// 2.) Search for changed sizes (removed keys are part of the changes)
+	syncstate |= changes ? elektraSplitSyncState (split) : elektraSplitSync (split);
 	ELEKTRA_ASSERT (syncstate == 0 || syncstate == 1);
 	if (syncstate != 1)
 	{
@@ -1028,10 +1621,23 @@ int kdbSet (KDB * handle, KeySet * ks, Key * parentKey)
 		handle->globalPlugins[POSTCOMMIT]->kdbSet (handle->globalPlugins[POSTCOMMIT], ks, parentKey);
 	}
 
-	for (size_t i = 0; i < ks->size; ++i)
+	if (changes)
+	{
+		// only changed keys can have flags
+		for (size_t i = 0; i < changes->size; ++i)
+		{
+			Key * cur = ksLookup (ks, changes->array[i], KDB_O_NOCASCADING);
+			if (cur) clear_bit (cur->flags, KEY_FLAG_SYNC);
+		}
+		ksClear (changes);
+	}
+	else
 	{
-		// remove all flags from all keys
-		clear_bit (ks->array[i]->flags, KEY_FLAG_SYNC);
+		for (size_t i = 0; i < ks->size; ++i)
+		{
+			// remove all flags from all keys
+			clear_bit (ks->array[i]->flags, KEY_FLAG_SYNC);
+		}
 	}
 
 	keySetName (parentKey, keyName (initialParent));
@@ -78,17 +78,186 @@
  * @internal
  *
  * Allocates and initializes a key
+ *
+ * The key is allocated together with a buffer of @p inlineSize
+ * bytes, so that short names and values need no extra allocation.
+ *
+ * @param arena the arena to allocate the key from, 0 for the heap
  * @returns 0 if allocation did not work, the key otherwise
  */
-static Key * elektraKeyMalloc ()
+static Key * elektraKeyMalloc (ElektraArena * arena, size_t inlineSize)
 {
-	Key * key = (Key *)elektraMalloc (sizeof (Key));
+	if (inlineSize > KEY_INLINE_MAX_SIZE) inlineSize = KEY_INLINE_MAX_SIZE;
+
+	Key * key = (Key *)(arena ? elektraArenaAlloc (arena, sizeof (Key) + inlineSize) : elektraMalloc (sizeof (Key) + inlineSize));
 	if (!key) return 0;
 	keyInit (key);
+	key->inlineSize = inlineSize;
+	key->arena = arena;
 
 	return key;
 }
 
+/**
+ * @internal
+ *
+ * @return the buffer directly after the key structure
+ */
+static char * elektraKeyInlineBuffer (const Key * key)
+{
+	return (char *)key + sizeof (Key);
+}
+
+/**
+ * @internal
+ *
+ * Where a value of @p size bytes would be placed within the
+ * inline buffer, if the name occupies its first @p nameSize bytes.
+ *
+ * Values are placed at the end of the buffer, so that a name set
+ * after the value (as keyNew() does) still fits in front of it.
+ *
+ * @retval 0 if the value does not fit
+ */
+static char * elektraKeyInlineValueAt (const Key * key, size_t nameSize, size_t size)
+{
+	const size_t end = sizeof (Key) + key->inlineSize;
+	if (size > key->inlineSize) return 0;
+
+	// malloc returns suitably aligned memory, so keep the offset aligned
+	const size_t offset = (end - size) / KEY_INLINE_ALIGN * KEY_INLINE_ALIGN;
+	if (offset < sizeof (Key) + nameSize) return 0;
+	return (char *)key + offset;
+}
+
+/**
+ * @internal
+ *
+ * Check if a name or value is stored within the key itself.
+ *
+ * Such buffers must neither be freed nor reallocated.
+ *
+ * @param key the key the buffer belongs to
+ * @param buffer the name or value of the key
+ *
+ * @retval 1 if @p buffer is within the inline buffer of the key
+ * @retval 0 if @p buffer was allocated separately (or is NULL)
+ */
+int elektraKeyIsInline (const Key * key, const void * buffer)
+{
+	const char * begin = elektraKeyInlineBuffer (key);
+	return (const char *)buffer >= begin && (const char *)buffer < begin + key->inlineSize;
+}
+
+/**
+ * @internal
+ *
+ * Check if a name or value is not owned by the key.
+ *
+ * This is the case for buffers within the key itself and for
+ * buffers within memory adopted by the arena of the key.
+ * Such buffers must neither be freed nor reallocated.
+ *
+ * @param key the key the buffer belongs to
+ * @param buffer the name or value of the key
+ *
+ * @retval 1 if @p buffer must not be freed
+ * @retval 0 if @p buffer was allocated separately (or is NULL)
+ * @see elektraArenaAdopt()
+ */
+int elektraKeyIsBorrowed (const Key * key, const void * buffer)
+{
+	if (elektraKeyIsInline (key, buffer)) return 1;
+	return key->arena && elektraArenaIsAdopted (key->arena, buffer);
+}
+
+/**
+ * @internal
+ *
+ * Create a key within @p arena which uses the given name and
+ * value without copying them.
+ *
+ * @pre name and value are within memory adopted by @p arena
+ * @see elektraArenaKeyView()
+ */
+Key * elektraKeyViewIn (ElektraArena * arena, const char * name, size_t nameSize, size_t unescapedSize, const void * value,
+			size_t valueSize)
+{
+	Key * key = elektraKeyMalloc (arena, 0);
+	if (!key) return 0;
+
+	key->key = (char *)name;
+	key->keySize = nameSize;
+	key->keyUSize = unescapedSize;
+	key->data.v = valueSize ? (void *)value : 0;
+	key->dataSize = valueSize;
+	key->flags = KEY_FLAG_SYNC;
+
+	return key;
+}
+
+/**
+ * @internal
+ *
+ * Find room for a value within the inline buffer of the key.
+ *
+ * @param key the key to store the value in
+ * @param size the size of the value
+ * @return pointer where the value can be stored
+ * @retval 0 if the value does not fit into the inline buffer
+ */
+char * elektraKeyInlineValue (Key * key, size_t size)
+{
+	return elektraKeyInlineValueAt (key, elektraKeyIsInline (key, key->key) ? key->keySize + key->keyUSize : 0, size);
+}
+
+/**
+ * @internal
+ *
+ * Make sure that the name buffer of the key can hold @p size bytes.
+ *
+ * Uses the inline buffer of the key if the name fits, otherwise
+ * the name will be (re)allocated.
+ *
+ * @param key the key to resize the name buffer of
+ * @param size the needed size of the buffer (escaped + unescaped name)
+ * @param keep how many bytes of the current name need to be kept
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error (name is unchanged then)
+ */
+int elektraKeyReserveName (Key * key, size_t size, size_t keep)
+{
+	char * buffer = elektraKeyInlineBuffer (key);
+	size_t available = key->inlineSize;
+	if (elektraKeyIsInline (key, key->data.c))
+	{
+		available = key->data.c - buffer;
+	}
+
+	if (size <= available)
+	{
+		if (key->key != buffer)
+		{
+			if (keep) memcpy (buffer, key->key, keep);
+			if (!elektraKeyIsBorrowed (key, key->key)) elektraFree (key->key);
+			key->key = buffer;
+		}
+		return 0;
+	}
+
+	if (elektraKeyIsBorrowed (key, key->key))
+	{
+		char * name = elektraMalloc (size);
+		if (!name) return -1;
+		if (keep) memcpy (name, key->key, keep);
+		key->key = name;
+		return 0;
+	}
+
+	return elektraRealloc ((void **)&key->key, size);
+}
+
 
 /**
  * A practical way to fully create a Key object in one step.
@@ -189,16 +358,9 @@ Key * keyNew (const char * name, ...)
 	Key * k;
 	va_list va;
 
-	if (!name)
-	{
-		k = elektraKeyMalloc ();
-	}
-	else
-	{
-		va_start (va, name);
-		k = keyVNew (name, va);
-		va_end (va);
-	}
+	va_start (va, name);
+	k = keyVNew (name, va);
+	va_end (va);
 
 	return k;
 }
@@ -212,7 +374,28 @@ Key * keyNew (const char * name, ...)
  */
 Key * keyVNew (const char * name, va_list va)
 {
-	Key * key = elektraKeyMalloc ();
+	return elektraKeyVNewIn (0, name, va);
+}
+
+/**
+ * @internal
+ *
+ * keyVNew() which allocates the key from @p arena.
+ *
+ * @param arena the arena to allocate from, 0 for the heap
+ * @see elektraArenaKeyNew()
+ */
+Key * elektraKeyVNewIn (ElektraArena * arena, const char * name, va_list va)
+{
+	if (!name)
+	{
+		// the name is usually set later on
+		return elektraKeyMalloc (arena, KEY_INLINE_NAME_SIZE + KEY_INLINE_VALUE_SIZE);
+	}
+
+	// room for escaped and unescaped name and a short value
+	const size_t nameSize = strlen (name) + 1;
+	Key * key = elektraKeyMalloc (arena, 2 * nameSize + KEY_INLINE_ALIGN + KEY_INLINE_VALUE_SIZE);
 	if (!key) return 0;
 	keyVInit (key, name, va);
 	return key;
@@ -265,20 +448,43 @@ int g (const Key * source, KeySet * ks)
  * @ingroup key
  */
 Key * keyDup (const Key * source)
+{
+	return elektraKeyDupIn (0, source);
+}
+
+/**
+ * @internal
+ *
+ * keyDup() which allocates the key from @p arena.
+ *
+ * Keys within an arena get extra room for a longer name,
+ * because parsers often dup a parent key and extend its name.
+ *
+ * @param arena the arena to allocate from, 0 for the heap
+ * @see elektraArenaKeyDup()
+ */
+Key * elektraKeyDupIn (ElektraArena * arena, const Key * source)
 {
 	Key * dest = 0;
 
 	if (!source) return 0;
 
-	dest = elektraKeyMalloc ();
+	size_t inlineSize = source->data.v ? KEY_INLINE_ALIGN + source->dataSize : 0;
+	if (source->key) inlineSize += source->keySize + source->keyUSize;
+	if (arena) inlineSize += 2 * KEY_INLINE_NAME_SIZE;
+	dest = elektraKeyMalloc (arena, inlineSize);
 	if (!dest) return 0;
 
 	/* Copy the struct data */
+	inlineSize = dest->inlineSize;
 	*dest = *source;
+	dest->inlineSize = inlineSize;
+	dest->arena = arena;
 
 	/* get rid of properties bound to old key */
 	dest->ksReference = 0;
 	dest->flags = KEY_FLAG_SYNC;
+	dest->changes = 0;
 
 	/* prepare to set dynamic properties */
 	dest->key = dest->data.v = dest->meta = 0;
@@ -364,39 +570,56 @@ int keyCopy (Key * dest, const Key * source)
 	void * destData = dest->data.c;
 	KeySet * destMeta = dest->meta;
 
+	// use the inline buffer where possible
+	const size_t nameSize = source->key ? source->keySize + source->keyUSize : 0;
+	char * inlineName = nameSize && nameSize <= dest->inlineSize ? elektraKeyInlineBuffer (dest) : 0;
+	char * inlineData = source->data.v ? elektraKeyInlineValueAt (dest, inlineName ? nameSize : 0, source->dataSize) : 0;
+
+	char * newKey = 0;
+	void * newData = 0;
+	KeySet * newMeta = 0;
+
 	// duplicate dynamic properties
-	if (source->key)
-	{
-		dest->key = elektraStrNDup (source->key, source->keySize + source->keyUSize);
-		if (!dest->key) goto memerror;
-	}
-	else
+	if (source->key && !inlineName)
 	{
-		dest->key = 0;
+		newKey = elektraStrNDup (source->key, nameSize);
+		if (!newKey) goto memerror;
 	}
 
-	if (source->data.v)
+	if (source->data.v && !inlineData)
 	{
-		dest->data.v = elektraStrNDup (source->data.v, source->dataSize);
-		if (!dest->data.v) goto memerror;
+		newData = elektraStrNDup (source->data.v, source->dataSize);
+		if (!newData) goto memerror;
 	}
-	else
+
+	if (source->meta)
 	{
-		dest->data.v = 0;
+		newMeta = ksDup (source->meta);
+		if (!newMeta) goto memerror;
 	}
 
-	if (source->meta)
+	// successful, now do the irreversible stuff: we obviously modified dest
+	elektraKeyChanged (dest);
+
+	// source and dest might be the same, so use memmove
+	if (inlineName)
 	{
-		dest->meta = ksDup (source->meta);
-		if (!dest->meta) goto memerror;
+		memmove (inlineName, source->key, nameSize);
+		newKey = inlineName;
 	}
-	else
+
+	if (inlineData)
 	{
-		dest->meta = 0;
+		memmove (inlineData, source->data.v, source->dataSize);
+		newData = inlineData;
 	}
 
-	// successful, now do the irreversible stuff: we obviously modified dest
-	set_bit (dest->flags, KEY_FLAG_SYNC);
+	dest->key = newKey;
+	dest->data.v = newData;
+	dest->meta = newMeta;
+
+	// the meta keys are shared, so the owner can be shared too
+	dest->owner = source->owner;
 
 	// copy sizes accordingly
 	dest->keySize = source->keySize;
@@ -404,20 +627,16 @@ int keyCopy (Key * dest, const Key * source)
 	dest->dataSize = source->dataSize;
 
 	// free old resources of destination
-	elektraFree (destKey);
-	elektraFree (destData);
+	if (!elektraKeyIsBorrowed (dest, destKey)) elektraFree (destKey);
+	if (!elektraKeyIsBorrowed (dest, destData)) elektraFree (destData);
 	ksDel (destMeta);
 
 	return 1;
 
 memerror:
-	elektraFree (dest->key);
-	elektraFree (dest->data.v);
-	ksDel (dest->meta);
-
-	dest->key = destKey;
-	dest->data.v = destData;
-	dest->meta = destMeta;
+	elektraFree (newKey);
+	elektraFree (newData);
+	ksDel (newMeta);
 	return -1;
 }
 
@@ -461,7 +680,15 @@ int keyDel (Key * key)
 	}
 
 	rc = keyClear (key);
-	elektraFree (key);
+	elektraKsChangesRelease (key->changes);
+	if (key->arena)
+	{
+		elektraArenaRelease (key->arena);
+	}
+	else
+	{
+		elektraFree (key);
+	}
 
 	return rc;
 }
@@ -503,10 +730,16 @@ int keyClear (Key * key)
 	}
 
 	size_t ref = 0;
+	unsigned int inlineSize = 0;
+	ElektraArena * arena = 0;
+	KeySetChanges * changes = 0;
 
 	ref = key->ksReference;
-	if (key->key) elektraFree (key->key);
-	if (key->data.v) elektraFree (key->data.v);
+	inlineSize = key->inlineSize;
+	arena = key->arena;
+	changes = key->changes;
+	if (key->key && !elektraKeyIsBorrowed (key, key->key)) elektraFree (key->key);
+	if (key->data.v && !elektraKeyIsBorrowed (key, key->data.v)) elektraFree (key->data.v);
 	if (key->meta) ksDel (key->meta);
 
 	keyInit (key);
@@ -514,6 +747,9 @@ int keyClear (Key * key)
 
 	/* Set reference properties */
 	key->ksReference = ref;
+	key->inlineSize = inlineSize;
+	key->arena = arena;
+	key->changes = changes;
 
 	return 0;
 }
@@ -344,7 +344,11 @@ void keyVInit (Key * key, const char * name, va_list va)
 
 	if (!key) return;
 
+	const unsigned int inlineSize = key->inlineSize;
+	ElektraArena * arena = key->arena;
 	keyInit (key);
+	key->inlineSize = inlineSize;
+	key->arena = arena;
 
 	if (name)
 	{
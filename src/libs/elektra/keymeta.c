@@ -324,6 +324,7 @@ int keyCopyMeta (Key * dest, const Key * source, const char * metaName)
 
 	// now we can simply append that key
 	ksAppendKey (dest->meta, ret);
+	elektraKeyUpdateOwner (dest);
 
 	return 1;
 }
@@ -380,12 +381,75 @@ int keyCopyAllMeta (Key * dest, const Key * source)
 		{
 			dest->meta = ksDup (source->meta);
 		}
+		elektraKeyUpdateOwner (dest);
 		return 1;
 	}
 
 	return 0;
 }
 
+/**
+ * @internal
+ *
+ * Maximum size of meta names (including null byte) which can be
+ * looked up without allocation.
+ */
+#define ELEKTRA_META_SEARCH_SIZE 128
+
+/**
+ * @internal
+ *
+ * @brief Sets up a key on the stack to look up meta data without allocation
+ *
+ * The name and the unescaped name are written to @p buffer, which
+ * must have a size of 2 * #ELEKTRA_META_SEARCH_SIZE.
+ *
+ * This only works for meta names which are already canonical and do
+ * not need any unescaping: no backslashes, no empty parts (leading,
+ * trailing or double slashes), no parts ".", ".." or "%" and no owner.
+ * This is true for all meta names commonly used, e.g. "check/type".
+ *
+ * @param search the key to set up, must be initialized with keyInit()
+ * @param buffer where the name is stored
+ * @param metaName the name of the meta data
+ *
+ * @retval 1 if @p search can be used for ksLookup()
+ * @retval 0 if the name needs to be set with elektraKeySetName()
+ */
+static int elektraMetaSearchKey (Key * search, char * buffer, const char * metaName)
+{
+	const char * part = metaName;
+	const char * c = metaName;
+
+	for (;; ++c)
+	{
+		if (*c == '\\') return 0;
+		if (*c != '/' && *c != '\0') continue;
+
+		size_t const partSize = c - part;
+		if (partSize == 0) return 0;
+		if (partSize == 1 && (*part == '.' || *part == '%')) return 0;
+		if (partSize == 2 && part[0] == '.' && part[1] == '.') return 0;
+		if (*c == '\0') break;
+		part = c + 1;
+	}
+
+	size_t const size = c - metaName + 1;
+	if (size > ELEKTRA_META_SEARCH_SIZE) return 0;
+	if (!strncmp (metaName, "user:", sizeof ("user:") - 1)) return 0;
+
+	memcpy (buffer, metaName, size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		buffer[size + i] = metaName[i] == '/' ? '\0' : metaName[i];
+	}
+
+	search->key = buffer;
+	search->keySize = size;
+	search->keyUSize = size;
+	return 1;
+}
+
 /**Returns the Value of a Meta-Information given by name.
  *
  * This is a much more efficient version of keyGetMeta().
@@ -422,6 +486,16 @@ const Key * keyGetMeta (const Key * key, const char * metaName)
 	if (!metaName) return 0;
 	if (!key->meta) return 0;
 
+	// optimization: most meta names can be looked up without
+	// allocating a search key
+	struct _Key stackSearch;
+	char buffer[ELEKTRA_META_SEARCH_SIZE * 2];
+	keyInit (&stackSearch);
+	if (elektraMetaSearchKey (&stackSearch, buffer, metaName))
+	{
+		return ksLookup (key->meta, &stackSearch, 0);
+	}
+
 	search = keyNew (0);
 	elektraKeySetName (search, metaName, KEY_META_NAME | KEY_EMPTY_NAME);
 
@@ -432,6 +506,71 @@ const Key * keyGetMeta (const Key * key, const char * metaName)
 	return ret;
 }
 
+/**
+ * @brief Resolve the name of meta data once for keyGetMetaAtom()
+ *
+ * Plugins which look up the same meta data for many keys can resolve
+ * the meta names once (e.g. in kdbOpen()) and then use
+ * keyGetMetaAtom() which does not need to process the name again.
+ *
+ * @code
+Key * typeAtom = keyMetaAtom ("check/type");
+// for every key:
+const Key * type = keyGetMetaAtom (key, typeAtom);
+// when finished:
+keyDel (typeAtom);
+ * @endcode
+ *
+ * @param metaName the name of the meta data
+ * @return a new key which represents the meta name, it must be
+ *         freed with keyDel()
+ * @retval 0 on NULL pointer, invalid name or memory problems
+ * @see keyGetMetaAtom()
+ * @ingroup proposal
+ */
+Key * keyMetaAtom (const char * metaName)
+{
+	if (!metaName) return 0;
+
+	Key * atom = keyNew (0);
+	if (!atom) return 0;
+
+	if (elektraKeySetName (atom, metaName, KEY_META_NAME | KEY_EMPTY_NAME) == -1)
+	{
+		keyDel (atom);
+		return 0;
+	}
+
+	set_bit (atom->flags, KEY_FLAG_RO_NAME);
+	set_bit (atom->flags, KEY_FLAG_RO_VALUE);
+	set_bit (atom->flags, KEY_FLAG_RO_META);
+
+	return atom;
+}
+
+/**
+ * @brief Returns the meta data given by a resolved meta name.
+ *
+ * Does the same as keyGetMeta(), but with a meta name resolved
+ * by keyMetaAtom().
+ *
+ * @param key the key object to work with
+ * @param atom the meta name returned by keyMetaAtom()
+ * @retval 0 if the key or atom is 0
+ * @retval 0 if no such meta data is found
+ * @return the meta key if found
+ * @see keyMetaAtom(), keyGetMeta()
+ * @ingroup proposal
+ */
+const Key * keyGetMetaAtom (const Key * key, const Key * atom)
+{
+	if (!key) return 0;
+	if (!atom) return 0;
+	if (!key->meta) return 0;
+
+	return ksLookup (key->meta, (Key *)atom, 0);
+}
+
 
 /**Set a new Meta-Information.
  *
@@ -461,7 +600,6 @@ const Key * keyGetMeta (const Key * key, const char * metaName)
 ssize_t keySetMeta (Key * key, const char * metaName, const char * newMetaString)
 {
 	Key * toSet;
-	char * metaStringDup;
 	ssize_t metaNameSize;
 	ssize_t metaStringSize = 0;
 
@@ -480,6 +618,8 @@ ssize_t keySetMeta (Key * key, const char * metaName, const char * newMetaString
 
 	elektraKeySetName (toSet, metaName, KEY_META_NAME | KEY_EMPTY_NAME);
 
+	const int isOwner = !strcmp (keyName (toSet), "owner");
+
 	/*Lets have a look if the key is already inserted.*/
 	if (key->meta)
 	{
@@ -488,26 +628,22 @@ ssize_t keySetMeta (Key * key, const char * metaName, const char * newMetaString
 		if (ret)
 		{
 			/*It was already there, so lets drop that one*/
+			if (isOwner) key->owner = 0;
 			keyDel (ret);
-			key->flags |= KEY_FLAG_SYNC;
+			elektraKeyChanged (key);
 		}
 	}
 
 	if (newMetaString)
 	{
 		/*Add the meta information to the key*/
-		metaStringDup = elektraStrNDup (newMetaString, metaStringSize);
-		if (!metaStringDup)
+		if (keySetRaw (toSet, newMetaString, metaStringSize) == -1)
 		{
 			// TODO: actually we might already have changed
 			// the key
 			keyDel (toSet);
 			return -1;
 		}
-
-		if (toSet->data.v) elektraFree (toSet->data.v);
-		toSet->data.c = metaStringDup;
-		toSet->dataSize = metaStringSize;
 	}
 	else
 	{
@@ -533,6 +669,22 @@ ssize_t keySetMeta (Key * key, const char * metaName, const char * newMetaString
 	set_bit (toSet->flags, KEY_FLAG_RO_META);
 
 	ksAppendKey (key->meta, toSet);
-	key->flags |= KEY_FLAG_SYNC;
+	if (isOwner) key->owner = toSet->data.c;
+	elektraKeyChanged (key);
 	return metaStringSize;
 }
+
+/**
+ * @internal
+ *
+ * Update the cached owner of a key.
+ *
+ * Needs to be called whenever the meta data "owner" of the key
+ * might have changed.
+ *
+ * @param key the key to update
+ */
+void elektraKeyUpdateOwner (Key * key)
+{
+	key->owner = keyValue (keyGetMeta (key, "owner"));
+}
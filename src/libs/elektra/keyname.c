@@ -390,7 +390,8 @@ ssize_t elektraFinalizeName (Key * key)
 
 ssize_t elektraFinalizeEmptyName (Key * key)
 {
-	key->key = elektraCalloc (2); // two null pointers
+	if (elektraKeyReserveName (key, 2, 0) == -1) return -1;
+	key->key[0] = key->key[1] = 0; // two null pointers
 	key->keySize = 1;
 	key->keyUSize = 1;
 	key->flags |= KEY_FLAG_SYNC;
@@ -422,7 +423,7 @@ static void elektraHandleUserName (Key * key, const char * newName)
 
 static void elektraRemoveKeyName (Key * key)
 {
-	if (key->key) elektraFree (key->key);
+	if (key->key && !elektraKeyIsBorrowed (key, key->key)) elektraFree (key->key);
 	key->key = 0;
 	key->keySize = 0;
 	key->keyUSize = 0;
@@ -554,7 +555,7 @@ ssize_t elektraKeySetName (Key * key, const char * newName, option_t options)
 	} // Note that we abused keyUSize for cascading and user:owner
 
 	const size_t length = elektraStrLen (newName);
-	key->key = elektraMalloc (key->keySize * 2);
+	if (elektraKeyReserveName (key, key->keySize * 2, 0) == -1) return -1;
 	memcpy (key->key, newName, key->keySize);
 	if (length == key->keyUSize || length == key->keySize)
 	{ // use || because full length is keyUSize in user, but keySize for /
@@ -848,6 +849,7 @@ ssize_t keyAddBaseName (Key * key, const char * baseName)
 	char * escaped = elektraMalloc (strlen (baseName) * 2 + 2);
 	elektraEscapeKeyNamePart (baseName, escaped);
 	size_t len = strlen (escaped);
+	const size_t origSize = key->keySize;
 	if (!strcmp (key->key, "/"))
 	{
 		key->keySize += len;
@@ -857,9 +859,9 @@ ssize_t keyAddBaseName (Key * key, const char * baseName)
 		key->keySize += len + 1;
 	}
 
-	elektraRealloc ((void **)&key->key, key->keySize * 2);
-	if (!key->key)
+	if (elektraKeyReserveName (key, key->keySize * 2, origSize) == -1)
 	{
+		key->keySize = origSize;
 		elektraFree (escaped);
 		return -1;
 	}
@@ -965,8 +967,7 @@ ssize_t keyAddName (Key * key, const char * newName)
 
 	const size_t origSize = key->keySize;
 	const size_t newSize = origSize + nameSize;
-	elektraRealloc ((void **)&key->key, newSize * 2);
-	if (!key->key) return -1;
+	if (elektraKeyReserveName (key, newSize * 2, origSize) == -1) return -1;
 
 	size_t size = 0;
 	const char * p = newName;
@@ -1091,8 +1092,7 @@ ssize_t keySetBaseName (Key * key, const char * baseName)
 	elektraEscapeKeyNamePart (baseName, escaped);
 	size_t sizeEscaped = elektraStrLen (escaped);
 
-	elektraRealloc ((void **)&key->key, (key->keySize + sizeEscaped) * 2);
-	if (!key->key)
+	if (elektraKeyReserveName (key, (key->keySize + sizeEscaped) * 2, key->keySize) == -1)
 	{
 		elektraFree (escaped);
 		return -1;
@@ -195,19 +195,83 @@ KeySet * ksVNew (size_t alloc, va_list va)
 
 	if (alloc != 1) // is >0 because of increment earlier
 	{
+		// collect the keys first and sort them only once
 		key = (struct _Key *)va_arg (va, struct _Key *);
 		while (key)
 		{
-			ksAppendKey (keyset, key);
+			if (!key->key)
+			{
+				keyDel (key); // like ksAppendKey() does
+			}
+			else
+			{
+				elektraKeyLock (key, KEY_LOCK_NAME);
+				keyIncRef (key);
+				keyset->array[keyset->size++] = key;
+				if (keyset->size >= keyset->alloc) ksResize (keyset, keyset->alloc * 2 - 1);
+			}
 			key = (struct _Key *)va_arg (va, struct _Key *);
 		}
+		keyset->size = elektraKsSortUnique (keyset->array, keyset->size);
+		keyset->array[keyset->size] = 0;
 	}
 
-	ksRewind (keyset); // ksAppendKey changed the internal cursor
+	ksRewind (keyset);
 
 	return keyset;
 }
 
+/**
+ * @internal
+ *
+ * Remove the key set from the ring of key sets sharing its array.
+ */
+static void elektraKsUnlink (KeySet * ks)
+{
+	KeySet * prev = ks->sharedPrev;
+	KeySet * next = ks->sharedNext;
+
+	if (prev == next)
+	{
+		// only one key set is left, it owns the array now
+		prev->sharedPrev = prev->sharedNext = 0;
+	}
+	else
+	{
+		prev->sharedNext = next;
+		next->sharedPrev = prev;
+	}
+
+	ks->sharedPrev = ks->sharedNext = 0;
+}
+
+/**
+ * @internal
+ *
+ * Give the key set an array of its own, if it shares
+ * the array with other key sets.
+ *
+ * Needs to be called before the array gets modified.
+ *
+ * @param ks the key set which will be modified
+ * @retval 0 on success
+ * @retval -1 on memory error (the key set is unchanged then)
+ * @see ksDup()
+ */
+int elektraKsUnshare (KeySet * ks)
+{
+	if (!ks->sharedNext) return 0;
+
+	Key ** array = elektraMalloc (sizeof (struct _Key *) * ks->alloc);
+	if (!array) return -1;
+	memcpy (array, ks->array, sizeof (struct _Key *) * (ks->size + 1));
+
+	elektraKsUnlink (ks);
+	ks->array = array;
+
+	return 0;
+}
+
 /**
  * Return a duplicate of a keyset.
  *
@@ -220,6 +284,11 @@ KeySet * ksVNew (size_t alloc, va_list va)
  * but there reference counter is updated, so both keysets
  * need ksDel().
  *
+ * The duplicate shares the internal array with @p source
+ * until one of them gets modified (copy on write), so
+ * no array needs to be copied for duplicates which are
+ * only read.
+ *
  * @param source has to be an initialized source KeySet
  * @return a flat copy of source on success
  * @retval 0 on NULL pointer
@@ -230,8 +299,34 @@ KeySet * ksDup (const KeySet * source)
 {
 	if (!source) return 0;
 
-	KeySet * keyset = ksNew (source->alloc, KS_END);
-	ksAppend (keyset, source);
+	if (!source->array)
+	{
+		return ksNew (0, KS_END);
+	}
+
+	KeySet * keyset = (KeySet *)elektraMalloc (sizeof (KeySet));
+	if (!keyset) return 0;
+	ksInit (keyset);
+
+	// sharing does not change the content of source
+	KeySet * shared = (KeySet *)source;
+	keyset->array = shared->array;
+	keyset->size = shared->size;
+	keyset->alloc = shared->alloc;
+
+	keyset->sharedPrev = shared;
+	keyset->sharedNext = shared->sharedNext ? shared->sharedNext : shared;
+	keyset->sharedNext->sharedPrev = keyset;
+	shared->sharedNext = keyset;
+
+	for (size_t i = 0; i < keyset->size; ++i)
+	{
+		keyIncRef (keyset->array[i]);
+	}
+
+	// like ksAppend() the cursor is on the last key
+	if (keyset->size > 0) ksSetCursor (keyset, keyset->size - 1);
+
 	return keyset;
 }
 
@@ -350,6 +445,7 @@ int ksDel (KeySet * ks)
 	if (!ks) return -1;
 
 	rc = ksClose (ks);
+	elektraKsChangesRelease (ks->changes);
 	elektraFree (ks);
 
 	return rc;
@@ -371,6 +467,11 @@ int ksDel (KeySet * ks)
  */
 int ksClear (KeySet * ks)
 {
+	for (size_t i = 0; ks->changes && i < ks->size; ++i)
+	{
+		elektraKsChangesAdd (ks->changes, ks->array[i]);
+	}
+
 	ksClose (ks);
 	// ks->array empty now
 
@@ -486,8 +587,8 @@ static int keyCompareByOwner (const void * p1, const void * p2)
 {
 	Key * key1 = *(Key **)p1;
 	Key * key2 = *(Key **)p2;
-	const char * owner1 = keyValue (keyGetMeta (key1, "owner"));
-	const char * owner2 = keyValue (keyGetMeta (key2, "owner"));
+	const char * owner1 = key1->owner;
+	const char * owner2 = key2->owner;
 	if (!owner1 && !owner2) return 0;
 	if (!owner1) return -1;
 	if (!owner2) return 1;
@@ -796,6 +897,8 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 		return -1;
 	}
 
+	if (elektraKsUnshare (ks) == -1) return -1;
+
 	elektraKeyLock (toAppend, KEY_LOCK_NAME);
 
 	result = ksSearchInternal (ks, toAppend);
@@ -817,6 +920,7 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 		keyIncRef (toAppend);
 		ks->array[result] = toAppend;
 		ksSetCursor (ks, result);
+		/* the index is still valid: same name, same position */
 	}
 	else
 	{
@@ -834,6 +938,7 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 			ks->array[ks->size - 1] = toAppend;
 			ks->array[ks->size] = 0;
 			ksSetCursor (ks, ks->size - 1);
+			elektraKsIndexAppend (ks, ks->size - 1);
 		}
 		else
 		{
@@ -845,9 +950,16 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
 			*/
 			ks->array[insertpos] = toAppend;
 			ksSetCursor (ks, insertpos);
+			elektraKsIndexInvalidate (ks);
 		}
 	}
 
+	if (ks->changes)
+	{
+		elektraKsChangesAdd (ks->changes, toAppend);
+		elektraKsChangesAttach (ks->changes, toAppend);
+	}
+
 	return ks->size;
 }
 
@@ -862,6 +974,12 @@ ssize_t ksAppendKey (KeySet * ks, Key * toAppend)
  *
  * @copydetails doxygenFlatCopy
  *
+ * Because both KeySets are sorted, they are merged in a single
+ * pass (linear in the size of both KeySets).
+ *
+ * The KeySet internal cursor will be set to the last key of
+ * @p toAppend (as if every key was appended with ksAppendKey()).
+ *
  * @post Sorted KeySet ks with all keys it had before and additionally
  *       the keys from toAppend
  * @return the size of the KeySet after transfer
@@ -879,17 +997,77 @@ ssize_t ksAppend (KeySet * ks, const KeySet * toAppend)
 	if (!toAppend) return -1;
 
 	if (toAppend->size <= 0) return ks->size;
+	if (ks == toAppend) return ks->size;
+	if (elektraKsUnshare (ks) == -1) return -1;
 
 	/* Do only one resize in advance */
 	for (toAlloc = ks->alloc; ks->size + toAppend->size >= toAlloc; toAlloc *= 2)
 		;
-	ksResize (ks, toAlloc - 1);
+	if (ksResize (ks, toAlloc - 1) == -1) return -1;
+
+	/* Merge backwards, so that no key of ks gets overwritten
+	 * before it was moved to its final position.
+	 *
+	 * e.g. ks = [a c e], toAppend = [b c]:
+	 *
+	 * |a |c |e |  |  |
+	 * |a |  |b |c'|e |  (c replaced by c', one slot left free)
+	 * |a |b |c'|e |     (close the gap)
+	 * */
+	Key ** array = ks->array;
+	Key ** append = toAppend->array;
+	ssize_t i = ks->size - 1;
+	ssize_t j = toAppend->size - 1;
+	ssize_t w = ks->size + toAppend->size - 1;
+	ssize_t last = -1; /* where the last key of toAppend ended up */
+
+	while (j >= 0)
+	{
+		int cmpresult = i >= 0 ? keyCompareByNameOwner (&array[i], &append[j]) : -1;
+		if (cmpresult > 0)
+		{
+			array[w--] = array[i--];
+			continue;
+		}
 
-	/* TODO: here is lots of room for optimizations */
-	for (size_t i = 0; i < toAppend->size; ++i)
+		Key * toInsert = append[j--];
+		elektraKeyLock (toInsert, KEY_LOCK_NAME);
+		if (cmpresult == 0)
+		{
+			/* Key already exists, replace it */
+			Key * old = array[i--];
+			if (old != toInsert)
+			{
+				keyDecRef (old);
+				keyDel (old);
+				keyIncRef (toInsert);
+				elektraKsChangesAdd (ks->changes, toInsert);
+			}
+		}
+		else
+		{
+			keyIncRef (toInsert);
+			elektraKsChangesAdd (ks->changes, toInsert);
+		}
+		if (ks->changes) elektraKsChangesAttach (ks->changes, toInsert);
+		if (last == -1) last = w;
+		array[w--] = toInsert;
+	}
+
+	/* all keys of toAppend were placed, the rest of ks
+	 * stays where it is unless keys were replaced */
+	size_t gap = w - i;
+	if (gap > 0)
 	{
-		ksAppendKey (ks, toAppend->array[i]);
+		memmove (array + i + 1, array + w + 1, (ks->size + toAppend->size - w - 1) * sizeof (Key *));
+		last -= gap;
 	}
+
+	ks->size = ks->size + toAppend->size - gap;
+	array[ks->size] = 0;
+	ksSetCursor (ks, last);
+	elektraKsIndexInvalidate (ks);
+
 	return ks->size;
 }
 
@@ -918,10 +1096,12 @@ ssize_t ksCopyInternal (KeySet * ks, size_t to, size_t from)
 
 	if (length < 0) return -1;
 	if (ks->size < to) return -1;
+	if (elektraKsUnshare (ks) == -1) return -1;
 
 	ks->size = ks->size + sizediff;
 	ret = elektraMemmove (ks->array + to, ks->array + from, length);
 	ks->array[ks->size] = 0;
+	elektraKsIndexInvalidate (ks);
 	return ret;
 }
 
@@ -1121,6 +1301,11 @@ KeySet * ksCut (KeySet * ks, const Key * cutpoint)
 
 	newsize = it - found;
 
+	for (size_t i = found; ks->changes && i < it; ++i)
+	{
+		elektraKsChangesAdd (ks->changes, ks->array[i]);
+	}
+
 	returned = ksNew (newsize, KS_END);
 	elektraMemcpy (returned->array, ks->array + found, newsize);
 	returned->size = newsize;
@@ -1183,12 +1368,14 @@ Key * ksPop (KeySet * ks)
 	ks->flags |= KS_FLAG_SYNC;
 
 	if (ks->size <= 0) return 0;
+	if (elektraKsUnshare (ks) == -1) return 0;
 
 	--ks->size;
 	if (ks->size + 1 < ks->alloc / 2) ksResize (ks, ks->alloc / 2 - 1);
 	ret = ks->array[ks->size];
 	ks->array[ks->size] = 0;
 	keyDecRef (ret);
+	elektraKsChangesAdd (ks->changes, ret);
 
 	return ret;
 }
@@ -1707,9 +1894,119 @@ finished:
 
 /**
  * @internal
- * @brief Helper for ksLookup
+ * @brief Compare the unescaped name of @p key with the name of the
+ * cascading key @p cascading in namespace @p ns
+ *
+ * The unescaped name of a cascading key starts with a null byte, so
+ * the unescaped name in a namespace is the namespace followed by the
+ * unescaped cascading name. The comparison is done as if this name
+ * would have been built, so it yields the same order as
+ * keyCompareByName().
+ *
+ * @param key the key to compare
+ * @param ns the namespace, e.g. "user"
+ * @param nsSize the length of @p ns (without null byte)
+ * @param cascading the cascading key
  */
-static Key * elektraLookupByCascading (KeySet * ks, Key * key, option_t options)
+static int keyCompareByNamespacedName (const Key * key, const char * ns, size_t nsSize, const Key * cascading)
+{
+	const char * name = key->key + key->keySize;
+	size_t size = key->keyUSize;
+	int ret = memcmp (name, ns, size < nsSize ? size : nsSize);
+	if (ret != 0) return ret;
+	if (size < nsSize) return -1;
+
+	name += nsSize;
+	size -= nsSize;
+	const char * suffix = cascading->key + cascading->keySize;
+	size_t const suffixSize = cascading->keyUSize;
+	ret = memcmp (name, suffix, size < suffixSize ? size : suffixSize);
+	if (ret != 0) return ret;
+	if (size < suffixSize) return -1;
+	if (size > suffixSize) return 1;
+	return 0;
+}
+
+/**
+ * @internal
+ * @brief Return the key found at @p pos
+ *
+ * @return the key (popped if KDB_O_POP is given)
+ */
+static Key * elektraLookupAt (KeySet * ks, size_t pos, option_t options)
+{
+	if (options & KDB_O_POP)
+	{
+		return elektraKsPopAtCursor (ks, pos);
+	}
+	ksSetCursor (ks, pos);
+	return ks->array[pos];
+}
+
+/**
+ * @internal
+ * @brief Binary search for a cascading key in a namespace
+ *
+ * Does the same as a ksLookup() with the cascading key renamed to
+ * the namespace, but without building and unescaping the name.
+ *
+ * @return the found key (popped if KDB_O_POP is given)
+ * @retval 0 if nothing was found (cursor is unchanged then)
+ */
+static Key * elektraLookupInNamespace (KeySet * ks, const char * ns, Key * key, option_t options)
+{
+	ssize_t left = 0;
+	ssize_t right = ks->size - 1;
+	size_t const nsSize = strlen (ns);
+
+	while (left <= right)
+	{
+		ssize_t middle = left + ((right - left) / 2);
+		int cmpresult = keyCompareByNamespacedName (ks->array[middle], ns, nsSize, key);
+		if (cmpresult < 0)
+		{
+			left = middle + 1;
+		}
+		else if (cmpresult > 0)
+		{
+			right = middle - 1;
+		}
+		else
+		{
+			return elektraLookupAt (ks, middle, options);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupByCascading
+ *
+ * Continue the lookup with the spec key found for the cascading key.
+ */
+static Key * elektraLookupBySpecKey (KeySet * ks, Key * key, Key * specKey, option_t options)
+{
+	Key * found = 0;
+
+	specKey = keyDup (specKey);
+	keySetBinary (specKey, keyValue (key), keyGetValueSize (key));
+	elektraCopyCallbackMeta (specKey, key);
+	found = elektraLookupBySpec (ks, specKey, options);
+	elektraCopyCallbackMeta (key, specKey);
+	keyDel (specKey);
+	return found;
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupByCascading
+ *
+ * Lookup by rewriting the name of the key for every namespace, so
+ * that callbacks see the name of the key currently searched for.
+ */
+static Key * elektraLookupByCascadingRenamed (KeySet * ks, Key * key, option_t options)
 {
 	char * name = key->key;
 	size_t size = key->keySize;
@@ -1742,13 +2039,7 @@ static Key * elektraLookupByCascading (KeySet * ks, Key * key, option_t options)
 		}
 
 		// we found a spec key, so we know what to do
-		specKey = keyDup (specKey);
-		keySetBinary (specKey, keyValue (key), keyGetValueSize (key));
-		elektraCopyCallbackMeta (specKey, key);
-		found = elektraLookupBySpec (ks, specKey, options);
-		elektraCopyCallbackMeta (key, specKey);
-		keyDel (specKey);
-		return found;
+		return elektraLookupBySpecKey (ks, key, specKey, options);
 	}
 
 	// default cascading:
@@ -1803,6 +2094,68 @@ static Key * elektraLookupByCascading (KeySet * ks, Key * key, option_t options)
 	return found;
 }
 
+/**
+ * @internal
+ * @brief Helper for ksLookup
+ *
+ * Searches the cascading key in spec, proc, dir, user and system
+ * and finally the cascading key itself.
+ *
+ * If no callback is involved, the unescaped cascading name is directly
+ * compared with the keys of every namespace, so that no key name
+ * needs to be rebuilt. With the hash index (see elektraKsHashIndex())
+ * the keys of all namespaces are found with a single probe, otherwise
+ * there is a binary search per namespace: the keys of a namespace
+ * are sorted by name, but their positions differ per namespace.
+ */
+static Key * elektraLookupByCascading (KeySet * ks, Key * key, option_t options)
+{
+	static const char * const namespaces[] = { "proc", "dir", "user", "system", 0 };
+	static const char * const indexed[] = { "spec", "proc", "dir", "user", "system", "", 0 };
+	Key * found = 0;
+
+	if ((options & (KDB_O_NOALL | KDB_O_NOCASE | KDB_O_WITHOWNER)) || keyGetMeta (key, "callback"))
+	{
+		return elektraLookupByCascadingRenamed (ks, key, options);
+	}
+
+	ssize_t positions[sizeof (indexed) / sizeof (indexed[0])];
+	if (test_bit (ks->flags, KS_FLAG_HASH_INDEX) && elektraKsIndexLookupCascading (ks, key, indexed, positions) == 0)
+	{
+		if (!(options & KDB_O_NOSPEC) && positions[0] != -1)
+		{
+			return elektraLookupBySpecKey (ks, key, elektraLookupAt (ks, positions[0], options), options);
+		}
+		size_t n = 1;
+		for (; indexed[n][0]; ++n)
+		{
+			if (positions[n] != -1) return elektraLookupAt (ks, positions[n], options);
+		}
+		// the cascading key itself
+		if (positions[n] != -1 && !(options & KDB_O_NODEFAULT)) return elektraLookupAt (ks, positions[n], options);
+		return 0;
+	}
+
+	if (!(options & KDB_O_NOSPEC))
+	{
+		Key * specKey = elektraLookupInNamespace (ks, "spec", key, options);
+		if (specKey) return elektraLookupBySpecKey (ks, key, specKey, options);
+	}
+
+	for (const char * const * ns = namespaces; *ns && !found; ++ns)
+	{
+		found = elektraLookupInNamespace (ks, *ns, key, options);
+	}
+
+	if (!found && !(options & KDB_O_NODEFAULT))
+	{
+		// search / key itself
+		found = ksLookup (ks, key, (options & ~KDB_O_DEL) | KDB_O_NOCASCADING);
+	}
+
+	return found;
+}
+
 static Key * elektraLookupLinearSearch (KeySet * ks, Key * key, option_t options)
 {
 	cursor_t cursor = 0;
@@ -1838,10 +2191,19 @@ static Key * elektraLookupBinarySearch (KeySet * ks, Key const * key, option_t o
 {
 	cursor_t cursor = 0;
 	cursor = ksGetCursor (ks);
-	Key ** found;
+	Key ** found = 0;
 	size_t jump = 0;
+	ssize_t pos = -2;
+	if (test_bit (ks->flags, KS_FLAG_HASH_INDEX) && !(options & (KDB_O_WITHOWNER | KDB_O_NOCASE)))
+	{
+		pos = elektraKsIndexLookup (ks, key);
+	}
 	/*If there is a known offset in the beginning jump could be set*/
-	if ((options & KDB_O_WITHOWNER) && (options & KDB_O_NOCASE))
+	if (pos >= 0)
+		found = ks->array + pos;
+	else if (pos == -1)
+		found = 0;
+	else if ((options & KDB_O_WITHOWNER) && (options & KDB_O_NOCASE))
 		found = (Key **)bsearch (&key, ks->array + jump, ks->size - jump, sizeof (Key *), keyCompareByNameOwnerCase);
 	else if (options & KDB_O_WITHOWNER)
 		found = (Key **)bsearch (&key, ks->array + jump, ks->size - jump, sizeof (Key *), keyCompareByNameOwner);
@@ -2340,6 +2702,8 @@ int ksResize (KeySet * ks, size_t alloc)
 			return -1;
 		}
 	}
+	if (elektraKsUnshare (ks) == -1) return -1;
+
 	/* This is much too verbose
 	#if DEBUG && VERBOSE
 		printf ("Resize from %d to %d\n",(int) ks->alloc,(int) alloc);
@@ -2399,6 +2763,10 @@ int ksInit (KeySet * ks)
 	ks->size = 0;
 	ks->alloc = 0;
 	ks->flags = 0;
+	ks->index = 0;
+	ks->sharedPrev = 0;
+	ks->sharedNext = 0;
+	ks->changes = 0;
 
 	ksRewind (ks);
 
@@ -2425,12 +2793,22 @@ int ksClose (KeySet * ks)
 		keyDel (k);
 	}
 
-	if (ks->array) elektraFree (ks->array);
+	if (ks->sharedNext)
+	{
+		// the array still belongs to the other key sets
+		elektraKsUnlink (ks);
+	}
+	else if (ks->array)
+	{
+		elektraFree (ks->array);
+	}
 	ks->array = 0;
 	ks->alloc = 0;
 
 	ks->size = 0;
 
+	elektraKsIndexDel (ks);
+
 	return 0;
 }
 
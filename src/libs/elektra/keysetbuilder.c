@@ -0,0 +1,306 @@
+/**
+ * @file
+ *
+ * @brief Build key sets from unsorted keys with a single sort.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "kdbinternal.h"
+
+/**
+ * @internal
+ *
+ * Keys collected by a builder, in the order they were added.
+ */
+struct _ElektraKsBuilder
+{
+	Key ** array; /*!< the keys, each holds a reference */
+	size_t size;  /*!< number of keys */
+	size_t alloc; /*!< allocated size of array */
+};
+
+/**
+ * @internal
+ *
+ * Stable merge sort of @p array using @p buffer (of the same size).
+ */
+static void elektraKsMergeSort (Key ** array, Key ** buffer, size_t size)
+{
+	for (size_t width = 1; width < size; width *= 2)
+	{
+		for (size_t left = 0; left < size; left += 2 * width)
+		{
+			size_t middle = left + width < size ? left + width : size;
+			size_t right = left + 2 * width < size ? left + 2 * width : size;
+			size_t i = left, j = middle, w = left;
+
+			// already in order, nothing to merge
+			if (middle == right || keyCmp (array[middle - 1], array[middle]) <= 0)
+			{
+				memcpy (buffer + left, array + left, (right - left) * sizeof (Key *));
+				continue;
+			}
+
+			while (i < middle && j < right)
+			{
+				// take from the left on equality to stay stable
+				buffer[w++] = keyCmp (array[j], array[i]) < 0 ? array[j++] : array[i++];
+			}
+			while (i < middle)
+				buffer[w++] = array[i++];
+			while (j < right)
+				buffer[w++] = array[j++];
+		}
+
+		Key ** swap = array;
+		array = buffer;
+		buffer = swap;
+	}
+}
+
+/**
+ * @internal
+ *
+ * Stable insertion sort, used if there is no memory for a merge sort.
+ */
+static void elektraKsInsertionSort (Key ** array, size_t size)
+{
+	for (size_t i = 1; i < size; ++i)
+	{
+		Key * key = array[i];
+		size_t j = i;
+		while (j > 0 && keyCmp (array[j - 1], key) > 0)
+		{
+			array[j] = array[j - 1];
+			--j;
+		}
+		array[j] = key;
+	}
+}
+
+/**
+ * @internal
+ *
+ * Sort keys by name (and owner) and remove duplicates.
+ *
+ * Of keys with the same name (and owner) the one which comes last
+ * in @p array is kept, like ksAppendKey() replaces existing keys.
+ * Every entry of @p array holds a reference (see keyIncRef()),
+ * the references of removed keys are given back.
+ *
+ * @param array the keys to sort
+ * @param size the number of keys
+ *
+ * @return the number of keys left in @p array
+ */
+size_t elektraKsSortUnique (Key ** array, size_t size)
+{
+	if (size < 2) return size;
+
+	// already sorted without duplicates (the common case for ksNew)?
+	size_t sorted = 1;
+	while (sorted < size && keyCmp (array[sorted - 1], array[sorted]) < 0)
+	{
+		++sorted;
+	}
+	if (sorted == size) return size;
+
+	Key ** buffer = elektraMalloc (size * sizeof (Key *));
+	if (buffer)
+	{
+		elektraKsMergeSort (array, buffer, size);
+
+		// every pass swaps array and buffer
+		size_t passes = 0;
+		for (size_t width = 1; width < size; width *= 2)
+		{
+			++passes;
+		}
+		if (passes % 2 == 1)
+		{
+			memcpy (array, buffer, size * sizeof (Key *));
+		}
+		elektraFree (buffer);
+	}
+	else
+	{
+		elektraKsInsertionSort (array, size);
+	}
+
+	// keep the last of every run of equal keys
+	size_t w = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (i + 1 < size && keyCmp (array[i], array[i + 1]) == 0)
+		{
+			// the key might be added more than once, then it is not freed
+			keyDecRef (array[i]);
+			keyDel (array[i]);
+			continue;
+		}
+		array[w++] = array[i];
+	}
+
+	return w;
+}
+
+/**
+ * @brief Create a builder to collect keys for a key set.
+ *
+ * Appending keys to a key set in an order other than the sort
+ * order of key sets moves keys around on every append.
+ * A builder instead collects keys unsorted and sorts them once,
+ * when they are passed to a key set with elektraKsBuilderFinish().
+ *
+ * Use it for parsers of file formats where the order of keys
+ * in the file differs from the order within key sets, as long as
+ * the parser does not need to look up keys it already created.
+ *
+ * @param alloc how many keys will (approximately) be added
+ * @return the new builder
+ * @retval 0 on memory error
+ * @see elektraKsBuilderAdd(), elektraKsBuilderFinish(), elektraKsBuilderDel()
+ * @ingroup proposal
+ */
+ElektraKsBuilder * elektraKsBuilderNew (size_t alloc)
+{
+	ElektraKsBuilder * builder = elektraCalloc (sizeof (ElektraKsBuilder));
+	if (!builder) return 0;
+
+	builder->alloc = alloc < KEYSET_SIZE ? KEYSET_SIZE : alloc + 1;
+	builder->array = elektraMalloc (builder->alloc * sizeof (Key *));
+	if (!builder->array)
+	{
+		elektraFree (builder);
+		return 0;
+	}
+
+	return builder;
+}
+
+/**
+ * @brief Add a key to a builder.
+ *
+ * Works like ksAppendKey(): the reference counter is incremented,
+ * the name gets locked and keys without name are deleted.
+ * If keys with the same name are added, the last one wins.
+ *
+ * @param builder the builder to add to
+ * @param toAdd the key to add
+ *
+ * @return the number of keys in the builder
+ * @retval -1 on NULL pointers, keys without name or memory error
+ * @ingroup proposal
+ */
+ssize_t elektraKsBuilderAdd (ElektraKsBuilder * builder, Key * toAdd)
+{
+	if (!builder) return -1;
+	if (!toAdd) return -1;
+	if (!toAdd->key)
+	{
+		// like ksAppendKey(ks, keyNew(0))
+		keyDel (toAdd);
+		return -1;
+	}
+
+	if (builder->size + 1 >= builder->alloc)
+	{
+		size_t alloc = builder->alloc ? builder->alloc * 2 : KEYSET_SIZE;
+		if (elektraRealloc ((void **)&builder->array, alloc * sizeof (Key *)) == -1) return -1;
+		builder->alloc = alloc;
+	}
+
+	elektraKeyLock (toAdd, KEY_LOCK_NAME);
+	keyIncRef (toAdd);
+	builder->array[builder->size++] = toAdd;
+
+	return builder->size;
+}
+
+/**
+ * @brief Sort the collected keys and append them to a key set.
+ *
+ * The keys are sorted once, duplicates are removed (the last key
+ * added wins) and the result is merged into @p ks like ksAppend()
+ * would do. Afterwards the builder is empty and can be reused.
+ *
+ * @param builder the builder with the keys
+ * @param ks the key set to append the keys to
+ *
+ * @return the size of @p ks
+ * @retval -1 on NULL pointers or memory error (the keys stay in the builder)
+ * @ingroup proposal
+ */
+ssize_t elektraKsBuilderFinish (ElektraKsBuilder * builder, KeySet * ks)
+{
+	if (!builder) return -1;
+	if (!ks) return -1;
+
+	builder->size = elektraKsSortUnique (builder->array, builder->size);
+	if (!builder->size) return ks->size;
+
+	if (ks->size == 0 && !ks->sharedNext && !ks->changes)
+	{
+		// take over the array, the references of the builder stay
+		elektraFree (ks->array);
+		ks->array = builder->array;
+		ks->size = builder->size;
+		ks->alloc = builder->alloc;
+		ks->array[ks->size] = 0;
+		ksSetCursor (ks, ks->size - 1);
+		elektraKsIndexInvalidate (ks);
+
+		builder->alloc = 0;
+		builder->size = 0;
+		builder->array = 0;
+		return ks->size;
+	}
+
+	KeySet sorted;
+	ksInit (&sorted);
+	sorted.array = builder->array;
+	sorted.size = builder->size;
+	sorted.alloc = builder->alloc;
+	if (ksAppend (ks, &sorted) == -1) return -1;
+
+	// ks holds its own references now
+	for (size_t i = 0; i < builder->size; ++i)
+	{
+		keyDecRef (builder->array[i]);
+		keyDel (builder->array[i]);
+	}
+	builder->size = 0;
+
+	return ks->size;
+}
+
+/**
+ * @brief Delete a builder.
+ *
+ * Keys which were not passed to a key set with
+ * elektraKsBuilderFinish() are released like ksDel() does.
+ *
+ * @param builder the builder to delete (may be NULL)
+ * @ingroup proposal
+ */
+void elektraKsBuilderDel (ElektraKsBuilder * builder)
+{
+	if (!builder) return;
+
+	for (size_t i = 0; i < builder->size; ++i)
+	{
+		keyDecRef (builder->array[i]);
+		keyDel (builder->array[i]);
+	}
+	elektraFree (builder->array);
+	elektraFree (builder);
+}
@@ -0,0 +1,173 @@
+/**
+ * @file
+ *
+ * @brief Tracking of the keys changed since kdbGet().
+ *
+ * kdbGet() starts to track the key set it returned: every key of it
+ * refers to the changes of the key set and records its name there
+ * when it gets modified. Keys added to or removed from the key set
+ * are recorded as well. So kdbSet() finds the backends which need
+ * to be synced without looking at every key.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#include "kdbinternal.h"
+
+/**
+ * @internal
+ *
+ * Create new, empty changes.
+ *
+ * @return the changes with one reference
+ * @retval 0 on memory error
+ */
+static KeySetChanges * elektraKsChangesNew (void)
+{
+	KeySetChanges * changes = elektraMalloc (sizeof (KeySetChanges));
+	if (!changes) return 0;
+
+	changes->names = ksNew (0, KS_END);
+	if (!changes->names)
+	{
+		elektraFree (changes);
+		return 0;
+	}
+	changes->references = 1;
+	changes->complete = 1;
+	return changes;
+}
+
+/**
+ * @internal
+ *
+ * Give up a reference to the changes,
+ * they are freed with the last one.
+ *
+ * @param changes the changes (may be NULL)
+ */
+void elektraKsChangesRelease (KeySetChanges * changes)
+{
+	if (!changes) return;
+	if (--changes->references > 0) return;
+
+	ksDel (changes->names);
+	elektraFree (changes);
+}
+
+/**
+ * @internal
+ *
+ * Record that a key was changed, added or removed.
+ *
+ * Only the name is recorded, a key without value is used for that.
+ * If the name cannot be recorded, the changes are incomplete.
+ *
+ * @param changes the changes to record in (may be NULL)
+ * @param key the changed key
+ */
+void elektraKsChangesAdd (KeySetChanges * changes, const Key * key)
+{
+	if (!changes || !changes->complete) return;
+	if (ksSearchInternal (changes->names, key) >= 0) return;
+
+	Key * name = keyNew (keyName (key), KEY_END);
+	if (!name || ksAppendKey (changes->names, name) == -1)
+	{
+		changes->complete = 0;
+	}
+}
+
+/**
+ * @internal
+ *
+ * Let changes of the key be recorded in @p changes.
+ *
+ * A key records its changes only in one place. If it was
+ * tracked by another key set before, the changes of the
+ * other key set are incomplete afterwards.
+ *
+ * @param changes the changes to record in
+ * @param key the key to track
+ */
+void elektraKsChangesAttach (KeySetChanges * changes, Key * key)
+{
+	if (key->changes == changes) return;
+
+	if (key->changes)
+	{
+		key->changes->complete = 0;
+		elektraKsChangesRelease (key->changes);
+	}
+	++changes->references;
+	key->changes = changes;
+}
+
+/**
+ * @internal
+ *
+ * Start (or continue) to track the changes of a key set.
+ *
+ * Every key of the key set gets tracked. Keys which already
+ * need sync are recorded as changed.
+ *
+ * @param ks the key set to track
+ * @retval 0 on success
+ * @retval -1 on memory error (the key set is not tracked then)
+ * @see elektraKsChangesAdd()
+ */
+int elektraKsTrack (KeySet * ks)
+{
+	if (!ks->changes)
+	{
+		ks->changes = elektraKsChangesNew ();
+		if (!ks->changes) return -1;
+	}
+
+	for (size_t i = 0; i < ks->size; ++i)
+	{
+		Key * key = ks->array[i];
+		elektraKsChangesAttach (ks->changes, key);
+		if (keyNeedSync (key) == 1) elektraKsChangesAdd (ks->changes, key);
+	}
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Stop to track the changes of a key set.
+ *
+ * The keys keep referring to the changes, which
+ * are freed together with the last of them.
+ *
+ * @param ks the key set
+ * @return the changes of the key set, the reference of
+ *         the key set is passed to the caller
+ */
+KeySetChanges * elektraKsUntrack (KeySet * ks)
+{
+	KeySetChanges * changes = ks->changes;
+	ks->changes = 0;
+	return changes;
+}
+
+/**
+ * @internal
+ *
+ * The names of the keys changed since tracking started.
+ *
+ * @param ks the key set
+ * @return the names of the changed, added or removed keys
+ * @retval 0 if the key set is not tracked or changes
+ *         might be missing, every key needs to be checked then
+ */
+KeySet * elektraKsChanges (const KeySet * ks)
+{
+	if (!ks->changes || !ks->changes->complete) return 0;
+	return ks->changes->names;
+}
@@ -0,0 +1,368 @@
+/**
+ * @file
+ *
+ * @brief Optional hash index for lookups in large key sets.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "kdbinternal.h"
+
+/** Smallest number of slots of an index, must be a power of two */
+#define ELEKTRA_KS_INDEX_MIN_SIZE 64
+
+/**
+ * @internal
+ *
+ * One slot of the open addressing table.
+ */
+typedef struct
+{
+	size_t hash; /*!< hash of the unescaped name */
+	size_t pos;  /*!< position in the array + 1, 0 if the slot is empty */
+} KeySetIndexSlot;
+
+/**
+ * @internal
+ *
+ * Hash index over the unescaped names of a key set.
+ *
+ * The index maps names to positions in the array of the key set.
+ * Every key in the key set has an entry, but not every entry
+ * refers to a key of the key set anymore: ksPop() leaves
+ * stale entries behind. Thus every hit is verified against
+ * the array.
+ *
+ * A second table maps the names without namespace to positions,
+ * so that the keys of all namespaces a cascading key stands for
+ * are found with a single probe.
+ */
+struct _KeySetIndex
+{
+	KeySetIndexSlot * slots;
+	KeySetIndexSlot * cascading; /*!< same as slots, but for the names without namespace */
+	size_t alloc; /*!< number of slots, always a power of two */
+	size_t used;  /*!< number of slots in use (including stale ones) */
+	int valid;    /*!< 0 if the index needs to be rebuilt */
+};
+
+/**
+ * @internal
+ *
+ * FNV-1a hash of the unescaped name of a key.
+ */
+static size_t elektraKsIndexHash (const Key * key)
+{
+	const unsigned char * name = (const unsigned char *)key->key + key->keySize;
+	size_t hash = (size_t)14695981039346656037ULL;
+	for (size_t i = 0; i < key->keyUSize; ++i)
+	{
+		hash ^= name[i];
+		hash *= (size_t)1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * @internal
+ *
+ * The unescaped name of a key without its namespace.
+ *
+ * The unescaped namespace is terminated by a null byte, the
+ * unescaped name of a cascading key starts with it. So the
+ * part starting there is the same for a key in any namespace
+ * and the cascading key.
+ */
+static const char * elektraKsIndexCascadingName (const Key * key, size_t * size)
+{
+	const char * name = key->key + key->keySize;
+	size_t ns = strnlen (name, key->keyUSize);
+	*size = key->keyUSize - ns;
+	return name + ns;
+}
+
+/**
+ * @internal
+ *
+ * FNV-1a hash of the unescaped name of a key without its namespace.
+ */
+static size_t elektraKsIndexCascadingHash (const Key * key)
+{
+	size_t size;
+	const unsigned char * name = (const unsigned char *)elektraKsIndexCascadingName (key, &size);
+	size_t hash = (size_t)14695981039346656037ULL;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= name[i];
+		hash *= (size_t)1099511628211ULL;
+	}
+	return hash;
+}
+
+static int elektraKsIndexSameName (const Key * key1, const Key * key2)
+{
+	return key1->keyUSize == key2->keyUSize && !memcmp (key1->key + key1->keySize, key2->key + key2->keySize, key1->keyUSize);
+}
+
+static void elektraKsIndexInsertSlot (KeySetIndexSlot * slots, size_t mask, size_t hash, size_t pos)
+{
+	size_t i = hash & mask;
+	while (slots[i].pos)
+	{
+		i = (i + 1) & mask;
+	}
+	slots[i].hash = hash;
+	slots[i].pos = pos + 1;
+}
+
+static void elektraKsIndexInsert (struct _KeySetIndex * index, const Key * key, size_t pos)
+{
+	elektraKsIndexInsertSlot (index->slots, index->alloc - 1, elektraKsIndexHash (key), pos);
+	elektraKsIndexInsertSlot (index->cascading, index->alloc - 1, elektraKsIndexCascadingHash (key), pos);
+	++index->used;
+}
+
+/**
+ * @internal
+ *
+ * (Re)build the index for all keys of the key set.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error (index is not valid then)
+ */
+static int elektraKsIndexBuild (KeySet * ks)
+{
+	struct _KeySetIndex * index = ks->index;
+	if (!index)
+	{
+		index = elektraCalloc (sizeof (struct _KeySetIndex));
+		if (!index) return -1;
+		ks->index = index;
+	}
+
+	// keep the load factor below 1/2
+	size_t alloc = ELEKTRA_KS_INDEX_MIN_SIZE;
+	while (alloc < ks->size * 2)
+	{
+		alloc *= 2;
+	}
+
+	if (alloc != index->alloc)
+	{
+		elektraFree (index->slots);
+		elektraFree (index->cascading);
+		index->slots = elektraMalloc (alloc * sizeof (KeySetIndexSlot));
+		index->cascading = elektraMalloc (alloc * sizeof (KeySetIndexSlot));
+		if (!index->slots || !index->cascading)
+		{
+			elektraFree (index->slots);
+			elektraFree (index->cascading);
+			index->slots = 0;
+			index->cascading = 0;
+			index->alloc = 0;
+			index->valid = 0;
+			return -1;
+		}
+		index->alloc = alloc;
+	}
+	memset (index->slots, 0, alloc * sizeof (KeySetIndexSlot));
+	memset (index->cascading, 0, alloc * sizeof (KeySetIndexSlot));
+	index->used = 0;
+
+	for (size_t i = 0; i < ks->size; ++i)
+	{
+		elektraKsIndexInsert (index, ks->array[i], i);
+	}
+	index->valid = 1;
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Look up the position of a key with the same name as @p key.
+ *
+ * The index will be (re)built if needed.
+ *
+ * @retval -1 if no such key is in the key set
+ * @retval -2 if the index could not be built (do a binary search instead)
+ * @return the position of the key in the array otherwise
+ */
+ssize_t elektraKsIndexLookup (KeySet * ks, const Key * key)
+{
+	if (!ks->index || !ks->index->valid)
+	{
+		if (elektraKsIndexBuild (ks) == -1) return -2;
+	}
+
+	struct _KeySetIndex * index = ks->index;
+	size_t hash = elektraKsIndexHash (key);
+	size_t mask = index->alloc - 1;
+
+	for (size_t i = hash & mask; index->slots[i].pos; i = (i + 1) & mask)
+	{
+		if (index->slots[i].hash != hash) continue;
+
+		size_t pos = index->slots[i].pos - 1;
+		if (pos < ks->size && elektraKsIndexSameName (ks->array[pos], key))
+		{
+			return pos;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @internal
+ *
+ * Look up the keys of all namespaces a cascading key stands for.
+ *
+ * All candidates are found with a single probe of the table of
+ * names without namespace. The index will be (re)built if needed.
+ *
+ * @param ks the key set to search in
+ * @param key the cascading key
+ * @param namespaces the unescaped namespaces to look for, terminated by 0,
+ *        "" stands for the cascading key itself
+ * @param [out] positions for every namespace the position of its key
+ *        in the array, -1 if the namespace has no such key
+ *
+ * @retval 0 on success
+ * @retval -2 if the index could not be built (do binary searches instead)
+ */
+int elektraKsIndexLookupCascading (KeySet * ks, const Key * key, const char * const * namespaces, ssize_t * positions)
+{
+	if (!ks->index || !ks->index->valid)
+	{
+		if (elektraKsIndexBuild (ks) == -1) return -2;
+	}
+
+	for (size_t n = 0; namespaces[n]; ++n)
+	{
+		positions[n] = -1;
+	}
+
+	struct _KeySetIndex * index = ks->index;
+	size_t hash = elektraKsIndexCascadingHash (key);
+	size_t mask = index->alloc - 1;
+	size_t nameSize;
+	const char * name = elektraKsIndexCascadingName (key, &nameSize);
+
+	for (size_t i = hash & mask; index->cascading[i].pos; i = (i + 1) & mask)
+	{
+		if (index->cascading[i].hash != hash) continue;
+
+		size_t pos = index->cascading[i].pos - 1;
+		if (pos >= ks->size) continue;
+
+		const Key * cur = ks->array[pos];
+		size_t curSize;
+		const char * curName = elektraKsIndexCascadingName (cur, &curSize);
+		if (curSize != nameSize || memcmp (curName, name, nameSize)) continue;
+
+		const char * ns = cur->key + cur->keySize;
+		for (size_t n = 0; namespaces[n]; ++n)
+		{
+			if (!strcmp (ns, namespaces[n])) positions[n] = pos;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Update the index after a key was appended at position @p pos
+ * without moving any other key.
+ */
+void elektraKsIndexAppend (KeySet * ks, size_t pos)
+{
+	struct _KeySetIndex * index = ks->index;
+	if (!index || !index->valid) return;
+
+	if ((index->used + 1) * 2 > index->alloc)
+	{
+		// too many (possibly stale) entries
+		index->valid = 0;
+		return;
+	}
+
+	elektraKsIndexInsert (index, ks->array[pos], pos);
+}
+
+/**
+ * @internal
+ *
+ * Keys moved within the array, so the index needs to be rebuilt
+ * on the next lookup.
+ */
+void elektraKsIndexInvalidate (KeySet * ks)
+{
+	if (ks->index) ks->index->valid = 0;
+}
+
+/**
+ * @internal
+ *
+ * Free all memory of the index.
+ */
+void elektraKsIndexDel (KeySet * ks)
+{
+	if (!ks->index) return;
+
+	elektraFree (ks->index->slots);
+	elektraFree (ks->index->cascading);
+	elektraFree (ks->index);
+	ks->index = 0;
+}
+
+/**
+ * @brief Enable or disable the hash index of a key set.
+ *
+ * With the hash index enabled ksLookup() and ksLookupByName() find
+ * keys in constant time instead of doing a binary search.
+ * Cascading lookups find the keys of all namespaces with a single
+ * probe instead of a binary search per namespace.
+ * The index is built lazily on the first lookup.
+ *
+ * Appending keys at the end of the key set updates the index
+ * incrementally. Any other change which moves keys within the
+ * key set (e.g. inserting in the middle, ksCut(), ksLookup() with
+ * ::KDB_O_POP) causes the index to be rebuilt on the next lookup.
+ * So only enable the index for key sets which are mainly read.
+ *
+ * Lookups with ::KDB_O_NOCASE or ::KDB_O_WITHOWNER never use the index.
+ *
+ * @param ks the key set to work with
+ * @param enable 1 to enable, 0 to disable (and free) the index
+ *
+ * @retval 1 if the index is enabled now
+ * @retval 0 if the index is disabled now
+ * @retval -1 on NULL pointer
+ * @ingroup proposal
+ */
+int elektraKsHashIndex (KeySet * ks, int enable)
+{
+	if (!ks) return -1;
+
+	if (enable)
+	{
+		set_bit (ks->flags, KS_FLAG_HASH_INDEX);
+		return 1;
+	}
+
+	clear_bit (ks->flags, KS_FLAG_HASH_INDEX);
+	elektraKsIndexDel (ks);
+	return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file
+ *
+ * @brief Non-owning views on the keys below a key.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "kdbinternal.h"
+
+/**
+ * @internal
+ *
+ * Compare the unescaped name of @p key with @p name.
+ *
+ * @param prefix if only the first @p size bytes of the key's name
+ *        should be compared (i.e. keys below name compare equal)
+ */
+static int elektraKsViewCompare (const Key * key, const char * name, size_t size, int prefix)
+{
+	const char * keyName = key->key + key->keySize;
+	const size_t keySize = key->keyUSize;
+
+	if (keySize < size)
+	{
+		int ret = memcmp (keyName, name, keySize);
+		return ret ? ret : -1;
+	}
+
+	int ret = memcmp (keyName, name, size);
+	if (ret || prefix) return ret;
+	return keySize > size ? 1 : 0;
+}
+
+/**
+ * @internal
+ *
+ * Find the first position in [begin, end) where the key does not
+ * compare less than @p name (or greater, if @p greater is set).
+ */
+static size_t elektraKsViewBound (const KeySet * ks, size_t begin, size_t end, const char * name, size_t size, int prefix, int greater)
+{
+	while (begin < end)
+	{
+		size_t middle = begin + (end - begin) / 2;
+		int cmp = elektraKsViewCompare (ks->array[middle], name, size, prefix);
+		if (cmp < 0 || (greater && cmp == 0))
+		{
+			begin = middle + 1;
+		}
+		else
+		{
+			end = middle;
+		}
+	}
+	return begin;
+}
+
+/**
+ * @brief Create a view on all keys below (or same as) a key.
+ *
+ * Contains the same keys as ksCut() would cut out,
+ * but the keys stay within @p ks and nothing is allocated.
+ * The range is found with two binary searches.
+ *
+ * The view does not own anything. It gets invalid as soon as
+ * @p ks is modified (keys appended, removed or @p ks deleted).
+ *
+ * @code
+ElektraKeySetView view;
+if (elektraKsView (ks, parentKey, &view) == -1) return -1;
+for (size_t i = 0; i < elektraKsViewSize (&view); ++i)
+{
+	Key * cur = elektraKsViewAt (&view, i);
+	// work with key below parentKey
+}
+ * @endcode
+ *
+ * @param ks the key set to view
+ * @param root the key whose subtree should be viewed,
+ *        cascading keys are not supported (use one view per namespace)
+ * @param view the view to initialize
+ *
+ * @retval 0 on success
+ * @retval -1 on NULL pointers, key without name or cascading key
+ * @see ksCut()
+ * @ingroup proposal
+ */
+int elektraKsView (KeySet * ks, const Key * root, ElektraKeySetView * view)
+{
+	if (!ks || !root || !view) return -1;
+	if (!root->key || root->key[0] == '/') return -1;
+
+	const char * name = root->key + root->keySize;
+	const size_t size = root->keyUSize;
+
+	view->ks = ks;
+	view->begin = elektraKsViewBound (ks, 0, ks->size, name, size, 0, 0);
+	view->end = elektraKsViewBound (ks, view->begin, ks->size, name, size, 1, 1);
+
+	return 0;
+}
+
+/**
+ * @brief Number of keys within a view.
+ *
+ * @param view the view
+ * @return the number of keys, 0 on NULL pointer
+ * @ingroup proposal
+ */
+size_t elektraKsViewSize (const ElektraKeySetView * view)
+{
+	if (!view) return 0;
+	return view->end - view->begin;
+}
+
+/**
+ * @brief Key at a position within a view.
+ *
+ * @param view the view
+ * @param pos the position, the first key below the root (or the root itself) is 0
+ * @return the key
+ * @retval 0 if @p pos is out of range or on NULL pointer
+ * @ingroup proposal
+ */
+Key * elektraKsViewAt (const ElektraKeySetView * view, size_t pos)
+{
+	if (!view) return 0;
+	if (pos >= view->end - view->begin) return 0;
+	return view->ks->array[view->begin + pos];
+}
+
+/**
+ * @brief Look up a key within a view.
+ *
+ * Only the name is considered, like ksLookup() without options.
+ *
+ * @param view the view to search in
+ * @param key the key with the name to search for
+ * @return the key found
+ * @retval 0 if no such key is in the view or on NULL pointers
+ * @ingroup proposal
+ */
+Key * elektraKsViewLookup (const ElektraKeySetView * view, const Key * key)
+{
+	if (!view || !key || !key->key) return 0;
+
+	const char * name = key->key + key->keySize;
+	const size_t size = key->keyUSize;
+
+	size_t pos = elektraKsViewBound (view->ks, view->begin, view->end, name, size, 0, 0);
+	if (pos < view->end && elektraKsViewCompare (view->ks->array[pos], name, size, 0) == 0)
+	{
+		return view->ks->array[pos];
+	}
+	return 0;
+}
+
+/**
+ * @brief Look up a key by name within a view.
+ *
+ * @param view the view to search in
+ * @param name the name of the key to search for
+ * @return the key found
+ * @retval 0 if no such key is in the view or on NULL pointers
+ * @see elektraKsViewLookup()
+ * @ingroup proposal
+ */
+Key * elektraKsViewLookupByName (const ElektraKeySetView * view, const char * name)
+{
+	if (!view || !name) return 0;
+
+	struct _Key key;
+
+	Key * found = 0;
+
+	keyInit (&key);
+	if (elektraKeySetName (&key, name, KEY_META_NAME | KEY_CASCADING_NAME) != -1)
+	{
+		found = elektraKsViewLookup (view, &key);
+	}
+	elektraFree (key.key);
+	ksDel (key.meta);
+	return found;
+}
@@ -67,6 +67,23 @@ int keyClearSync (Key * key)
 	return key->flags;
 }
 
+/** \internal
+ *
+ * Set sync flag of a key.
+ *
+ * If the key is tracked by a key set, the change
+ * gets recorded there (see elektraKsTrack()).
+ *
+ * @param key the key object to work with
+ * @ingroup keytest
+ *
+ */
+void elektraKeyChanged (Key * key)
+{
+	if (key->changes && !(key->flags & KEY_FLAG_SYNC)) elektraKsChangesAdd (key->changes, key);
+	key->flags |= KEY_FLAG_SYNC;
+}
+
 
 /**
  * Test if a key needs to be synced to backend storage.
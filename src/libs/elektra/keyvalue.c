@@ -513,17 +513,29 @@ ssize_t keySetRaw (Key * key, const void * newBinary, size_t dataSize)
 	{
 		if (key->data.v)
 		{
-			elektraFree (key->data.v);
+			if (!elektraKeyIsBorrowed (key, key->data.v)) elektraFree (key->data.v);
 			key->data.v = 0;
 		}
 		key->dataSize = 0;
-		set_bit (key->flags, KEY_FLAG_SYNC);
+		elektraKeyChanged (key);
 		if (keyIsBinary (key)) return 0;
 		return 1;
 	}
 
+	char * inlineValue = elektraKeyInlineValue (key, dataSize);
+	if (inlineValue)
+	{
+		// newBinary might point to the old value
+		memmove (inlineValue, newBinary, dataSize);
+		if (key->data.v && !elektraKeyIsBorrowed (key, key->data.v)) elektraFree (key->data.v);
+		key->data.v = inlineValue;
+		key->dataSize = dataSize;
+		elektraKeyChanged (key);
+		return keyGetValueSize (key);
+	}
+
 	key->dataSize = dataSize;
-	if (key->data.v)
+	if (key->data.v && !elektraKeyIsBorrowed (key, key->data.v))
 	{
 		char * p = 0;
 		p = realloc (key->data.v, key->dataSize);
@@ -539,6 +551,6 @@ ssize_t keySetRaw (Key * key, const void * newBinary, size_t dataSize)
 
 
 	memcpy (key->data.v, newBinary, key->dataSize);
-	set_bit (key->flags, KEY_FLAG_SYNC);
+	elektraKeyChanged (key);
 	return keyGetValueSize (key);
 }
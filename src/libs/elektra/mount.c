@@ -34,21 +34,13 @@
 
 
 /**
- * Creates a trie from a given configuration.
- *
- * The config will be deleted within this function.
+ * @internal
  *
- * @note elektraMountDefault is not allowed to be executed before
- *
- * @param kdb the handle to work with
- * @param modules the current list of loaded modules
- * @param config the configuration which should be used to build up the trie.
- * @param errorKey the key used to report warnings
- * @retval -1 on failure
- * @retval 0 on success
- * @ingroup mount
+ * Creates a trie from a given configuration,
+ * using @p open to build the backends.
  */
-int elektraMountOpen (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey)
+static int elektraMountOpenWith (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey,
+				 Backend * (*open) (KeySet *, KeySet *, Key *))
 {
 	Key * root;
 	Key * cur;
@@ -62,7 +54,7 @@ int elektraMountOpen (KDB * kdb, KeySet * config, KeySet * modules, Key * errorK
 		if (keyRel (root, cur) == 1)
 		{
 			KeySet * cut = ksCut (config, cur);
-			Backend * backend = elektraBackendOpen (cut, modules, errorKey);
+			Backend * backend = open (cut, modules, errorKey);
 
 			if (!backend)
 			{
@@ -95,6 +87,46 @@ int elektraMountOpen (KDB * kdb, KeySet * config, KeySet * modules, Key * errorK
 	return ret;
 }
 
+/**
+ * Creates a trie from a given configuration.
+ *
+ * The config will be deleted within this function.
+ *
+ * @note elektraMountDefault is not allowed to be executed before
+ *
+ * @param kdb the handle to work with
+ * @param modules the current list of loaded modules
+ * @param config the configuration which should be used to build up the trie.
+ * @param errorKey the key used to report warnings
+ * @retval -1 on failure
+ * @retval 0 on success
+ * @ingroup mount
+ */
+int elektraMountOpen (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey)
+{
+	return elektraMountOpenWith (kdb, config, modules, errorKey, elektraBackendOpen);
+}
+
+/**
+ * Creates a trie from a given configuration without opening any plugin.
+ *
+ * Same as elektraMountOpen(), but the plugins of a backend are opened
+ * with elektraBackendLoad() when the backend is used the first time.
+ *
+ * @param kdb the handle to work with
+ * @param modules the current list of loaded modules, must stay valid
+ *        until all backends are loaded or closed
+ * @param config the configuration which should be used to build up the trie.
+ * @param errorKey the key used to report warnings
+ * @retval -1 on failure
+ * @retval 0 on success
+ * @ingroup mount
+ */
+int elektraMountOpenLazy (KDB * kdb, KeySet * config, KeySet * modules, Key * errorKey)
+{
+	return elektraMountOpenWith (kdb, config, modules, errorKey, elektraBackendOpenLazy);
+}
+
 
 /** Reopens the default backend and mounts the default backend if needed.
  *
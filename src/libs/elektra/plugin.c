@@ -336,6 +336,79 @@ int elektraPluginClose (Plugin * handle, Key * errorKey)
 	return rc;
 }
 
+/**
+ * @internal
+ *
+ * Asks the contract of the plugin if @p clause is set to 1.
+ *
+ * @param handle the plugin to ask
+ * @param clause the name of the clause below the contract, e.g. infos/threadsafe
+ * @retval 1 if the clause is 1
+ * @retval -1 otherwise
+ */
+static int elektraPluginContractSet (Plugin * handle, const char * clause)
+{
+	if (!handle->kdbGet || !handle->name) return -1;
+
+	Key * contractKey = keyNew ("system/elektra/modules", KEY_END);
+	keyAddBaseName (contractKey, handle->name);
+	KeySet * contract = ksNew (0, KS_END);
+
+	handle->kdbGet (handle, contract, contractKey);
+
+	keyAddName (contractKey, clause);
+	Key * found = ksLookup (contract, contractKey, 0);
+	int ret = found && !strcmp (keyString (found), "1") ? 1 : -1;
+
+	ksDel (contract);
+	keyDel (contractKey);
+	return ret;
+}
+
+/**
+ * @internal
+ *
+ * Checks if the plugin may run in parallel to other plugins.
+ *
+ * Plugins opt in with the contract clause infos/threadsafe = 1,
+ * after it was checked that they use neither global state nor
+ * functions of the libc which are not reentrant (e.g. getmntent()).
+ * The contract is only asked once, the answer is cached within the plugin.
+ *
+ * @param handle the plugin to check
+ * @retval 1 if the plugin is thread-safe
+ * @retval 0 if not (or on NULL pointer)
+ */
+int elektraPluginThreadSafe (Plugin * handle)
+{
+	if (!handle) return 0;
+	if (!handle->threadsafe) handle->threadsafe = elektraPluginContractSet (handle, "infos/threadsafe");
+	return handle->threadsafe == 1;
+}
+
+/**
+ * @internal
+ *
+ * Checks if the cache of kdbGet() may be used instead of the plugin.
+ *
+ * Plugins opt in with the contract clause infos/cacheable = 1 if
+ * the keys they return are the only effect of their kdbGet(). Plugins
+ * which keep state for kdbSet() (within the plugin or in meta data
+ * of the parentKey) must not opt in, because kdbSet() would miss
+ * that state after the keys were read from the cache.
+ * The contract is only asked once, the answer is cached within the plugin.
+ *
+ * @param handle the plugin to check
+ * @retval 1 if the plugin may be replaced by the cache
+ * @retval 0 if not (or on NULL pointer)
+ */
+int elektraPluginCacheable (Plugin * handle)
+{
+	if (!handle) return 0;
+	if (!handle->cacheable) handle->cacheable = elektraPluginContractSet (handle, "infos/cacheable");
+	return handle->cacheable == 1;
+}
+
 static int elektraMissingGet (Plugin * plugin ELEKTRA_UNUSED, KeySet * ks ELEKTRA_UNUSED, Key * error)
 {
 	ELEKTRA_SET_ERROR (62, error, keyName (error));
@@ -115,6 +115,7 @@ Key * elektraKsPopAtCursor (KeySet * ks, cursor_t pos)
 
 	size_t c = pos;
 	if (c >= ks->size) return 0;
+	if (elektraKsUnshare (ks) == -1) return 0;
 
 	if (c != ks->size - 1)
 	{
@@ -133,6 +134,7 @@ Key * elektraKsPopAtCursor (KeySet * ks, cursor_t pos)
 		 * */
 		memmove (found, found + 1, (ks->size - c - 1) * sizeof (Key *));
 		*(ks->array + ks->size - 1) = k; // prepare last element to pop
+		elektraKsIndexInvalidate (ks);
 	}
 	else
 	{
@@ -374,6 +374,194 @@ int elektraSplitBuildup (Split * split, KDB * kdb, Key * parentKey)
 }
 
 
+/**
+ * @internal
+ *
+ * Compare positions within a key set, for qsort().
+ */
+static int elektraSplitComparePos (const void * a, const void * b)
+{
+	size_t pa = *(const size_t *)a;
+	size_t pb = *(const size_t *)b;
+	return pa < pb ? -1 : pa > pb;
+}
+
+/**
+ * @internal
+ *
+ * Find the positions in @p ks where the responsible backend may change.
+ *
+ * All keys below a mountpoint are contiguous in a sorted key set,
+ * so only the first key and the key after the last key below each
+ * mountpoint (found with binary searches) start a new range.
+ * The namespaces are added as well, so that every range lies
+ * within a single namespace.
+ * All keys of one range belong to the same backend then, because
+ * handle->split lists every mountpoint inserted into the trie.
+ *
+ * @param handle to get all mountpoints from
+ * @param ks the sorted key set to divide
+ * @param positions will point to the allocated, sorted positions,
+ *        the first one is 0 and the last one is the size of @p ks
+ *
+ * @return the number of positions
+ * @retval -1 on memory error
+ */
+static ssize_t elektraSplitRanges (KDB * handle, KeySet * ks, size_t ** positions)
+{
+	static const char * const namespaces[] = { "spec", "proc", "dir", "user", "system", 0 };
+	const size_t mountpoints = handle->split ? handle->split->size : 0;
+	size_t * pos = elektraMalloc ((2 * mountpoints + 2 * 5 + 2) * sizeof (size_t));
+	if (!pos) return -1;
+
+	size_t n = 0;
+	ElektraKeySetView view;
+
+	pos[n++] = 0;
+	pos[n++] = ks->size;
+
+	for (size_t i = 0; i < mountpoints; ++i)
+	{
+		if (elektraKsView (ks, handle->split->parents[i], &view) == -1) continue;
+		pos[n++] = view.begin;
+		pos[n++] = view.end;
+	}
+
+	Key * root = keyNew (0, KEY_END);
+	for (const char * const * ns = namespaces; *ns; ++ns)
+	{
+		keySetName (root, *ns);
+		if (elektraKsView (ks, root, &view) == -1) continue;
+		pos[n++] = view.begin;
+		pos[n++] = view.end;
+	}
+	keyDel (root);
+
+	qsort (pos, n, sizeof (size_t), elektraSplitComparePos);
+
+	size_t unique = 1;
+	for (size_t i = 1; i < n; ++i)
+	{
+		if (pos[i] != pos[unique - 1]) pos[unique++] = pos[i];
+	}
+
+	*positions = pos;
+	return unique;
+}
+
+/**
+ * @internal
+ *
+ * Append the keys [begin, end) of @p ks to @p dest with a single merge.
+ */
+static void elektraSplitAppendRange (KeySet * dest, KeySet * ks, size_t begin, size_t end)
+{
+	KeySet range;
+	ksInit (&range);
+	range.array = ks->array + begin;
+	range.size = end - begin;
+	range.alloc = range.size;
+	ksAppend (dest, &range);
+}
+
+/**
+ * @internal
+ *
+ * Divide the keys [begin, end) of @p ks, which belong to the same backend.
+ *
+ * The keys of a range share their namespace. Only keys of the
+ * namespaces spec, dir, user and system are stored by backends,
+ * ranges of other keys (cascading, proc, meta) are skipped, like
+ * keys of backends not relevant for this kdbSet().
+ *
+ * @param onlySync only divide the keys of backends already marked for sync,
+ *        without searching for sync bits
+ *
+ * @retval 0 if there were no sync bits
+ * @retval 1 if there were sync bits
+ * @retval -1 if no backend was found (the cursor of @p ks is set to the key)
+ */
+static int elektraSplitDivideRange (Split * split, KDB * handle, KeySet * ks, size_t begin, size_t end, int onlySync)
+{
+	Key * curKey = ks->array[begin];
+
+	switch (keyGetNamespace (curKey))
+	{
+	case KEY_NS_SPEC:
+	case KEY_NS_DIR:
+	case KEY_NS_USER:
+	case KEY_NS_SYSTEM:
+		break;
+	case KEY_NS_PROC:
+	case KEY_NS_EMPTY:
+	case KEY_NS_NONE:
+	case KEY_NS_META:
+	case KEY_NS_CASCADING:
+		return 0; // not stored by any backend
+	}
+
+	Backend * curHandle = elektraMountGetBackend (handle, curKey);
+	if (!curHandle)
+	{
+		ksSetCursor (ks, begin); // for the error message
+		return -1;
+	}
+
+	ssize_t curFound = elektraSplitSearchBackend (split, curHandle, curKey);
+
+	if (curFound == -1) return 0; // keys not relevant in this kdbSet
+
+	if (onlySync)
+	{
+		if (!test_bit (split->syncbits[curFound], SPLIT_FLAG_SYNC)) return 0;
+		elektraSplitAppendRange (split->keysets[curFound], ks, begin, end);
+		return 1;
+	}
+
+	elektraSplitAppendRange (split->keysets[curFound], ks, begin, end);
+
+	int needsSync = 0;
+	for (size_t i = begin; i < end; ++i)
+	{
+		if (keyNeedSync (ks->array[i]) == 1)
+		{
+			split->syncbits[curFound] |= 1;
+			needsSync = 1;
+			break;
+		}
+	}
+
+	return needsSync;
+}
+
+/**
+ * @internal
+ *
+ * Divide all ranges of @p ks, see elektraSplitDivideRange().
+ */
+static int elektraSplitDivideRanges (Split * split, KDB * handle, KeySet * ks, int onlySync)
+{
+	int needsSync = 0;
+	size_t * positions = 0;
+
+	ssize_t size = elektraSplitRanges (handle, ks, &positions);
+	if (size == -1) return -1;
+
+	for (ssize_t i = 0; i + 1 < size; ++i)
+	{
+		int ret = elektraSplitDivideRange (split, handle, ks, positions[i], positions[i + 1], onlySync);
+		if (ret == -1)
+		{
+			elektraFree (positions);
+			return -1;
+		}
+		needsSync |= ret;
+	}
+
+	elektraFree (positions);
+	return needsSync;
+}
+
 /**
  * Splits up the keysets and search for a sync bit in every key.
  *
@@ -383,6 +571,10 @@ int elektraSplitBuildup (Split * split, KDB * kdb, Key * parentKey)
  * It does not create new backends, this has to be
  * done by buildup before.
  *
+ * Instead of looking up the backend of every key, the sorted
+ * keyset is divided into ranges of keys below the same mountpoint,
+ * see elektraSplitRanges().
+ *
  * @pre elektraSplitBuildup() need to be executed before.
  *
  * @param split the split object to work with
@@ -396,31 +588,64 @@ int elektraSplitBuildup (Split * split, KDB * kdb, Key * parentKey)
  */
 int elektraSplitDivide (Split * split, KDB * handle, KeySet * ks)
 {
-	ssize_t curFound = 0; /* If key could be appended to any of the existing split keysets */
+	return elektraSplitDivideRanges (split, handle, ks, 0);
+}
+
+/**
+ * Splits up the keysets of the backends with changed keys.
+ *
+ * Instead of searching for a sync bit in every key, the backends
+ * of the changed, added or removed keys (see elektraKsChanges())
+ * are marked for sync. Only their keys are divided, the keysets
+ * of all other backends stay empty.
+ *
+ * Because the removed keys are known, elektraSplitSyncState()
+ * replaces elektraSplitSync() afterwards.
+ *
+ * @pre elektraSplitBuildup() need to be executed before.
+ *
+ * @param split the split object to work with
+ * @param handle to get information where the individual keys belong
+ * @param ks the keyset to divide
+ * @param changes the names of all keys changed in @p ks
+ * @param errorKey set to the key without backend on failure, it might
+ *        be a removed key, which is not within @p ks anymore
+ *
+ * @retval 0 if no backend needs sync
+ * @retval 1 if a backend needs sync
+ * @retval -1 if no backend was found for any key
+ * @ingroup split
+ */
+int elektraSplitDivideChanges (Split * split, KDB * handle, KeySet * ks, KeySet * changes, Key ** errorKey)
+{
 	int needsSync = 0;
-	Key * curKey = 0;
-	Backend * curHandle = 0;
 
-	ksRewind (ks);
-	while ((curKey = ksNext (ks)) != 0)
+	for (size_t i = 0; i < changes->size; ++i)
 	{
-		// TODO: handle keys in wrong namespaces
-		curHandle = elektraMountGetBackend (handle, curKey);
-		if (!curHandle) return -1;
-
-		curFound = elektraSplitSearchBackend (split, curHandle, curKey);
-
-		if (curFound == -1) continue; // key not relevant in this kdbSet
-
-		ksAppendKey (split->keysets[curFound], curKey);
-		if (keyNeedSync (curKey) == 1)
+		Key * curKey = changes->array[i];
+		Backend * curHandle = elektraMountGetBackend (handle, curKey);
+		if (!curHandle)
 		{
-			split->syncbits[curFound] |= 1;
-			needsSync = 1;
+			*errorKey = curKey;
+			return -1;
 		}
+
+		ssize_t curFound = elektraSplitSearchBackend (split, curHandle, curKey);
+		if (curFound == -1) continue; // keys not relevant in this kdbSet
+
+		set_bit (split->syncbits[curFound], SPLIT_FLAG_SYNC);
+		needsSync = 1;
 	}
 
-	return needsSync;
+	if (!needsSync) return 0;
+
+	// backends might need sync although all their keys were removed
+	if (elektraSplitDivideRanges (split, handle, ks, 1) == -1)
+	{
+		*errorKey = ksCurrent (ks);
+		return -1;
+	}
+	return 1;
 }
 
 /**
@@ -448,6 +673,9 @@ void elektraSplitUpdateFileName (Split * split, KDB * handle, Key * key)
 /**
  * Appoints all keys from ks to yet unsynced splits.
  *
+ * Like elektraSplitDivide() the backend is only looked up
+ * once for every range of keys below the same mountpoint.
+ *
  * @pre elektraSplitBuildup() need to be executed before.
  *
  * @param split the split object to work with
@@ -464,12 +692,20 @@ int elektraSplitAppoint (Split * split, KDB * handle, KeySet * ks)
 	Key * curKey = 0;
 	Backend * curHandle = 0;
 	ssize_t defFound = elektraSplitAppend (split, 0, 0, 0);
+	size_t * positions = 0;
 
-	ksRewind (ks);
-	while ((curKey = ksNext (ks)) != 0)
+	ssize_t size = elektraSplitRanges (handle, ks, &positions);
+	if (size == -1) return -1;
+
+	for (ssize_t i = 0; i + 1 < size; ++i)
 	{
+		curKey = ks->array[positions[i]];
 		curHandle = elektraMountGetBackend (handle, curKey);
-		if (!curHandle) return -1;
+		if (!curHandle)
+		{
+			elektraFree (positions);
+			return -1;
+		}
 
 		curFound = elektraSplitSearchBackend (split, curHandle, curKey);
 
@@ -480,9 +716,10 @@ int elektraSplitAppoint (Split * split, KDB * handle, KeySet * ks)
 			continue;
 		}
 
-		ksAppendKey (split->keysets[curFound], curKey);
+		elektraSplitAppendRange (split->keysets[curFound], ks, positions[i], positions[i + 1]);
 	}
 
+	elektraFree (positions);
 	return 1;
 }
 
@@ -727,6 +964,36 @@ int elektraSplitMerge (Split * split, KeySet * dest)
 	return 1;
 }
 
+/**
+ * @internal
+ *
+ * The size of the keys of split @p i from the previous kdbGet().
+ *
+ * @return a pointer to the size within the backend
+ * @retval 0 on wrong namespace of the parent
+ */
+static ssize_t * elektraSplitPreviousSize (Split * split, size_t i)
+{
+	switch (keyGetNamespace (split->parents[i]))
+	{
+	case KEY_NS_SPEC:
+		return &split->handles[i]->specsize;
+	case KEY_NS_DIR:
+		return &split->handles[i]->dirsize;
+	case KEY_NS_USER:
+		return &split->handles[i]->usersize;
+	case KEY_NS_SYSTEM:
+		return &split->handles[i]->systemsize;
+	case KEY_NS_PROC:
+	case KEY_NS_EMPTY:
+	case KEY_NS_META:
+	case KEY_NS_CASCADING:
+	case KEY_NS_NONE:
+		break;
+	}
+	return 0;
+}
+
 /** Add sync bits everywhere keys were removed/added.
  *
  * - checks if the size of a previous kdbGet() is unchanged.
@@ -751,76 +1018,55 @@ int elektraSplitMerge (Split * split, KeySet * dest)
 **/
 int elektraSplitSync (Split * split)
 {
+	int state = elektraSplitSyncState (split);
+	if (state < 0) return state;
+
 	int needsSync = 0;
 
 	for (size_t i = 0; i < split->size; ++i)
 	{
-		// first check for wrong states etc.
-		switch (keyGetNamespace (split->parents[i]))
+		/* Check for removed keys */
+		if (*elektraSplitPreviousSize (split, i) != ksGetSize (split->keysets[i]))
+		{
+			set_bit (split->syncbits[i], SPLIT_FLAG_SYNC);
+			needsSync = 1;
+		}
+	}
+
+	return needsSync;
+}
+
+/** Check if all backends of the split are in correct state.
+ *
+ * Same checks as elektraSplitSync(), but without comparing sizes.
+ *
+ * @retval 0 if all backends are in correct state
+ * @retval -1 on wrong keys (also has assert, should not happen)
+ * @retval -2-i wrong state of split i: kdbGet() was not executed before
+ * @param split the split object to work with
+ * @see elektraSplitDivideChanges()
+ * @ingroup split
+ *
+**/
+int elektraSplitSyncState (Split * split)
+{
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		ssize_t * size = elektraSplitPreviousSize (split, i);
+		if (!size)
 		{
-		case KEY_NS_SPEC:
-			// Check if we are in correct state
-			if (split->handles[i]->specsize == -1)
-			{
-				return -i - 2;
-			}
-			/* Check for spec keyset for removed keys */
-			if (split->handles[i]->specsize != ksGetSize (split->keysets[i]))
-			{
-				set_bit (split->syncbits[i], SPLIT_FLAG_SYNC);
-				needsSync = 1;
-			}
-			break;
-		case KEY_NS_DIR:
-			// Check if we are in correct state
-			if (split->handles[i]->dirsize == -1)
-			{
-				return -i - 2;
-			}
-			/* Check for dir keyset for removed keys */
-			if (split->handles[i]->dirsize != ksGetSize (split->keysets[i]))
-			{
-				set_bit (split->syncbits[i], SPLIT_FLAG_SYNC);
-				needsSync = 1;
-			}
-			break;
-		case KEY_NS_USER:
-			// Check if we are in correct state
-			if (split->handles[i]->usersize == -1)
-			{
-				return -i - 2;
-			}
-			/* Check for user keyset for removed keys */
-			if (split->handles[i]->usersize != ksGetSize (split->keysets[i]))
-			{
-				set_bit (split->syncbits[i], SPLIT_FLAG_SYNC);
-				needsSync = 1;
-			}
-			break;
-		case KEY_NS_SYSTEM:
-			// Check if we are in correct state
-			if (split->handles[i]->systemsize == -1)
-			{
-				return -i - 2;
-			}
-			/* Check for system keyset for removed keys */
-			if (split->handles[i]->systemsize != ksGetSize (split->keysets[i]))
-			{
-				set_bit (split->syncbits[i], SPLIT_FLAG_SYNC);
-				needsSync = 1;
-			}
-			break;
-		case KEY_NS_PROC:
-		case KEY_NS_EMPTY:
-		case KEY_NS_META:
-		case KEY_NS_CASCADING:
-		case KEY_NS_NONE:
 			ELEKTRA_ASSERT (0 && "Got keys that should not be here");
 			return -1;
 		}
+
+		// Check if we are in correct state
+		if (*size == -1)
+		{
+			return -i - 2;
+		}
 	}
 
-	return needsSync;
+	return 0;
 }
 
 /** Prepares for kdbSet() mainloop afterwards.
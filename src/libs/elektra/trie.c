@@ -32,8 +32,10 @@
 
 #include "kdbinternal.h"
 
-static char * elektraTrieStartsWith (const char * str, const char * substr);
-static Backend * elektraTriePrefixLookup (Trie * trie, const char * name);
+static Trie * elektraTrieNewNode (const char * text, size_t textlen);
+static ssize_t elektraTrieFindChild (const Trie * trie, unsigned char c);
+static int elektraTrieAddChild (Trie * trie, Trie * child, unsigned char c);
+static int elektraTrieMatches (const Trie * child, const char * name, size_t size, size_t pos);
 
 /**
  * @brief Internal Datastructure for mountpoints
@@ -44,6 +46,10 @@ static Backend * elektraTriePrefixLookup (Trie * trie, const char * name);
 /**
  * Lookups a backend inside the trie.
  *
+ * The name of the key is searched as if it ended with a '/',
+ * so that mountpoints (which end with '/') only match whole
+ * parts of the name. Nothing is allocated.
+ *
  * @return the backend if found
  * @return 0 otherwise
  * @param trie the trie object to work with
@@ -52,21 +58,29 @@ static Backend * elektraTriePrefixLookup (Trie * trie, const char * name);
  */
 Backend * elektraTrieLookup (Trie * trie, const Key * key)
 {
-	char * where = 0;
-	Backend * ret = 0;
-	size_t len = 0;
-
 	if (!key) return 0;
 	if (!trie) return 0;
 
-	len = keyGetNameSize (key) + 1;
-	if (len <= 1) return 0; // would crash otherwise
-	where = elektraMalloc (len);
-	strncpy (where, keyName (key), len);
-	where[len - 2] = '/';
+	const char * name = keyName (key);
+	const ssize_t size = keyGetNameSize (key); // with '/' instead of the null byte
+	if (size <= 0) return 0;
+
+	Backend * ret = trie->value;
+	size_t pos = 0;
 
-	ret = elektraTriePrefixLookup (trie, where);
-	elektraFree (where);
+	while (pos < (size_t)size)
+	{
+		unsigned char c = pos + 1 < (size_t)size ? (unsigned char)name[pos] : '/';
+		ssize_t i = elektraTrieFindChild (trie, c);
+		if (i == -1) break;
+
+		Trie * child = trie->children[i];
+		if (!elektraTrieMatches (child, name, size, pos)) break;
+
+		pos += child->textlen;
+		trie = child;
+		if (trie->value) ret = trie->value;
+	}
 
 	return ret;
 }
@@ -81,192 +95,212 @@ Backend * elektraTrieLookup (Trie * trie, const Key * key)
  */
 int elektraTrieClose (Trie * trie, Key * errorKey)
 {
-	size_t i;
 	if (trie == NULL) return 0;
-	for (i = 0; i < KDB_MAX_UCHAR; ++i)
+	for (size_t i = 0; i < trie->size; ++i)
 	{
-		if (trie->text[i] != NULL)
-		{
-			elektraTrieClose (trie->children[i], errorKey);
-			if (trie->value[i]) elektraBackendClose (trie->value[i], errorKey);
-			elektraFree (trie->text[i]);
-		}
+		elektraTrieClose (trie->children[i], errorKey);
 	}
-	if (trie->empty_value)
+	if (trie->value)
 	{
-		elektraBackendClose (trie->empty_value, errorKey);
+		elektraBackendClose (trie->value, errorKey);
 	}
+	elektraFree (trie->children);
+	elektraFree (trie->index);
 	elektraFree (trie);
 	return 0;
 }
+
+/**
+ * Inserts a backend into the trie.
+ *
+ * If another backend was inserted with the same name before,
+ * the new one is found by lookups, both get closed with the trie.
+ *
+ * @param trie the trie to insert to (0 to create a new one)
+ * @param name the name to insert (mountpoints end with '/')
+ * @param value the backend to insert
+ *
+ * @return the trie
+ * @retval 0 on memory error while creating a new trie
+ * @ingroup trie
+ */
 Trie * elektraTrieInsert (Trie * trie, const char * name, Backend * value)
 {
-	char * p;
-	unsigned char idx;
-
 	if (name == 0)
 	{
 		name = "";
 	}
-	idx = (unsigned char)name[0];
 
 	if (trie == NULL)
 	{
-		trie = elektraCalloc (sizeof (Trie));
+		trie = elektraTrieNewNode ("", 0);
+		if (!trie) return 0;
+	}
 
-		if (!strcmp ("", name))
+	Trie * node = trie;
+	while (*name)
+	{
+		ssize_t i = elektraTrieFindChild (node, (unsigned char)name[0]);
+		if (i == -1)
 		{
-			trie->empty_value = value;
+			/* there doesn't exist an entry with the same first character */
+			Trie * leaf = elektraTrieNewNode (name, strlen (name));
+			if (!leaf) return trie;
+			if (elektraTrieAddChild (node, leaf, (unsigned char)name[0]) == -1)
+			{
+				elektraFree (leaf);
+				return trie;
+			}
+			leaf->value = value;
 			return trie;
 		}
 
-		trie->textlen[idx] = strlen (name);
-
-		trie->text[idx] = elektraStrDup (name);
+		Trie * child = node->children[i];
+		size_t common = 0;
+		while (common < child->textlen && name[common] == child->text[common])
+		{
+			++common;
+		}
 
-		trie->value[idx] = value;
-		return trie;
-	}
+		if (common < child->textlen)
+		{
+			/* name in trie doesn't match name --> split the node */
+			Trie * middle = elektraTrieNewNode (child->text, common);
+			if (!middle) return trie;
+			if (elektraTrieAddChild (middle, child, (unsigned char)child->text[common]) == -1)
+			{
+				elektraFree (middle);
+				return trie;
+			}
+			memmove (child->text, child->text + common, child->textlen - common + 1);
+			child->textlen -= common;
+			node->children[i] = middle;
+			child = middle;
+		}
 
-	if (!strcmp ("", name))
-	{
-		trie->empty_value = value;
-		return trie;
+		name += common;
+		node = child;
 	}
 
-	if (trie->text[idx])
+	if (node->value && node->value != value)
 	{
-		/* there exists an entry with the same first character */
-		if ((p = elektraTrieStartsWith (name, trie->text[idx])) == 0)
+		/* the replaced backend might still be in use, keep it
+		 * in a child with empty text (never matched by lookups)
+		 * so that it gets closed together with the trie */
+		Trie * replaced = elektraTrieNewNode ("", 0);
+		if (!replaced) return trie;
+		if (elektraTrieAddChild (node, replaced, 0) == -1)
 		{
-			/* the name in the trie is part of the searched name --> continue search */
-			trie->children[idx] = elektraTrieInsert (trie->children[idx], name + trie->textlen[idx], value);
-		}
-		else
-		{
-			/* name in trie doesn't match name --> split trie */
-			char * newname;
-			Trie * child;
-			unsigned char idx2;
-
-			newname = elektraStrDup (p);
-			*p = 0; /* shorten the old name in the trie */
-			trie->textlen[idx] = strlen (trie->text[idx]);
-
-			child = trie->children[idx];
-
-			/* insert the name given as a parameter into the new trie entry */
-			trie->children[idx] = elektraTrieInsert (NULL, name + (p - trie->text[idx]), value);
-
-			/* insert the split try into the new trie entry */
-
-			idx2 = (unsigned char)newname[0];
-			trie->children[idx]->text[idx2] = newname;
-			trie->children[idx]->textlen[idx2] = strlen (newname);
-			trie->children[idx]->value[idx2] = trie->value[idx];
-			trie->children[idx]->children[idx2] = child;
-
-			trie->value[idx] = 0;
+			elektraFree (replaced);
+			return trie;
 		}
+		replaced->value = node->value;
 	}
-	else
-	{
-		/* there doesn't exist an entry with the same first character */
-		trie->text[idx] = elektraStrDup (name);
-		trie->value[idx] = (void *)value;
-		trie->textlen[idx] = strlen (name);
-	}
+	node->value = value;
 
 	return trie;
 }
 
+/**
+ * @}
+ */
+
 
 /******************
  * Private static declarations
  ******************/
 
-
-#if 0
-
-static Trie *delete_trie(Trie *trie, char *name, CloseMapper closemapper)
+/**
+ * Allocate a node without children, the text is stored within the node.
+ */
+static Trie * elektraTrieNewNode (const char * text, size_t textlen)
 {
-	Trie *tr;
-	unsigned char idx;
-	if (trie==NULL) {
-		return NULL;
-	}
-
-	idx=(unsigned char) name[0];
-
-	if (trie->text[idx]==NULL) {
-		return NULL;
-	}
-
-	if (elektraTrieStartsWith(name,trie->text[idx])==0) {
-
-		tr=delete_trie(trie->children[idx],name+trie->textlen[idx],closemapper);
+	Trie * trie = elektraCalloc (sizeof (Trie) + textlen + 1);
+	if (!trie) return 0;
 
-		if (tr==NULL) {
-			/* child trie has been deleted */
-			trie->children[idx]=NULL;
-			elektraFree (trie->text[idx]);
-			closemapper(trie->value[idx]);
-			trie->text[idx]=NULL;
-		}
+	trie->text = (char *)(trie + 1);
+	memcpy (trie->text, text, textlen);
+	trie->textlen = textlen;
 
-		return trie;
-	}
-	return NULL;
+	return trie;
 }
 
-#endif
-
 /**
- * return NULL if string starts with substring, except for the terminating '\0',
- * otherwise return a pointer to the first mismatch in substr.
+ * Find the child whose text starts with the character c.
  *
- * Takes const char* arguments but return char* pointer to it.
- * (like e.g. strchr)
+ * @return the position of the child
+ * @retval -1 if there is no such child
  */
-static char * elektraTrieStartsWith (const char * str, const char * substr)
+static ssize_t elektraTrieFindChild (const Trie * trie, unsigned char c)
 {
-	size_t i = 0;
-	size_t sublen = strlen (substr);
+	if (trie->index)
+	{
+		return (ssize_t)trie->index[c] - 1;
+	}
 
-	for (i = 0; i < sublen; i++)
+	for (size_t i = 0; i < trie->size; ++i)
 	{
-		if (substr[i] != str[i]) return (char *)substr + i;
+		if (trie->first[i] == c) return i;
 	}
-	return 0;
+	return -1;
 }
 
-static Backend * elektraTriePrefixLookup (Trie * trie, const char * name)
+/**
+ * Add a child whose text starts with the character c.
+ *
+ * The room for children grows from 4 over 16 to 48 and is
+ * doubled afterwards, nodes with more than ELEKTRA_TRIE_SMALL
+ * children get an index.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+static int elektraTrieAddChild (Trie * trie, Trie * child, unsigned char c)
 {
-	if (trie == NULL) return NULL;
-
-	unsigned char idx = (unsigned char)name[0];
-	const char * trieText = trie->text[idx];
-
-	if (trieText == NULL)
+	if (trie->size == trie->alloc)
 	{
-		return trie->empty_value;
+		size_t alloc = trie->alloc == 0 ? 4 : trie->alloc == 4 ? ELEKTRA_TRIE_SMALL : trie->alloc == ELEKTRA_TRIE_SMALL ? 48 : trie->alloc * 2;
+		if (elektraRealloc ((void **)&trie->children, alloc * sizeof (Trie *)) == -1) return -1;
+
+		// first only has room for ELEKTRA_TRIE_SMALL children, so the
+		// index must exist before alloc says there is room for more
+		if (alloc > ELEKTRA_TRIE_SMALL && !trie->index)
+		{
+			trie->index = elektraCalloc (KDB_MAX_UCHAR * sizeof (unsigned short));
+			if (!trie->index) return -1;
+			for (size_t i = 0; i < trie->size; ++i)
+			{
+				trie->index[trie->first[i]] = i + 1;
+			}
+		}
+		trie->alloc = alloc;
 	}
 
-	void * ret = NULL;
-	if (elektraTrieStartsWith (name, trieText) == 0)
+	if (trie->index)
 	{
-		ret = elektraTriePrefixLookup (trie->children[idx], name + trie->textlen[idx]);
+		trie->index[c] = trie->size + 1;
 	}
 	else
 	{
-		return trie->empty_value;
+		trie->first[trie->size] = c;
 	}
+	trie->children[trie->size++] = child;
 
-	if (ret == NULL && trie->value[idx] == NULL)
-	{
-		return trie->empty_value;
-	}
-	if (ret == NULL) return trie->value[idx];
+	return 0;
+}
 
-	return ret;
+/**
+ * Check if the text of child continues the name at pos.
+ *
+ * The name is compared as if its null byte (at size - 1) was a '/'.
+ */
+static int elektraTrieMatches (const Trie * child, const char * name, size_t size, size_t pos)
+{
+	const size_t end = pos + child->textlen;
+
+	if (end > size) return 0;
+	if (end < size) return !memcmp (child->text, name + pos, child->textlen);
+
+	/* the text ends with the '/' after the name */
+	return child->text[child->textlen - 1] == '/' && !memcmp (child->text, name + pos, child->textlen - 1);
 }
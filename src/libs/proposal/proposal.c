@@ -60,14 +60,14 @@ ssize_t keySetStringF (Key * key, const char * format, ...)
 		return -1;
 	}
 
-	if (key->data.c)
+	if (key->data.c && !elektraKeyIsBorrowed (key, key->data.c))
 	{
 		elektraFree (key->data.c);
 	}
 
 	key->data.c = p;
 	key->dataSize = elektraStrLen (key->data.c);
-	set_bit (key->flags, KEY_FLAG_SYNC);
+	elektraKeyChanged (key);
 
 	return key->dataSize;
 }
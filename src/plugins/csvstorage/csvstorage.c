@@ -18,6 +18,7 @@
 #include <kdbease.h>
 #include <kdberrors.h>
 #include <kdbhelper.h>
+#include <kdbproposal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -223,6 +224,17 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 	Key * cur;
 	dirKey = keyDup (parentKey);
 	keyAddName (dirKey, "#");
+	// the keys of a row are read before the key of the row itself
+	ElektraKsBuilder * builder = elektraKsBuilderNew (0);
+	if (!builder)
+	{
+		elektraFree (lineBuffer);
+		keyDel (dirKey);
+		ksDel (header);
+		fclose (fp);
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return -1;
+	}
 	while (!feof (fp))
 	{
 		length = getLineLength (fp);
@@ -233,6 +245,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			elektraFree (lineBuffer);
 			ksDel (header);
 			keyDel (dirKey);
+			elektraKsBuilderDel (builder);
 			ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
 			return -1;
 		}
@@ -241,6 +254,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 		{
 			elektraFree (lineBuffer);
 			keyDel (dirKey);
+			elektraKsBuilderDel (builder);
 			ksDel (header);
 			fclose (fp);
 			return -1;
@@ -254,19 +268,43 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 			cur = getKeyByOrderNr (header, colCounter);
 			offset += elektraStrLen (col);
 			key = keyDup (dirKey);
+			const char * colName;
 			if (useHeader != 1)
-				keyAddBaseName (key, keyString (cur));
+				colName = keyString (cur);
 			else
-				keyAddBaseName (key, keyBaseName (cur));
+				colName = keyBaseName (cur);
+			keyAddBaseName (key, colName);
+			// the key keeps the name of dirKey without a column name
+			lastIndex = (char *)(colName ? colName : keyBaseName (dirKey));
 			keySetString (key, col);
 			keySetMeta (key, "csv/order", itostr (buf, colCounter, sizeof (buf) - 1));
-			ksAppendKey (returned, key);
-			lastIndex = (char *)keyBaseName (key);
+			if (elektraKsBuilderAdd (builder, key) == -1)
+			{
+				elektraFree (lineBuffer);
+				fclose (fp);
+				keyDel (dirKey);
+				elektraKsBuilderDel (builder);
+				ksDel (header);
+				keyDel (key);
+				ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+				return -1;
+			}
 			++nr_keys;
 			++colCounter;
 		}
 		keySetString (dirKey, lastIndex);
-		ksAppendKey (returned, keyDup (dirKey));
+		key = keyDup (dirKey);
+		if (elektraKsBuilderAdd (builder, key) == -1)
+		{
+			elektraFree (lineBuffer);
+			fclose (fp);
+			keyDel (dirKey);
+			elektraKsBuilderDel (builder);
+			ksDel (header);
+			keyDel (key);
+			ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+			return -1;
+		}
 		if (colCounter != columns)
 		{
 			if (fixColumnCount)
@@ -275,6 +313,7 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 				elektraFree (lineBuffer);
 				fclose (fp);
 				keyDel (dirKey);
+				elektraKsBuilderDel (builder);
 				ksDel (header);
 				return -1;
 			}
@@ -284,7 +323,28 @@ static int csvRead (KeySet * returned, Key * parentKey, char delim, short useHea
 	}
 	key = keyDup (parentKey);
 	keySetString (key, keyBaseName (dirKey));
-	ksAppendKey (returned, key);
+	if (elektraKsBuilderAdd (builder, key) == -1)
+	{
+		elektraKsBuilderDel (builder);
+		keyDel (dirKey);
+		fclose (fp);
+		elektraFree (lineBuffer);
+		ksDel (header);
+		keyDel (key);
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return -1;
+	}
+	if (elektraKsBuilderFinish (builder, returned) == -1)
+	{
+		elektraKsBuilderDel (builder);
+		keyDel (dirKey);
+		fclose (fp);
+		elektraFree (lineBuffer);
+		ksDel (header);
+		ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+		return -1;
+	}
+	elektraKsBuilderDel (builder);
 	keyDel (dirKey);
 	fclose (fp);
 	elektraFree (lineBuffer);
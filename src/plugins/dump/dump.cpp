@@ -6,18 +6,344 @@
  * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
  */
 
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
 #include "dump.hpp"
 #include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#include <iterator>
+#include <unordered_map>
 
 using namespace ckdb;
 
 #include <kdberrors.h>
+#include <kdbproposal.h>
 
 
 namespace dump
 {
 
+namespace
+{
+
+/**
+ * Layout of version 2, all numbers are little endian:
+ *
+ * - header (DUMP_HEADER_SIZE bytes): the magic line padded with null bytes to 16 bytes,
+ *   then the number of keys, the number of metadata, the offset of the key index,
+ *   the offset of the metadata index and the size of the file, each 8 bytes
+ * - key index: the offset of every key record, 8 bytes each
+ * - metadata index: the offset of every metadata record, 8 bytes each
+ * - metadata records: size of name and value (8 bytes each), name and value
+ * - key records: size of name and value (8 bytes each), flags and number of
+ *   metadata (4 bytes each), name, value and the position of every metadata
+ *   within the metadata index (4 bytes each)
+ *
+ * Names and string values include their null byte.
+ * Every record starts at an offset aligned to DUMP_ALIGN.
+ */
+const char DUMP_MAGIC_V2[] = "kdbOpen 2\n";
+const size_t DUMP_MAGIC_SIZE = 16;
+const size_t DUMP_HEADER_SIZE = 64;
+const size_t DUMP_ALIGN = 8;
+const size_t DUMP_KEY_RECORD_SIZE = 24;
+const size_t DUMP_META_RECORD_SIZE = 16;
+
+const uint32_t DUMP_BINARY = 1; ///< key is binary
+const uint32_t DUMP_VALUE = 2;	///< key has a value (binary keys may have none)
+
+void putNumber (std::string & out, size_t pos, uint64_t value, size_t bytes)
+{
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		out[pos + i] = static_cast<char> (value >> (8 * i));
+	}
+}
+
+void appendNumber (std::string & out, uint64_t value, size_t bytes)
+{
+	size_t pos = out.size ();
+	out.resize (pos + bytes);
+	putNumber (out, pos, value, bytes);
+}
+
+void appendPadding (std::string & out)
+{
+	out.resize ((out.size () + DUMP_ALIGN - 1) / DUMP_ALIGN * DUMP_ALIGN, '\0');
+}
+
+uint64_t getNumber (const char * data, size_t bytes)
+{
+	uint64_t value = 0;
+	for (size_t i = bytes; i-- > 0;)
+	{
+		value = value << 8 | static_cast<unsigned char> (data[i]);
+	}
+	return value;
+}
+
+/**
+ * @retval true if @p length bytes at @p offset are within @p size bytes
+ */
+bool fits (size_t size, uint64_t offset, uint64_t length)
+{
+	return offset <= size && length <= size - offset;
+}
+
+struct DumpMeta
+{
+	const char * name;
+	const char * value;
+	ckdb::Key * owner; ///< the first key which got this metadata, others copy it from there
+};
+
+} // namespace
+
+/**
+ * @brief Write the keys in version 2 of the dump format
+ *
+ * Metadata shared between keys is written once to the
+ * metadata table, each key refers to it by its position.
+ */
 int serialise (std::ostream & os, ckdb::Key *, ckdb::KeySet * ks)
+{
+	std::vector<ckdb::Key *> keys;
+	std::vector<const ckdb::Key *> metas;
+	std::unordered_map<const ckdb::Key *, uint32_t> metaPositions;
+
+	ckdb::Key * cur;
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != nullptr)
+	{
+		keys.push_back (cur);
+
+		const ckdb::Key * meta;
+		ckdb::keyRewindMeta (cur);
+		while ((meta = ckdb::keyNextMeta (cur)) != nullptr)
+		{
+			if (metaPositions.emplace (meta, metas.size ()).second) metas.push_back (meta);
+		}
+	}
+
+	std::string out (DUMP_HEADER_SIZE, '\0');
+	out.replace (0, sizeof (DUMP_MAGIC_V2) - 1, DUMP_MAGIC_V2);
+	size_t keyIndex = out.size ();
+	out.resize (keyIndex + 8 * keys.size ());
+	size_t metaIndex = out.size ();
+	out.resize (metaIndex + 8 * metas.size ());
+
+	for (size_t i = 0; i < metas.size (); ++i)
+	{
+		size_t namesize = ckdb::keyGetNameSize (metas[i]);
+		size_t valuesize = ckdb::keyGetValueSize (metas[i]);
+		putNumber (out, metaIndex + 8 * i, out.size (), 8);
+		appendNumber (out, namesize, 8);
+		appendNumber (out, valuesize, 8);
+		out.append (ckdb::keyName (metas[i]), namesize);
+		out.append (static_cast<const char *> (ckdb::keyValue (metas[i])), valuesize);
+		appendPadding (out);
+	}
+
+	for (size_t i = 0; i < keys.size (); ++i)
+	{
+		cur = keys[i];
+		const void * value = ckdb::keyValue (cur);
+		size_t namesize = ckdb::keyGetNameSize (cur);
+		size_t valuesize = value ? ckdb::keyGetValueSize (cur) : 0;
+		uint32_t flags = (ckdb::keyIsBinary (cur) ? DUMP_BINARY : 0) | (value ? DUMP_VALUE : 0);
+
+		putNumber (out, keyIndex + 8 * i, out.size (), 8);
+		appendNumber (out, namesize, 8);
+		appendNumber (out, valuesize, 8);
+		appendNumber (out, flags, 4);
+		size_t metaCount = out.size ();
+		appendNumber (out, 0, 4);
+		out.append (ckdb::keyName (cur), namesize);
+		out.append (static_cast<const char *> (value), valuesize);
+
+		uint32_t count = 0;
+		const ckdb::Key * meta;
+		ckdb::keyRewindMeta (cur);
+		while ((meta = ckdb::keyNextMeta (cur)) != nullptr)
+		{
+			appendNumber (out, metaPositions[meta], 4);
+			++count;
+		}
+		putNumber (out, metaCount, count, 4);
+		appendPadding (out);
+	}
+
+	putNumber (out, DUMP_MAGIC_SIZE, keys.size (), 8);
+	putNumber (out, DUMP_MAGIC_SIZE + 8, metas.size (), 8);
+	putNumber (out, DUMP_MAGIC_SIZE + 16, keyIndex, 8);
+	putNumber (out, DUMP_MAGIC_SIZE + 24, metaIndex, 8);
+	putNumber (out, DUMP_MAGIC_SIZE + 32, out.size (), 8);
+
+	os.write (out.data (), out.size ());
+
+	return 1;
+}
+
+/**
+ * @brief Read the keys of version 2 of the dump format
+ *
+ * Names and values are passed to the keys directly from @p data,
+ * so when @p data is a mapped file nothing is copied besides
+ * into the keys themselves.
+ *
+ * @param data the whole dump, starting with the magic line
+ * @param size the number of bytes of @p data
+ * @param errorKey to set the error to
+ * @param ks the key set to replace the keys of
+ *
+ * @retval 1 on success
+ * @retval -1 if the dump is corrupt (@p ks is unchanged then)
+ */
+int unserialiseV2 (const char * data, size_t size, ckdb::Key * errorKey, ckdb::KeySet * ks)
+{
+	if (size < DUMP_HEADER_SIZE || memcmp (data, DUMP_MAGIC_V2, sizeof (DUMP_MAGIC_V2) - 1))
+	{
+		ELEKTRA_SET_ERROR (146, errorKey, "header of version 2 missing");
+		return -1;
+	}
+
+	uint64_t nrKeys = getNumber (data + DUMP_MAGIC_SIZE, 8);
+	uint64_t nrMetas = getNumber (data + DUMP_MAGIC_SIZE + 8, 8);
+	uint64_t keyIndex = getNumber (data + DUMP_MAGIC_SIZE + 16, 8);
+	uint64_t metaIndex = getNumber (data + DUMP_MAGIC_SIZE + 24, 8);
+	uint64_t fileSize = getNumber (data + DUMP_MAGIC_SIZE + 32, 8);
+	if (fileSize != size || !fits (size, keyIndex, 0) || nrKeys > (size - keyIndex) / 8 || !fits (size, metaIndex, 0) ||
+	    nrMetas > (size - metaIndex) / 8)
+	{
+		ELEKTRA_SET_ERROR (146, errorKey, "header does not match the size of the file");
+		return -1;
+	}
+
+	std::vector<DumpMeta> metas (nrMetas);
+	for (size_t i = 0; i < nrMetas; ++i)
+	{
+		uint64_t offset = getNumber (data + metaIndex + 8 * i, 8);
+		if (offset % DUMP_ALIGN || !fits (size, offset, DUMP_META_RECORD_SIZE))
+		{
+			ELEKTRA_SET_ERROR (146, errorKey, "metadata record outside of the file");
+			return -1;
+		}
+		uint64_t namesize = getNumber (data + offset, 8);
+		uint64_t valuesize = getNumber (data + offset + 8, 8);
+		offset += DUMP_META_RECORD_SIZE;
+		if (!fits (size, offset, namesize) || !fits (size, offset + namesize, valuesize) || !namesize || !valuesize ||
+		    data[offset + namesize - 1] || data[offset + namesize + valuesize - 1])
+		{
+			ELEKTRA_SET_ERROR (146, errorKey, "invalid metadata record");
+			return -1;
+		}
+		metas[i].name = data + offset;
+		metas[i].value = data + offset + namesize;
+		metas[i].owner = nullptr;
+	}
+
+	// all keys of a dump share their lifetime, so allocate them together
+	ckdb::ElektraArena * arena = ckdb::elektraArenaNew (size);
+	ckdb::ElektraKsBuilder * builder = ckdb::elektraKsBuilderNew (nrKeys);
+	const char * error = builder ? nullptr : "out of memory";
+	for (size_t i = 0; !error && i < nrKeys; ++i)
+	{
+		uint64_t offset = getNumber (data + keyIndex + 8 * i, 8);
+		if (offset % DUMP_ALIGN || !fits (size, offset, DUMP_KEY_RECORD_SIZE))
+		{
+			error = "key record outside of the file";
+			break;
+		}
+		uint64_t namesize = getNumber (data + offset, 8);
+		uint64_t valuesize = getNumber (data + offset + 8, 8);
+		uint32_t flags = getNumber (data + offset + 16, 4);
+		uint32_t metaCount = getNumber (data + offset + 20, 4);
+		offset += DUMP_KEY_RECORD_SIZE;
+		if (!fits (size, offset, namesize) || !fits (size, offset + namesize, valuesize) ||
+		    !fits (size, offset + namesize + valuesize, 4 * static_cast<uint64_t> (metaCount)) || !namesize ||
+		    data[offset + namesize - 1] ||
+		    (!(flags & DUMP_BINARY) && (!valuesize || data[offset + namesize + valuesize - 1])))
+		{
+			error = "invalid key record";
+			break;
+		}
+
+		const char * name = data + offset;
+		const char * value = name + namesize;
+		ckdb::Key * key;
+		if (!(flags & DUMP_VALUE))
+		{
+			key = ckdb::elektraArenaKeyNew (arena, name, (flags & DUMP_BINARY) ? KEY_BINARY : KEY_END, KEY_END);
+		}
+		else if (flags & DUMP_BINARY)
+		{
+			key = ckdb::elektraArenaKeyNew (arena, name, KEY_BINARY, KEY_SIZE, valuesize, KEY_VALUE, value, KEY_END);
+		}
+		else
+		{
+			key = ckdb::elektraArenaKeyNew (arena, name, KEY_VALUE, value, KEY_END);
+		}
+
+		if (!key || ckdb::elektraKsBuilderAdd (builder, key) == -1)
+		{
+			error = "could not create key";
+			break;
+		}
+
+		const char * positions = value + valuesize;
+		for (uint32_t m = 0; m < metaCount; ++m)
+		{
+			uint32_t position = getNumber (positions + 4 * m, 4);
+			if (position >= nrMetas)
+			{
+				error = "unknown metadata";
+				break;
+			}
+			DumpMeta & meta = metas[position];
+			if (meta.owner)
+			{
+				ckdb::keyCopyMeta (key, meta.owner, meta.name);
+			}
+			else
+			{
+				ckdb::keySetMeta (key, meta.name, meta.value);
+				meta.owner = key;
+			}
+		}
+	}
+
+	if (!error)
+	{
+		ksClear (ks);
+		if (ckdb::elektraKsBuilderFinish (builder, ks) == -1) error = "out of memory";
+	}
+	ckdb::elektraKsBuilderDel (builder);
+	ckdb::elektraArenaDel (arena);
+
+	if (error)
+	{
+		ELEKTRA_SET_ERROR (146, errorKey, error);
+		return -1;
+	}
+	return 1;
+}
+
+/**
+ * @brief Write the keys in version 1 of the dump format
+ *
+ * Only needed for readers which do not know version 2.
+ */
+int serialiseV1 (std::ostream & os, ckdb::Key *, ckdb::KeySet * ks)
 {
 	ckdb::Key * cur;
 
@@ -85,19 +411,27 @@ int serialise (std::ostream & os, ckdb::Key *, ckdb::KeySet * ks)
 	return 1;
 }
 
-int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks)
+namespace
+{
+
+/**
+ * @brief Read the commands of version 1, @p line is the first one
+ */
+int unserialiseV1 (std::istream & is, std::string line, ckdb::Key * errorKey, ckdb::KeySet * ks)
 {
 	ckdb::Key * cur = nullptr;
 
+	// all keys of a dump share their lifetime, so allocate them together
+	ckdb::ElektraArena * arena = ckdb::elektraArenaNew (0);
+
 	std::vector<char> namebuffer (4048);
 	std::vector<char> valuebuffer (4048);
-	std::string line;
 	std::string command;
 	size_t nrKeys;
 	size_t namesize;
 	size_t valuesize;
 
-	while (std::getline (is, line))
+	do
 	{
 		std::stringstream ss (line);
 		ss >> command;
@@ -109,6 +443,7 @@ int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks)
 			if (version != "1")
 			{
 				ELEKTRA_SET_ERROR (50, errorKey, version.c_str ());
+				ckdb::elektraArenaDel (arena);
 				return -1;
 			}
 		}
@@ -120,15 +455,13 @@ int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks)
 		}
 		else if (command == "keyNew")
 		{
-			cur = ckdb::keyNew (nullptr);
-
 			ss >> namesize;
 			ss >> valuesize;
 
 			if (namesize > namebuffer.size ()) namebuffer.resize (namesize + 1);
 			is.read (&namebuffer[0], namesize);
 			namebuffer[namesize] = 0;
-			ckdb::keySetName (cur, &namebuffer[0]);
+			cur = ckdb::elektraArenaKeyNew (arena, &namebuffer[0], KEY_END);
 
 			if (valuesize > valuebuffer.size ()) valuebuffer.resize (valuesize + 1);
 			is.read (&valuebuffer[0], valuesize);
@@ -182,15 +515,85 @@ int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks)
 		else
 		{
 			ELEKTRA_SET_ERROR (49, errorKey, command.c_str ());
+			ckdb::elektraArenaDel (arena);
 			return -1;
 		}
-	}
+	} while (std::getline (is, line));
+	ckdb::elektraArenaDel (arena);
 	return 1;
 }
 
+} // namespace
+
+/**
+ * @brief Read a dump of any version from a stream
+ *
+ * Version 2 is read completely into memory first.
+ */
+int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks)
+{
+	std::string line;
+	if (!std::getline (is, line)) return 1;
+
+	if (line + '\n' == DUMP_MAGIC_V2)
+	{
+		std::string data = line + '\n';
+		data.append (std::istreambuf_iterator<char> (is), std::istreambuf_iterator<char> ());
+		return unserialiseV2 (data.data (), data.size (), errorKey, ks);
+	}
+
+	return unserialiseV1 (is, line, errorKey, ks);
+}
+
 } // namespace dump
 
 
+namespace
+{
+
+/**
+ * @brief Read a dump of version 2 by mapping the file
+ *
+ * @retval 0 if the file cannot be mapped or is not of version 2,
+ *         it needs to be read as stream then
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+int dumpGetMapped (ckdb::Key * parentKey, ckdb::KeySet * returned)
+{
+#ifdef HAVE_MMAP
+	int fd = open (keyString (parentKey), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) return 0;
+
+	struct stat buf;
+	if (fstat (fd, &buf) == -1 || !S_ISREG (buf.st_mode) || static_cast<size_t> (buf.st_size) < dump::DUMP_HEADER_SIZE)
+	{
+		close (fd);
+		return 0;
+	}
+
+	size_t size = buf.st_size;
+	void * map = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED) return 0;
+
+	const char * data = static_cast<const char *> (map);
+	int ret = 0;
+	if (!memcmp (data, dump::DUMP_MAGIC_V2, sizeof (dump::DUMP_MAGIC_V2) - 1))
+	{
+		ret = dump::unserialiseV2 (data, size, parentKey, returned);
+	}
+	munmap (map, size);
+	return ret;
+#else
+	(void)parentKey;
+	(void)returned;
+	return 0;
+#endif
+}
+
+} // namespace
+
 extern "C" {
 
 int elektraDumpGet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key * parentKey)
@@ -213,6 +616,13 @@ int elektraDumpGet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key * parentK
 	}
 	keyDel (root);
 	int errnosave = errno;
+	int ret = dumpGetMapped (parentKey, returned);
+	if (ret)
+	{
+		errno = errnosave;
+		return ret;
+	}
+
 	std::ifstream ofs (keyString (parentKey), std::ios::binary);
 	if (!ofs.is_open ())
 	{
@@ -224,7 +634,7 @@ int elektraDumpGet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key * parentK
 	return dump::unserialise (ofs, parentKey, returned);
 }
 
-int elektraDumpSet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key * parentKey)
+int elektraDumpSet (ckdb::Plugin * handle, ckdb::KeySet * returned, ckdb::Key * parentKey)
 {
 	int errnosave = errno;
 	std::ofstream ofs (keyString (parentKey), std::ios::binary);
@@ -235,6 +645,8 @@ int elektraDumpSet (ckdb::Plugin *, ckdb::KeySet * returned, ckdb::Key * parentK
 		return -1;
 	}
 
+	Key * version = ksLookupByName (elektraPluginGetConfig (handle), "/version", 0);
+	if (version && !strcmp (keyString (version), "1")) return dump::serialiseV1 (ofs, parentKey, returned);
 	return dump::serialise (ofs, parentKey, returned);
 }
 
@@ -23,7 +23,9 @@
 namespace dump
 {
 int serialise (std::ostream & os, ckdb::Key *, ckdb::KeySet * ks);
+int serialiseV1 (std::ostream & os, ckdb::Key *, ckdb::KeySet * ks);
 int unserialise (std::istream & is, ckdb::Key * errorKey, ckdb::KeySet * ks);
+int unserialiseV2 (const char * data, size_t size, ckdb::Key * errorKey, ckdb::KeySet * ks);
 }
 
 extern "C" {
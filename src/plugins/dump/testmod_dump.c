@@ -18,7 +18,10 @@
 #include <string.h>
 #endif
 
-#include <tests.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tests_plugin.h>
 
 KeySet * get_dump ()
 {
@@ -45,6 +48,105 @@ KeySet * get_dump ()
 	return ks;
 }
 
+static int fileStartsWith (const char * fileName, const char * start)
+{
+	char buffer[16] = "";
+	FILE * f = fopen (fileName, "rb");
+	if (!f) return 0;
+	size_t got = fread (buffer, 1, strlen (start), f);
+	fclose (f);
+	return got == strlen (start) && !memcmp (buffer, start, got);
+}
+
+static void test_roundtrip (const char * version, const char * magic)
+{
+	printf ("Test write and read dump of version %s\n", version);
+
+	Key * parentKey = keyNew ("user/tests/dump", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (1, keyNew ("system/version", KEY_VALUE, version, KEY_END), KS_END);
+	PLUGIN_OPEN ("dump");
+
+	KeySet * ks = get_dump ();
+	ksAppendKey (ks, keyNew ("user/tests/dump/binary", KEY_BINARY, KEY_SIZE, 4, KEY_VALUE, "\0\1\0\2", KEY_END));
+	ksAppendKey (ks, keyNew ("user/tests/dump/nobinary", KEY_BINARY, KEY_END));
+	ksAppendKey (ks, keyNew ("user/tests/dump/empty", KEY_VALUE, "", KEY_END));
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+	succeed_if (fileStartsWith (keyString (parentKey), magic), "dump has wrong version");
+
+	KeySet * read = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, read, parentKey) == 1, "call to kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	compare_keyset (read, ks);
+
+	Key * k1 = ksLookupByName (read, "user/tests/dump", 0);
+	Key * k2 = ksLookupByName (read, "user/tests/dump/a", 0);
+	exit_if_fail (k1 && k2, "did not find key");
+	succeed_if_same_string (keyString (keyGetMeta (k1, "ab")), "cd");
+	succeed_if (keyGetMeta (k1, "ab") == keyGetMeta (k2, "ab"), "metadata does not point to the same storage");
+
+	Key * binary = ksLookupByName (read, "user/tests/dump/binary", 0);
+	succeed_if (binary && keyIsBinary (binary) && keyGetValueSize (binary) == 4, "binary key not restored");
+	succeed_if (binary && !memcmp (keyValue (binary), "\0\1\0\2", 4), "binary value not restored");
+	Key * nobinary = ksLookupByName (read, "user/tests/dump/nobinary", 0);
+	succeed_if (nobinary && keyIsBinary (nobinary) && keyValue (nobinary) == 0, "binary key without value not restored");
+
+	ksDel (read);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_readVersion1 (void)
+{
+	printf ("Test read dump of version 1 with version 2 as default\n");
+
+	Key * parentKey = keyNew ("user/tests/dump", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (1, keyNew ("system/version", KEY_VALUE, "1", KEY_END), KS_END);
+	KeySet * ks = get_dump ();
+	{
+		PLUGIN_OPEN ("dump");
+		succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+		PLUGIN_CLOSE ();
+	}
+
+	conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("dump");
+	KeySet * read = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, read, parentKey) == 1, "call to kdbGet was not successful");
+	compare_keyset (read, ks);
+
+	ksDel (read);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_corrupt (void)
+{
+	printf ("Test read corrupt dump of version 2\n");
+
+	Key * parentKey = keyNew ("user/tests/dump", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("dump");
+
+	KeySet * ks = get_dump ();
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+
+	struct stat buf;
+	succeed_if (stat (keyString (parentKey), &buf) == 0, "could not stat dump");
+	succeed_if (truncate (keyString (parentKey), buf.st_size - 8) == 0, "could not truncate dump");
+
+	KeySet * read = ksNew (1, keyNew ("user/tests/dump/unchanged", KEY_END), KS_END);
+	succeed_if (plugin->kdbGet (plugin, read, parentKey) == -1, "corrupt dump was read");
+	succeed_if (keyGetMeta (parentKey, "error"), "no error for corrupt dump");
+	succeed_if (ksGetSize (read) == 1, "keys changed although dump is corrupt");
+
+	ksDel (read);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
 #if 0
 
 void test_writedump(const char *file)
@@ -112,6 +214,11 @@ int main (int argc, char ** argv)
 
 	init (argc, argv);
 
+	test_roundtrip ("2", "kdbOpen 2\n");
+	test_roundtrip ("1", "kdbOpen 1\n");
+	test_readVersion1 ();
+	test_corrupt ();
+
 	/*
 	test_writedump("dump_mount_test.edf");
 	test_readdump("dump_mount_test.edf");
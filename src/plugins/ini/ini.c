@@ -14,6 +14,7 @@
 #include "ini.h"
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inih.h>
 #include <kdbease.h>
 #include <kdberrors.h>
@@ -23,6 +24,8 @@
 #include <kdbproposal.h> //elektraKsToMemArray
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 char * keyNameGetOneLevel (const char *, size_t *);
@@ -36,6 +39,29 @@ static char * findParent (Key *, Key *, KeySet *);
 
 typedef enum { NONE, BINARY, ALWAYS } SectionHandling;
 
+typedef struct
+{
+	long start;   /* offset of the section in the file, the comments above it included */
+	long end;     /* offset after the last key of the section */
+	size_t size;  /* number of keys in the section, the section key included */
+	char * first; /* order of the section key */
+	char * last;  /* order of the last key of the section */
+} IniSection;
+
+typedef struct
+{
+	char * parentName; /* name of the parent key the file belongs to */
+	char * file;	   /* the configuration file */
+	dev_t dev;	   /* identity of the file when it was read or written */
+	ino_t ino;
+	off_t fileSize;
+	time_t mtimeSec;
+	long mtimeNsec;
+	IniSection * sections; /* in the order of the file */
+	size_t size;
+	size_t alloc;
+} IniLayout;
+
 typedef struct
 {
 	short supportMultiline; /* defines whether multiline keys are supported */
@@ -47,6 +73,7 @@ typedef struct
 	short toMeta;
 	char * continuationString;
 	KeySet * oldKS;
+	IniLayout * layout; /* sections of the file last read or written */
 } IniPluginConfig;
 
 typedef struct
@@ -58,8 +85,24 @@ typedef struct
 	short mergeSections;
 	short toMeta;
 	IniPluginConfig * pluginConfig;
+	ElektraArena * arena; /* allocates the keys of the result KeySet */
+	IniLayout * layout;   /* sections read so far, NULL if they cannot be copied on write */
+	FILE * fh;
+	long lineEnd; /* offset after the last key or section read */
 } CallbackHandle;
 
+typedef struct
+{
+	IniLayout * old;    /* sections of the file before, NULL if they cannot be copied */
+	int fd;		    /* the file before */
+	KeySet * changed;   /* names of the keys changed since the file was read or written */
+	IniLayout * layout; /* sections written, NULL if they are not recorded */
+	ssize_t start;	    /* index of the section key being written, -1 if none */
+	ssize_t end;	    /* index after the last key of that section */
+	long offset;	    /* where that section starts in the output */
+	short truncate;	    /* if a failed copy was overwritten */
+} IniSplice;
+
 
 static void flushCollectedComment (CallbackHandle * handle, Key * key)
 {
@@ -71,6 +114,124 @@ static void flushCollectedComment (CallbackHandle * handle, Key * key)
 	}
 }
 
+static int iniLayoutSupported (IniPluginConfig * config)
+{
+	// merged sections and arrays do not keep the keys of a section together
+	return !config->toMeta && !config->array && !config->mergeSections && config->sectionHandling != NONE;
+}
+
+static void iniLayoutDel (IniLayout * layout)
+{
+	if (!layout) return;
+	for (size_t i = 0; i < layout->size; ++i)
+	{
+		elektraFree (layout->sections[i].first);
+		elektraFree (layout->sections[i].last);
+	}
+	elektraFree (layout->sections);
+	elektraFree (layout->parentName);
+	elektraFree (layout->file);
+	elektraFree (layout);
+}
+
+static IniLayout * iniLayoutNew (const char * parentName, const char * file)
+{
+	IniLayout * layout = elektraCalloc (sizeof (IniLayout));
+	if (!layout) return NULL;
+	layout->parentName = elektraStrDup (parentName);
+	layout->file = elektraStrDup (file);
+	if (!layout->parentName || !layout->file)
+	{
+		iniLayoutDel (layout);
+		return NULL;
+	}
+	return layout;
+}
+
+static void iniLayoutSetStat (IniLayout * layout, struct stat * buf)
+{
+	layout->dev = buf->st_dev;
+	layout->ino = buf->st_ino;
+	layout->fileSize = buf->st_size;
+#if defined(__APPLE__)
+	layout->mtimeSec = buf->st_mtimespec.tv_sec;
+	layout->mtimeNsec = buf->st_mtimespec.tv_nsec;
+#else
+	layout->mtimeSec = buf->st_mtim.tv_sec;
+	layout->mtimeNsec = buf->st_mtim.tv_nsec;
+#endif
+}
+
+static int iniLayoutMatches (IniLayout * layout, struct stat * buf)
+{
+	IniLayout current;
+	iniLayoutSetStat (&current, buf);
+	return current.dev == layout->dev && current.ino == layout->ino && current.fileSize == layout->fileSize &&
+	       current.mtimeSec == layout->mtimeSec && current.mtimeNsec == layout->mtimeNsec;
+}
+
+/**
+ * @brief Start a new section
+ *
+ * @retval NULL on memory error
+ */
+static IniSection * iniLayoutAdd (IniLayout * layout, long start, const char * first)
+{
+	if (layout->size == layout->alloc)
+	{
+		size_t alloc = layout->alloc ? layout->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&layout->sections, alloc * sizeof (IniSection)) == -1) return NULL;
+		layout->alloc = alloc;
+	}
+	IniSection * section = &layout->sections[layout->size];
+	section->start = start;
+	section->end = start;
+	section->size = 1;
+	section->first = elektraStrDup (first);
+	section->last = NULL;
+	if (!section->first) return NULL;
+	++layout->size;
+	return section;
+}
+
+/**
+ * @brief End the last section
+ *
+ * @retval -1 on memory error
+ */
+static int iniLayoutClose (IniLayout * layout, long end, const char * last)
+{
+	if (layout->size == 0) return 0;
+	IniSection * section = &layout->sections[layout->size - 1];
+	section->end = end;
+	elektraFree (section->last);
+	section->last = elektraStrDup (last);
+	return section->last ? 0 : -1;
+}
+
+static IniSection * iniLayoutFind (IniLayout * layout, const char * first)
+{
+	size_t low = 0;
+	size_t high = layout->size;
+	while (low < high)
+	{
+		size_t mid = low + (high - low) / 2;
+		int cmp = strcmp (layout->sections[mid].first, first);
+		if (!cmp) return &layout->sections[mid];
+		if (cmp < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return NULL;
+}
+
+static void iniDropLayout (CallbackHandle * handle)
+{
+	iniLayoutDel (handle->layout);
+	handle->layout = NULL;
+}
+
 // TODO defined privately in internal.c, API break possible.
 // Might consider moving this to the public API as it might be used by more plugins
 size_t elektraUnescapeKeyName (const char * source, char * dest);
@@ -189,6 +350,7 @@ static void iniBomHandler (void * vhandle, short BOM)
 	if (BOM)
 	{
 		pluginConfig->BOM = 1;
+		handle->lineEnd = 3;
 	}
 	else
 	{
@@ -229,7 +391,7 @@ static int iniKeyToElektraArray (CallbackHandle * handle, Key * existingKey, Key
 		setOrderNumber (handle->parentKey, appendKey);
 		keySetMeta (appendKey, "ini/key", "");
 		keySetMeta (appendKey, "parent", 0);
-		ksAppendKey (handle->result, keyDup (appendKey));
+		ksAppendKey (handle->result, elektraArenaKeyDup (handle->arena, appendKey));
 		keySetMeta (appendKey, "ini/arrayMember", "");
 		keySetMeta (appendKey, "ini/key", 0);
 		keySetMeta (appendKey, "ini/array", 0);
@@ -242,7 +404,7 @@ static int iniKeyToElektraArray (CallbackHandle * handle, Key * existingKey, Key
 			return -1;
 		}
 		keySetString (appendKey, origVal);
-		ksAppendKey (handle->result, keyDup (appendKey));
+		ksAppendKey (handle->result, elektraArenaKeyDup (handle->arena, appendKey));
 		free (origVal);
 		if (elektraArrayIncName (appendKey) == -1)
 		{
@@ -250,7 +412,7 @@ static int iniKeyToElektraArray (CallbackHandle * handle, Key * existingKey, Key
 		}
 		keySetMeta (appendKey, "parent", 0);
 		keySetString (appendKey, value);
-		ksAppendKey (handle->result, keyDup (appendKey));
+		ksAppendKey (handle->result, elektraArenaKeyDup (handle->arena, appendKey));
 		keyDel (appendKey);
 		keyDel (sectionKey);
 	}
@@ -263,7 +425,7 @@ static void insertKeyIntoKeySet (Key * parentKey, Key * key, KeySet * ks)
 	cursor_t savedCursor = ksGetCursor (ks);
 
 	// trying to find the keys section or sections parent section
-	char * parent = findParent (parentKey, key, ksDup (ks));
+	char * parent = findParent (parentKey, key, ks);
 	if (parent)
 	{
 		// parent section found, inserting key
@@ -333,14 +495,16 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 	CallbackHandle * handle = (CallbackHandle *)vhandle;
 	if ((!section || *section == '\0') && (!name || *name == '\0'))
 	{
-		Key * rootKey = keyDup (handle->parentKey);
+		Key * rootKey = elektraArenaKeyDup (handle->arena, handle->parentKey);
 		keySetMeta (rootKey, "ini/rootindex", 0);
 		keySetString (rootKey, value);
 		keySetMeta (rootKey, "ini/key", "");
 		ksAppendKey (handle->result, rootKey);
+		if (handle->layout && handle->layout->size) iniDropLayout (handle);
+		handle->lineEnd = ftell (handle->fh);
 		return 1;
 	}
-	Key * appendKey = keyDup (handle->parentKey);
+	Key * appendKey = elektraArenaKeyDup (handle->arena, handle->parentKey);
 	keySetMeta (appendKey, "ini/rootindex", 0);
 	if (!section || *section == '\0')
 	{
@@ -353,7 +517,7 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 			Key * rootKey = ksLookup (handle->result, handle->parentKey, KDB_O_NONE);
 			if (!rootKey)
 			{
-				rootKey = keyDup (handle->parentKey);
+				rootKey = elektraArenaKeyDup (handle->arena, handle->parentKey);
 			}
 			keySetMeta (rootKey, name, value);
 			ksAppendKey (handle->result, rootKey);
@@ -421,6 +585,7 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 		else
 		{
 			setOrderNumber (handle->parentKey, appendKey);
+			if (handle->layout && handle->layout->size) ++handle->layout->sections[handle->layout->size - 1].size;
 		}
 	}
 	else
@@ -432,6 +597,7 @@ static int iniKeyToElektraKey (void * vhandle, const char * section, const char
 
 		elektraKeyAppendLine (existingKey, value);
 	}
+	handle->lineEnd = ftell (handle->fh);
 
 
 	return 1;
@@ -458,7 +624,7 @@ static short isSectionKey (Key * key)
 static int iniSectionToElektraKey (void * vhandle, const char * section)
 {
 	CallbackHandle * handle = (CallbackHandle *)vhandle;
-	Key * appendKey = keyDup (handle->parentKey);
+	Key * appendKey = elektraArenaKeyDup (handle->arena, handle->parentKey);
 	keySetString (appendKey, 0);
 	keySetMeta (appendKey, "ini/rootindex", 0);
 	createUnescapedKey (appendKey, section);
@@ -467,9 +633,21 @@ static int iniSectionToElektraKey (void * vhandle, const char * section)
 	{
 		if (handle->mergeSections) keySetMeta (existingKey, "ini/duplicate", "");
 		keyDel (appendKey);
+		// the keys of the section are not together in the file
+		iniDropLayout (handle);
 		return 1;
 	}
+	// the previous section ends with its last key, the comments in between belong to this section
+	if (handle->layout && iniLayoutClose (handle->layout, handle->lineEnd, keyString (keyGetMeta (handle->parentKey, "order"))) == -1)
+	{
+		iniDropLayout (handle);
+	}
 	setOrderNumber (handle->parentKey, appendKey);
+	if (handle->layout && !iniLayoutAdd (handle->layout, handle->lineEnd, keyString (keyGetMeta (appendKey, "order"))))
+	{
+		iniDropLayout (handle);
+	}
+	handle->lineEnd = ftell (handle->fh);
 	keySetBinary (appendKey, 0, 0);
 	flushCollectedComment (handle, appendKey);
 	ksAppendKey (handle->result, appendKey);
@@ -563,6 +741,7 @@ int elektraIniOpen (Plugin * handle, Key * parentKey ELEKTRA_UNUSED)
 		}
 	}
 	pluginConfig->oldKS = NULL;
+	pluginConfig->layout = NULL;
 	elektraPluginSetData (handle, pluginConfig);
 
 	return 0;
@@ -573,6 +752,7 @@ int elektraIniClose (Plugin * handle, Key * parentKey ELEKTRA_UNUSED)
 {
 	IniPluginConfig * pluginConfig = (IniPluginConfig *)elektraPluginGetData (handle);
 	if (pluginConfig->oldKS) ksDel (pluginConfig->oldKS);
+	iniLayoutDel (pluginConfig->layout);
 	elektraFree (pluginConfig->continuationString);
 	elektraFree (pluginConfig);
 	elektraPluginSetData (handle, 0);
@@ -601,19 +781,25 @@ static void outputDebug (KeySet * ks)
 }
 #endif
 
+static size_t parentOffset (Key * parentKey, Key * key)
+{
+	if (keyName (parentKey)[0] != '/' || keyName (key)[0] == '/') return 0;
+	const char * ptr = strchr (keyName (key) + 1, '/');
+	if (!ptr) return 0;
+	return (ptr - keyName (key)) + 1;
+}
+
+/**
+ * @brief Find the parent of a single key
+ *
+ * Looks up the sections above the key, so call it only for few keys.
+ *
+ * @see setParents() for all keys
+ */
 static char * findParent (Key * parentKey, Key * searchkey, KeySet * ks)
 {
-	if (keyGetMeta (searchkey, "parent"))
-	{
-		ksDel (ks);
-		return NULL;
-	}
-	size_t offset = 0;
-	if (keyName (parentKey)[0] == '/' && keyName (searchkey)[0] != '/')
-	{
-		const char * ptr = strchr (keyName (searchkey) + 1, '/');
-		if (ptr) offset = (ptr - keyName (searchkey)) + 1;
-	}
+	if (keyGetMeta (searchkey, "parent")) return NULL;
+	size_t offset = parentOffset (parentKey, searchkey);
 	Key * key = keyDup (searchkey);
 	Key * lookedUp;
 	while (strcmp (keyName (key) + offset, keyName (parentKey)))
@@ -637,22 +823,75 @@ static char * findParent (Key * parentKey, Key * searchkey, KeySet * ks)
 	if (!lookedUp) lookedUp = parentKey;
 	char * parentName = strdup (keyName (lookedUp));
 	keyDel (key);
-	ksDel (ks);
 	return parentName;
 }
+
+/**
+ * @retval 0 if name is the name of the parent key
+ * @retval 1 if name is below the parent key
+ * @retval -1 otherwise
+ */
+static int compareToParent (const char * parentName, const char * name)
+{
+	size_t size = strlen (parentName);
+	if (strncmp (name, parentName, size)) return -1;
+	if (name[size] == '\0') return 0;
+	if (parentName[size - 1] == '/' || name[size] == '/') return 1;
+	return -1;
+}
+
+static int isAncestor (Key * ancestor, Key * key)
+{
+	if ((keyName (ancestor)[0] == '/') != (keyName (key)[0] == '/')) return 0;
+	return keyIsBelow (ancestor, key) == 1;
+}
+
+/**
+ * @brief Set the parent meta data of all keys without one
+ *
+ * The parent of a key is its nearest section above, but not above the
+ * parent key, otherwise the key at the position of the parent key.
+ *
+ * The keys are visited in order, so the sections above the current key
+ * are on a stack: every key gets its parent without any lookup.
+ */
 static void setParents (KeySet * ks, Key * parentKey)
 {
+	const char * parentName = keyName (parentKey);
+	Key * parentLevel = ksLookup (ks, parentKey, KDB_O_NOCASCADING);
+	if (!parentLevel) parentLevel = parentKey;
+
+	Key ** sections = elektraMalloc ((ksGetSize (ks) + 1) * sizeof (Key *));
+	if (!sections) return;
+	size_t depth = 0;
+
 	Key * cur;
 	ksRewind (ks);
 	while ((cur = ksNext (ks)) != NULL)
 	{
-		char * parentName = findParent (parentKey, cur, ksDup (ks));
-		if (parentName)
+		while (depth > 0 && !isAncestor (sections[depth - 1], cur))
+			--depth;
+
+		if (!keyGetMeta (cur, "parent"))
 		{
-			keySetMeta (cur, "parent", parentName);
+			int level = compareToParent (parentName, keyName (cur) + parentOffset (parentKey, cur));
+			Key * section = depth > 0 ? sections[depth - 1] : 0;
+			Key * parent = parentLevel;
+			if (level == 0)
+			{
+				parent = cur;
+			}
+			else if (section && (level == -1 || compareToParent (parentName, keyName (section) +
+										       parentOffset (parentKey, section)) >= 0))
+			{
+				parent = section;
+			}
+			keySetMeta (cur, "parent", keyName (parent));
 		}
-		elektraFree (parentName);
+
+		if (isSectionKey (cur)) sections[depth++] = cur;
 	}
+	elektraFree (sections);
 }
 static void stripInternalData (Key * parentKey, KeySet *);
 
@@ -716,6 +955,9 @@ int elektraIniGet (Plugin * handle, KeySet * returned, Key * parentKey)
 	cbHandle.parentKey = parentKey;
 	cbHandle.result = append;
 	cbHandle.collectedComment = 0;
+	cbHandle.arena = elektraArenaNew (0);
+	cbHandle.fh = fh;
+	cbHandle.lineEnd = 0;
 
 	// ksAppendKey (cbHandle.result, keyDup(parentKey));
 
@@ -732,7 +974,21 @@ int elektraIniGet (Plugin * handle, KeySet * returned, Key * parentKey)
 	cbHandle.mergeSections = pluginConfig->mergeSections;
 	cbHandle.pluginConfig = pluginConfig;
 	cbHandle.toMeta = pluginConfig->toMeta;
+	iniLayoutDel (pluginConfig->layout);
+	pluginConfig->layout = NULL;
+	cbHandle.layout = iniLayoutSupported (pluginConfig) ? iniLayoutNew (keyName (parentKey), keyString (parentKey)) : NULL;
 	int ret = ini_parse_file (fh, &iniConfig, &cbHandle);
+	struct stat buf;
+	if (ret == 0 && cbHandle.layout && fstat (fileno (fh), &buf) == 0 &&
+	    iniLayoutClose (cbHandle.layout, cbHandle.lineEnd, keyString (keyGetMeta (parentKey, "order"))) == 0)
+	{
+		iniLayoutSetStat (cbHandle.layout, &buf);
+		pluginConfig->layout = cbHandle.layout;
+	}
+	else
+	{
+		iniLayoutDel (cbHandle.layout);
+	}
 	ksRewind (cbHandle.result);
 	setParents (cbHandle.result, cbHandle.parentKey);
 	stripInternalData (cbHandle.parentKey, cbHandle.result);
@@ -769,6 +1025,7 @@ int elektraIniGet (Plugin * handle, KeySet * returned, Key * parentKey)
 		ret = -1;
 	}
 	ksDel (cbHandle.result);
+	elektraArenaDel (cbHandle.arena);
 	keySetMeta (parentKey, "ini/internal/oldorder", keyString (keyGetMeta (parentKey, "order")));
 	keySetMeta (parentKey, "order", 0);
 	keySetMeta (parentKey, "ini/internal/rootindex", keyString (keyGetMeta (parentKey, "ini/rootindex")));
@@ -1147,7 +1404,196 @@ static void iniWriteMeta (FILE * fh, Key * parentKey, Key * key, IniPluginConfig
 }
 
 
-static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPluginConfig * config)
+static int iniSkipKey (Key * parentKey, Key * cur)
+{
+	if (!strcmp (keyName (parentKey), keyName (cur))) return 1;
+	if (keyName (parentKey)[0] == '/')
+	{
+		if (!strchr (keyName (cur) + 1, '/')) return 1;
+		if (!strcmp (keyName (parentKey), strchr (keyName (cur) + 1, '/'))) return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Prepare to copy the unchanged sections of the file before
+ *
+ * The sections are known from the last kdbGet() or kdbSet(). They can
+ * be copied if the file was not modified since then. kdbGet() and
+ * kdbSet() clear the sync flags, so keys with sync flag changed since.
+ */
+static void iniSpliceOpen (IniSplice * splice, IniPluginConfig * config, KeySet * returned, Key * parentKey)
+{
+	IniLayout * old = config->layout;
+	config->layout = NULL;
+	memset (splice, 0, sizeof (IniSplice));
+	splice->fd = -1;
+	splice->start = -1;
+	if (!old || !iniLayoutSupported (config) || strcmp (old->parentName, keyName (parentKey)))
+	{
+		iniLayoutDel (old);
+		return;
+	}
+
+	// the file written gets renamed to the file before
+	splice->layout = iniLayoutNew (old->parentName, old->file);
+	splice->fd = open (old->file, O_RDONLY);
+	struct stat buf;
+	if (splice->fd == -1 || fstat (splice->fd, &buf) == -1 || !iniLayoutMatches (old, &buf))
+	{
+		iniLayoutDel (old);
+		return;
+	}
+	splice->old = old;
+	splice->changed = ksNew (0, KS_END);
+
+	Key * cur;
+	ksRewind (returned);
+	while ((cur = ksNext (returned)) != NULL)
+	{
+		if (keyNeedSync (cur) == 1) ksAppendKey (splice->changed, keyNew (keyName (cur), KEY_END));
+	}
+}
+
+/**
+ * @brief Keep the sections written for the next kdbSet()
+ */
+static void iniSpliceClose (IniSplice * splice, IniPluginConfig * config, FILE * fh, int ret)
+{
+	if (splice->fd != -1) close (splice->fd);
+	iniLayoutDel (splice->old);
+	ksDel (splice->changed);
+
+	struct stat buf;
+	int ok = ret == 1 && splice->layout && fflush (fh) == 0;
+	if (ok && splice->truncate) ok = ftruncate (fileno (fh), ftell (fh)) == 0;
+	if (ok && fstat (fileno (fh), &buf) == 0)
+	{
+		iniLayoutSetStat (splice->layout, &buf);
+		config->layout = splice->layout;
+	}
+	else
+	{
+		iniLayoutDel (splice->layout);
+	}
+}
+
+/**
+ * @return the index after the last key of the section starting at index i
+ */
+static ssize_t iniSectionEnd (Key * parentKey, Key ** keyArray, ssize_t arraySize, ssize_t i)
+{
+	for (++i; i < arraySize; ++i)
+	{
+		if (!iniSkipKey (parentKey, keyArray[i]) && isSectionKey (keyArray[i])) break;
+	}
+	return i;
+}
+
+/**
+ * @brief Find the keys in the file before
+ *
+ * The keys are sorted by their order, the order of an unchanged key
+ * is the one from the file before. So the keys are the same if none
+ * changed, all are within the orders of the section and none is missing.
+ *
+ * @return the section with the same keys, NULL if there is none
+ */
+static IniSection * iniUnchangedSection (IniSplice * splice, Key * parentKey, Key ** keys, ssize_t size)
+{
+	const Key * first = keyGetMeta (keys[0], "order");
+	IniSection * section = first ? iniLayoutFind (splice->old, keyString (first)) : NULL;
+	if (!section) return NULL;
+
+	size_t count = 0;
+	for (ssize_t i = 0; i < size; ++i)
+	{
+		if (iniSkipKey (parentKey, keys[i])) continue;
+		const Key * order = keyGetMeta (keys[i], "order");
+		if (!order || strcmp (keyString (order), section->last) > 0) return NULL;
+		if (ksLookup (splice->changed, keys[i], KDB_O_NOCASCADING)) return NULL;
+		++count;
+	}
+	return count == section->size ? section : NULL;
+}
+
+static int iniCopySection (FILE * fh, IniSplice * splice, IniSection * section)
+{
+	char buffer[BUFSIZ];
+	char last = '\n';
+	for (long offset = section->start; offset < section->end;)
+	{
+		size_t size = section->end - offset < (long)sizeof (buffer) ? (size_t) (section->end - offset) : sizeof (buffer);
+		ssize_t got = pread (splice->fd, buffer, size, offset);
+		if (got <= 0)
+		{
+			// write the section instead
+			fseek (fh, splice->offset, SEEK_SET);
+			splice->truncate = 1;
+			return -1;
+		}
+		fwrite (buffer, 1, got, fh);
+		last = buffer[got - 1];
+		offset += got;
+	}
+	// the last line of the file might have no newline
+	if (last != '\n') fputc ('\n', fh);
+	return 0;
+}
+
+/**
+ * @brief Record the section written last
+ */
+static void iniSpliceRecord (IniSplice * splice, FILE * fh, Key * parentKey, Key ** keyArray)
+{
+	if (splice->start == -1) return;
+	Key ** keys = keyArray + splice->start;
+	ssize_t size = splice->end - splice->start;
+	splice->start = -1;
+	if (!splice->layout) return;
+
+	const Key * first = keyGetMeta (keys[0], "order");
+	const Key * last = first;
+	IniSection * section = first ? iniLayoutAdd (splice->layout, splice->offset, keyString (first)) : NULL;
+	for (ssize_t i = 1; section && i < size; ++i)
+	{
+		if (iniSkipKey (parentKey, keys[i])) continue;
+		last = keyGetMeta (keys[i], "order");
+		if (last)
+			++section->size;
+		else
+			section = NULL;
+	}
+	if (!section || iniLayoutClose (splice->layout, ftell (fh), keyString (last)) == -1)
+	{
+		iniLayoutDel (splice->layout);
+		splice->layout = NULL;
+	}
+}
+
+/**
+ * @brief Start to write the section at index i
+ *
+ * If no key of the section changed, the section gets copied
+ * from the file before.
+ *
+ * @return the index after the section if it was copied, i otherwise
+ */
+static ssize_t iniSpliceSection (FILE * fh, IniSplice * splice, Key * parentKey, Key ** keyArray, ssize_t arraySize, ssize_t i)
+{
+	iniSpliceRecord (splice, fh, parentKey, keyArray);
+	splice->start = i;
+	splice->end = iniSectionEnd (parentKey, keyArray, arraySize, i);
+	splice->offset = ftell (fh);
+
+	IniSection * section = splice->old ? iniUnchangedSection (splice, parentKey, keyArray + i, splice->end - i) : NULL;
+	if (!section || iniCopySection (fh, splice, section) == -1) return i;
+
+	iniSpliceRecord (splice, fh, parentKey, keyArray);
+	return splice->end;
+}
+
+static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPluginConfig * config, IniSplice * splice)
 {
 	ksRewind (returned);
 	Key ** keyArray;
@@ -1193,16 +1639,7 @@ static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPlu
 	{
 		cur = keyArray[i];
 
-		if (!strcmp (keyName (parentKey), keyName (cur)))
-		{
-			continue;
-		}
-		if (keyName (parentKey)[0] == '/')
-		{
-			if (!strchr (keyName (cur) + 1, '/')) continue;
-			if (!strcmp (keyName (parentKey), strchr (keyName (cur) + 1, '/'))) continue;
-		}
-
+		if (iniSkipKey (parentKey, cur)) continue;
 
 		if (isSectionKey (cur))
 		{
@@ -1213,6 +1650,15 @@ static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPlu
 				removeSectionKey = 0;
 			}
 			sectionKey = cur;
+			if (splice)
+			{
+				ssize_t next = iniSpliceSection (fh, splice, parentKey, keyArray, arraySize, i);
+				if (next != i)
+				{
+					i = next - 1;
+					continue;
+				}
+			}
 		}
 		writeComments (cur, fh);
 		if (config->toMeta)
@@ -1374,6 +1820,7 @@ static int iniWriteKeySet (FILE * fh, Key * parentKey, KeySet * returned, IniPlu
 		}
 	}
 	if (removeSectionKey) keyDel (sectionKey);
+	if (splice) iniSpliceRecord (splice, fh, parentKey, keyArray);
 
 	elektraFree (keyArray);
 	return ret;
@@ -1391,11 +1838,12 @@ static void stripInternalData (Key * parentKey ELEKTRA_UNUSED, KeySet * ks)
 			char * oldName = strdup (keyName (cur));
 			char * newName = elektraCalloc (elektraStrLen (keyName (cur)));
 			char * token = NULL;
-			token = strtok (oldName, "/");
+			char * saveptr = NULL;
+			token = strtok_r (oldName, "/", &saveptr);
 			strcat (newName, token);
 			while (token != NULL)
 			{
-				token = strtok (NULL, "/");
+				token = strtok_r (NULL, "/", &saveptr);
 				if (token == NULL) break;
 				if (!strcmp (token, INTERNAL_ROOT_SECTION)) continue;
 				strcat (newName, "/");
@@ -1498,12 +1946,15 @@ int elektraIniSet (Plugin * handle, KeySet * returned, Key * parentKey)
 		keySetMeta (parentKey, "ini/rootindex", "#1");
 	}
 
+	IniPluginConfig * pluginConfig = elektraPluginGetData (handle);
+	IniSplice splice;
+	iniSpliceOpen (&splice, pluginConfig, returned, parentKey);
+
 	Key * root = keyDup (ksLookup (returned, parentKey, KDB_O_NONE));
 	Key * head = keyDup (ksHead (returned));
-	IniPluginConfig * pluginConfig = elektraPluginGetData (handle);
-	ksRewind (returned);
 	Key * cur;
-	KeySet * newKS = ksNew (0, KS_END);
+	KeySet * newKS = ksNew (ksGetSize (returned), KS_END);
+	KeySet * unordered = ksNew (0, KS_END);
 	ksRewind (returned);
 	while ((cur = ksNext (returned)) != NULL)
 	{
@@ -1522,19 +1973,22 @@ int elektraIniSet (Plugin * handle, KeySet * returned, Key * parentKey)
 				keySetMeta (cur, "ini/key", "");
 			}
 			ksAppendKey (newKS, cur);
-			keyDel (ksLookup (returned, cur, KDB_O_POP));
+		}
+		else
+		{
+			ksAppendKey (unordered, cur);
 		}
 	}
-	ksRewind (returned);
+	ksClear (returned);
 
-	while ((cur = ksNext (returned)) != NULL)
+	ksRewind (unordered);
+	while ((cur = ksNext (unordered)) != NULL)
 	{
 		if (!strcmp (keyName (cur), keyName (parentKey))) continue;
 		if (!strcmp (keyBaseName (cur), INTERNAL_ROOT_SECTION)) continue;
 		insertIntoKS (parentKey, cur, newKS, pluginConfig);
-		keyDel (ksLookup (returned, cur, KDB_O_POP));
 	}
-	ksClear (returned);
+	ksDel (unordered);
 	ksAppend (returned, newKS);
 	ksDel (newKS);
 	setParents (returned, parentKey);
@@ -1559,7 +2013,8 @@ int elektraIniSet (Plugin * handle, KeySet * returned, Key * parentKey)
 		pluginConfig->oldKS = NULL;
 		elektraPluginSetData (handle, pluginConfig);
 	}
-	ret = iniWriteKeySet (fh, parentKey, returned, pluginConfig);
+	ret = iniWriteKeySet (fh, parentKey, returned, pluginConfig, splice.old || splice.layout ? &splice : NULL);
+	iniSpliceClose (&splice, pluginConfig, fh, ret);
 
 	fclose (fh);
 	errno = errnosave;
@@ -21,6 +21,8 @@
 
 #include <tests_plugin.h>
 
+#include <unistd.h>
+
 
 static void test_plainIniRead (char * fileName)
 {
@@ -437,6 +439,67 @@ static void test_insertOrder (char * source, char * compare)
 	ksDel (ks);
 	PLUGIN_CLOSE ();
 }
+static void writeIncrementalFile (const char * file, const char * source)
+{
+	char buffer[1024];
+	FILE * in = fopen (srcdir_file (source), "r");
+	FILE * out = fopen (file, "w");
+	exit_if_fail (in && out, "could not copy ini file");
+	size_t size;
+	while ((size = fread (buffer, 1, sizeof (buffer), in)) > 0)
+	{
+		fwrite (buffer, 1, size, out);
+	}
+	fclose (in);
+	fclose (out);
+}
+
+static void test_incrementalWrite (char * source, char * compare, char * compareAgain)
+{
+	char file[1024];
+	char tmpFile[1024];
+	snprintf (file, sizeof (file), "%s/incremental.ini", tempHome);
+	snprintf (tmpFile, sizeof (tmpFile), "%s/incremental.ini.tmp", tempHome);
+	writeIncrementalFile (file, source);
+
+	Key * parentKey = keyNew ("user/tests/ini-write", KEY_VALUE, file, KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	KeySet * ks = ksNew (30, KS_END);
+	PLUGIN_OPEN ("ini");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) >= 1, "call to kdbGet was not successful");
+
+	// like kdbGet(), the unchanged sections get copied
+	clear_sync (ks);
+	keySetString (ksLookupByName (ks, "user/tests/ini-write/b/key", KDB_O_NONE), "3");
+	keySetString (parentKey, tmpFile);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (compare_line_files (srcdir_file (compare), tmpFile), "files do not match as expected");
+
+	// like the resolver, the sections written last time get copied
+	succeed_if (rename (tmpFile, file) == 0, "could not rename file");
+	clear_sync (ks);
+	keyDel (ksLookupByName (ks, "user/tests/ini-write/a/other", KDB_O_POP));
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	succeed_if (compare_line_files (srcdir_file (compareAgain), tmpFile), "files do not match as expected");
+
+	// the file was modified meanwhile, everything gets written
+	writeIncrementalFile (file, source);
+	clear_sync (ks);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) >= 1, "call to kdbSet was not successful");
+	KeySet * written = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, written, parentKey) >= 1, "call to kdbGet was not successful");
+	Key * key = ksLookupByName (written, "user/tests/ini-write/c/x", KDB_O_NONE);
+	succeed_if (key && !strcmp (keyString (key), "y"), "key of copied section not read");
+	succeed_if (!ksLookupByName (written, "user/tests/ini-write/a/other", KDB_O_NONE), "removed key was written");
+	ksDel (written);
+
+	unlink (file);
+	unlink (tmpFile);
+	keyDel (parentKey);
+	ksDel (ks);
+	PLUGIN_CLOSE ();
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("INI	   TESTS\n");
@@ -460,6 +523,7 @@ int main (int argc, char ** argv)
 	test_array ("ini/array.ini");
 	test_preserveEmptyLines ("ini/emptyLines");
 	test_insertOrder ("ini/insertTest.input.ini", "ini/insertTest.output.ini");
+	test_incrementalWrite ("ini/incremental.input.ini", "ini/incremental.output.ini", "ini/incremental.again.ini");
 	printf ("\ntest_ini RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
 	return nbError;
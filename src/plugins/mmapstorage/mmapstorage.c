@@ -0,0 +1,590 @@
+/**
+ * @file
+ *
+ * @brief Source for mmapstorage plugin
+ *
+ * The file is a table of keys sorted by name. kdbGet() maps the
+ * file and the keys use the names and values within the mapping
+ * instead of copies. The mapping stays until the last key is deleted.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ *
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#include "mmapstorage.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <kdberrors.h>
+#include <kdbprivate.h>
+#include <kdbproposal.h>
+
+#define MMAPSTORAGE_MAGIC "mmapstorage 1\n"
+#define MMAPSTORAGE_HEADER_SIZE 64
+#define MMAPSTORAGE_META_RECORD_SIZE 32
+#define MMAPSTORAGE_KEY_RECORD_SIZE 40
+
+/**
+ * @internal
+ *
+ * A key or meta key within the file.
+ *
+ * All numbers are stored little endian. Offsets are relative to the
+ * data following the tables. The name is the escaped name directly
+ * followed by the unescaped name, as keys store it.
+ *
+ * The layout of the file is:
+ * - header: magic, number of keys, meta keys and meta references,
+ *   size of the data and size of the file
+ * - keys: sorted by name, each a mmapstorageRecord with the meta references
+ * - meta keys: each a mmapstorageRecord, shared by all keys with the same meta data
+ * - meta references: 32 bit index of a meta key, padded to 8 bytes
+ * - data: names and values
+ */
+typedef struct
+{
+	uint64_t nameOffset;
+	uint64_t valueOffset;
+	uint64_t valueSize;     ///< 0 for a key without value
+	uint32_t nameSize;      ///< see keyGetNameSize()
+	uint32_t unescapedSize; ///< see keyGetUnescapedNameSize()
+	uint32_t metaFirst;     ///< the first meta reference, keys only
+	uint32_t metaCount;     ///< number of meta references, keys only
+} mmapstorageRecord;
+
+/**
+ * @internal
+ *
+ * A growing buffer for the tables and data to write.
+ */
+typedef struct
+{
+	char * data;
+	size_t size;
+	size_t alloc;
+} mmapstorageBuffer;
+
+/**
+ * @internal
+ *
+ * Meta keys with the same name and value are written once.
+ */
+typedef struct
+{
+	const Key ** keys; ///< the meta keys, in the order of the file
+	size_t size;
+	size_t * table; ///< open addressing hash table of index + 1, 0 if empty
+	size_t tableSize;
+} mmapstorageMetaSet;
+
+static void mmapstoragePut (char * data, uint64_t number, size_t bytes)
+{
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		data[i] = (char)(number >> (8 * i));
+	}
+}
+
+static uint64_t mmapstorageGet (const char * data, size_t bytes)
+{
+	uint64_t number = 0;
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		number |= (uint64_t) (unsigned char)data[i] << (8 * i);
+	}
+	return number;
+}
+
+static size_t mmapstorageAlign (size_t size)
+{
+	return (size + 7) / 8 * 8;
+}
+
+/**
+ * @retval the offset of the reserved bytes
+ * @retval -1 on memory error
+ */
+static ssize_t mmapstorageReserve (mmapstorageBuffer * buffer, size_t size)
+{
+	if (buffer->size + size > buffer->alloc)
+	{
+		size_t alloc = buffer->alloc ? buffer->alloc * 2 : 4096;
+		while (alloc < buffer->size + size)
+			alloc *= 2;
+		if (elektraRealloc ((void **)&buffer->data, alloc) == -1) return -1;
+		buffer->alloc = alloc;
+	}
+	ssize_t offset = buffer->size;
+	buffer->size += size;
+	return offset;
+}
+
+/**
+ * @retval the offset of the appended bytes
+ * @retval -1 on memory error
+ */
+static ssize_t mmapstorageAppend (mmapstorageBuffer * buffer, const void * data, size_t size)
+{
+	ssize_t offset = mmapstorageReserve (buffer, size);
+	if (offset != -1 && size) memcpy (buffer->data + offset, data, size);
+	return offset;
+}
+
+static void mmapstoragePutRecord (char * data, const mmapstorageRecord * record, int withMeta)
+{
+	mmapstoragePut (data, record->nameOffset, 8);
+	mmapstoragePut (data + 8, record->valueOffset, 8);
+	mmapstoragePut (data + 16, record->valueSize, 8);
+	mmapstoragePut (data + 24, record->nameSize, 4);
+	mmapstoragePut (data + 28, record->unescapedSize, 4);
+	if (!withMeta) return;
+	mmapstoragePut (data + 32, record->metaFirst, 4);
+	mmapstoragePut (data + 36, record->metaCount, 4);
+}
+
+static void mmapstorageGetRecord (const char * data, mmapstorageRecord * record, int withMeta)
+{
+	record->nameOffset = mmapstorageGet (data, 8);
+	record->valueOffset = mmapstorageGet (data + 8, 8);
+	record->valueSize = mmapstorageGet (data + 16, 8);
+	record->nameSize = mmapstorageGet (data + 24, 4);
+	record->unescapedSize = mmapstorageGet (data + 28, 4);
+	record->metaFirst = withMeta ? mmapstorageGet (data + 32, 4) : 0;
+	record->metaCount = withMeta ? mmapstorageGet (data + 36, 4) : 0;
+}
+
+/**
+ * @brief Append name and value of a key to the data
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error or if the key is too big
+ */
+static int mmapstorageWriteKey (mmapstorageBuffer * data, const Key * key, mmapstorageRecord * record)
+{
+	size_t nameSize = keyGetNameSize (key);
+	size_t unescapedSize = keyGetUnescapedNameSize (key);
+	if (nameSize > UINT32_MAX || unescapedSize > UINT32_MAX) return -1;
+
+	ssize_t nameOffset = mmapstorageAppend (data, keyName (key), nameSize);
+	if (nameOffset == -1 || mmapstorageAppend (data, keyUnescapedName (key), unescapedSize) == -1) return -1;
+
+	// keyValue() cannot tell an empty string from no value
+	size_t valueSize = key->data.v ? key->dataSize : 0;
+	ssize_t valueOffset = mmapstorageAppend (data, key->data.v, valueSize);
+	if (valueOffset == -1) return -1;
+
+	record->nameOffset = nameOffset;
+	record->nameSize = nameSize;
+	record->unescapedSize = unescapedSize;
+	record->valueOffset = valueSize ? (uint64_t)valueOffset : 0;
+	record->valueSize = valueSize;
+	return 0;
+}
+
+static size_t mmapstorageMetaHash (const Key * meta)
+{
+	// FNV-1a over name and value
+	size_t hash = 2166136261u;
+	const char * str[2] = { keyName (meta), keyString (meta) };
+	for (int s = 0; s < 2; ++s)
+	{
+		const unsigned char * c = (const unsigned char *)str[s];
+		do
+		{
+			hash ^= *c;
+			hash *= 16777619u;
+		} while (*c++);
+	}
+	return hash;
+}
+
+static int mmapstorageMetaEqual (const Key * a, const Key * b)
+{
+	return a == b || (!strcmp (keyName (a), keyName (b)) && !strcmp (keyString (a), keyString (b)));
+}
+
+/**
+ * @brief Find or add a meta key
+ *
+ * @return the index of the meta key
+ * @retval -1 on memory error
+ */
+static ssize_t mmapstorageMetaAdd (mmapstorageMetaSet * set, const Key * meta)
+{
+	if ((set->size + 1) * 2 > set->tableSize)
+	{
+		size_t tableSize = set->tableSize ? set->tableSize * 2 : 64;
+		size_t * table = elektraCalloc (tableSize * sizeof (size_t));
+		if (!table || elektraRealloc ((void **)&set->keys, tableSize / 2 * sizeof (const Key *)) == -1)
+		{
+			elektraFree (table);
+			return -1;
+		}
+		for (size_t i = 0; i < set->size; ++i)
+		{
+			size_t pos = mmapstorageMetaHash (set->keys[i]) & (tableSize - 1);
+			while (table[pos])
+				pos = (pos + 1) & (tableSize - 1);
+			table[pos] = i + 1;
+		}
+		elektraFree (set->table);
+		set->table = table;
+		set->tableSize = tableSize;
+	}
+
+	size_t pos = mmapstorageMetaHash (meta) & (set->tableSize - 1);
+	while (set->table[pos])
+	{
+		size_t index = set->table[pos] - 1;
+		if (mmapstorageMetaEqual (set->keys[index], meta)) return index;
+		pos = (pos + 1) & (set->tableSize - 1);
+	}
+
+	set->keys[set->size] = meta;
+	set->table[pos] = ++set->size;
+	return set->size - 1;
+}
+
+/**
+ * @brief Serialise the keys into the tables and data of the file
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+static int mmapstorageSerialise (KeySet * returned, mmapstorageBuffer * keys, mmapstorageBuffer * metas, mmapstorageBuffer * refs,
+				 mmapstorageBuffer * data)
+{
+	mmapstorageMetaSet set = { 0, 0, 0, 0 };
+	mmapstorageRecord record;
+	int ret = 0;
+
+	size_t refCount = 0;
+	ksRewind (returned);
+	Key * cur;
+	while (ret == 0 && (cur = ksNext (returned)) != 0)
+	{
+		memset (&record, 0, sizeof (record));
+		record.metaFirst = refCount;
+
+		keyRewindMeta (cur);
+		const Key * meta;
+		while (ret == 0 && (meta = keyNextMeta (cur)) != 0)
+		{
+			ssize_t index = mmapstorageMetaAdd (&set, meta);
+			ssize_t offset = index == -1 || index > UINT32_MAX ? -1 : mmapstorageReserve (refs, 4);
+			if (offset == -1)
+			{
+				ret = -1;
+				break;
+			}
+			mmapstoragePut (refs->data + offset, index, 4);
+			++record.metaCount;
+			++refCount;
+		}
+
+		ssize_t offset = mmapstorageReserve (keys, MMAPSTORAGE_KEY_RECORD_SIZE);
+		if (ret == -1 || refCount > UINT32_MAX || offset == -1 || mmapstorageWriteKey (data, cur, &record) == -1)
+		{
+			ret = -1;
+			break;
+		}
+		mmapstoragePutRecord (keys->data + offset, &record, 1);
+	}
+
+	for (size_t i = 0; ret == 0 && i < set.size; ++i)
+	{
+		memset (&record, 0, sizeof (record));
+		ssize_t offset = mmapstorageReserve (metas, MMAPSTORAGE_META_RECORD_SIZE);
+		if (offset == -1 || mmapstorageWriteKey (data, set.keys[i], &record) == -1)
+		{
+			ret = -1;
+			break;
+		}
+		mmapstoragePutRecord (metas->data + offset, &record, 0);
+	}
+
+	if (ret == 0 && mmapstorageReserve (refs, mmapstorageAlign (refs->size) - refs->size) != -1)
+	{
+		memset (refs->data + refCount * 4, 0, refs->size - refCount * 4);
+	}
+
+	elektraFree (set.keys);
+	elektraFree (set.table);
+	return ret;
+}
+
+int elektraMmapstorageSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * parentKey)
+{
+	mmapstorageBuffer keys = { 0, 0, 0 };
+	mmapstorageBuffer metas = { 0, 0, 0 };
+	mmapstorageBuffer refs = { 0, 0, 0 };
+	mmapstorageBuffer data = { 0, 0, 0 };
+
+	if (mmapstorageSerialise (returned, &keys, &metas, &refs, &data) == -1)
+	{
+		elektraFree (keys.data);
+		elektraFree (metas.data);
+		elektraFree (refs.data);
+		elektraFree (data.data);
+		ELEKTRA_SET_ERROR (87, parentKey, "could not serialise keys");
+		return -1;
+	}
+
+	char header[MMAPSTORAGE_HEADER_SIZE];
+	memset (header, 0, sizeof (header));
+	memcpy (header, MMAPSTORAGE_MAGIC, sizeof (MMAPSTORAGE_MAGIC) - 1);
+	mmapstoragePut (header + 16, keys.size / MMAPSTORAGE_KEY_RECORD_SIZE, 8);
+	mmapstoragePut (header + 24, metas.size / MMAPSTORAGE_META_RECORD_SIZE, 8);
+	mmapstoragePut (header + 32, refs.size / 4, 8);
+	mmapstoragePut (header + 40, data.size, 8);
+	mmapstoragePut (header + 48, sizeof (header) + keys.size + metas.size + refs.size + data.size, 8);
+
+	int errnosave = errno;
+	int ret = 1;
+	FILE * f = fopen (keyString (parentKey), "wb");
+	if (!f)
+	{
+		ELEKTRA_SET_ERROR_SET (parentKey);
+		ret = -1;
+	}
+	else
+	{
+		int failed = fwrite (header, sizeof (header), 1, f) != 1;
+		const mmapstorageBuffer * parts[4] = { &keys, &metas, &refs, &data };
+		for (int i = 0; i < 4; ++i)
+		{
+			if (parts[i]->size && fwrite (parts[i]->data, parts[i]->size, 1, f) != 1) failed = 1;
+		}
+		if (fclose (f) != 0) failed = 1;
+		if (failed)
+		{
+			ELEKTRA_SET_ERROR (75, parentKey, strerror (errno));
+			ret = -1;
+		}
+	}
+	errno = errnosave;
+
+	elektraFree (keys.data);
+	elektraFree (metas.data);
+	elektraFree (refs.data);
+	elektraFree (data.data);
+	return ret;
+}
+
+static void mmapstorageUnmap (void * memory, size_t size)
+{
+	munmap (memory, size);
+}
+
+/**
+ * @brief Create a key viewing its name and value in the mapped file
+ *
+ * @retval 0 if the record points outside of the data
+ */
+static Key * mmapstorageView (ElektraArena * arena, const mmapstorageRecord * record, const char * data, uint64_t dataSize)
+{
+	if (record->nameOffset > dataSize || (uint64_t)record->nameSize + record->unescapedSize > dataSize - record->nameOffset)
+	{
+		return 0;
+	}
+	if (record->valueSize && (record->valueOffset > dataSize || record->valueSize > dataSize - record->valueOffset)) return 0;
+
+	return elektraArenaKeyView (arena, data + record->nameOffset, record->nameSize, record->unescapedSize, data + record->valueOffset,
+				    record->valueSize);
+}
+
+/**
+ * @brief Create the keys of a mapped file
+ *
+ * The arena adopted the mapping already.
+ *
+ * @retval 1 on success
+ * @retval 0 if the file is corrupt
+ * @retval -1 on memory error
+ */
+static int mmapstorageRead (const char * map, size_t size, ElektraArena * arena, ElektraKsBuilder * builder)
+{
+	const uint64_t keyCount = mmapstorageGet (map + 16, 8);
+	const uint64_t metaCount = mmapstorageGet (map + 24, 8);
+	const uint64_t refCount = mmapstorageGet (map + 32, 8);
+	const uint64_t dataSize = mmapstorageGet (map + 40, 8);
+	if (mmapstorageGet (map + 48, 8) != size) return 0;
+
+	// every table fits into the file, so no product can overflow
+	uint64_t left = size - MMAPSTORAGE_HEADER_SIZE;
+	if (keyCount > left / MMAPSTORAGE_KEY_RECORD_SIZE) return 0;
+	left -= keyCount * MMAPSTORAGE_KEY_RECORD_SIZE;
+	if (metaCount > left / MMAPSTORAGE_META_RECORD_SIZE) return 0;
+	left -= metaCount * MMAPSTORAGE_META_RECORD_SIZE;
+	if (refCount > left / 4 || metaCount > UINT32_MAX) return 0;
+	left -= mmapstorageAlign (refCount * 4);
+	if (left != dataSize) return 0;
+
+	const char * keyTable = map + MMAPSTORAGE_HEADER_SIZE;
+	const char * metaTable = keyTable + keyCount * MMAPSTORAGE_KEY_RECORD_SIZE;
+	const char * refTable = metaTable + metaCount * MMAPSTORAGE_META_RECORD_SIZE;
+	const char * data = map + size - dataSize;
+
+	Key ** metas = elektraCalloc ((metaCount ? metaCount : 1) * sizeof (Key *));
+	if (!metas) return -1;
+
+	mmapstorageRecord record;
+	int ret = 1;
+	for (uint64_t i = 0; ret == 1 && i < metaCount; ++i)
+	{
+		mmapstorageGetRecord (metaTable + i * MMAPSTORAGE_META_RECORD_SIZE, &record, 0);
+		metas[i] = mmapstorageView (arena, &record, data, dataSize);
+		if (!metas[i] || !record.valueSize || data[record.valueOffset + record.valueSize - 1] != '\0')
+		{
+			ret = 0;
+			break;
+		}
+		keyIncRef (metas[i]);
+		elektraKeyLock (metas[i], KEY_LOCK_NAME | KEY_LOCK_VALUE | KEY_LOCK_META);
+	}
+
+	for (uint64_t i = 0; ret == 1 && i < keyCount; ++i)
+	{
+		mmapstorageGetRecord (keyTable + i * MMAPSTORAGE_KEY_RECORD_SIZE, &record, 1);
+		Key * key = mmapstorageView (arena, &record, data, dataSize);
+		if (!key || record.metaFirst > refCount || record.metaCount > refCount - record.metaFirst)
+		{
+			keyDel (key);
+			ret = 0;
+			break;
+		}
+
+		if (record.metaCount) key->meta = ksNew (record.metaCount, KS_END);
+		for (uint32_t m = 0; m < record.metaCount && ret == 1; ++m)
+		{
+			uint64_t index = mmapstorageGet (refTable + (record.metaFirst + m) * 4, 4);
+			if (index >= metaCount) ret = 0;
+			else if (!key->meta || ksAppendKey (key->meta, metas[index]) == -1) ret = -1;
+		}
+		elektraKeyUpdateOwner (key);
+
+		// strings need their terminating null
+		if (ret == 1 && record.valueSize && !keyIsBinary (key) && data[record.valueOffset + record.valueSize - 1] != '\0') ret = 0;
+		if (ret != 1)
+		{
+			keyDel (key);
+			break;
+		}
+		if (elektraKsBuilderAdd (builder, key) == -1) ret = -1;
+	}
+
+	for (uint64_t i = 0; i < metaCount && metas[i]; ++i)
+	{
+		keyDecRef (metas[i]);
+		keyDel (metas[i]);
+	}
+	elektraFree (metas);
+	return ret;
+}
+
+static inline KeySet * elektraMmapstorageModuleConfig (void)
+{
+	return ksNew (30, keyNew ("system/elektra/modules/mmapstorage", KEY_VALUE, "mmapstorage plugin waits for your orders", KEY_END),
+		      keyNew ("system/elektra/modules/mmapstorage/exports", KEY_END),
+		      keyNew ("system/elektra/modules/mmapstorage/exports/get", KEY_FUNC, elektraMmapstorageGet, KEY_END),
+		      keyNew ("system/elektra/modules/mmapstorage/exports/set", KEY_FUNC, elektraMmapstorageSet, KEY_END),
+#include ELEKTRA_README (mmapstorage)
+		      keyNew ("system/elektra/modules/mmapstorage/infos/version", KEY_VALUE, PLUGINVERSION, KEY_END), KS_END);
+}
+
+int elektraMmapstorageGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * parentKey)
+{
+	if (!strcmp (keyName (parentKey), "system/elektra/modules/mmapstorage"))
+	{
+		KeySet * moduleConfig = elektraMmapstorageModuleConfig ();
+		ksAppend (returned, moduleConfig);
+		ksDel (moduleConfig);
+		return 1;
+	}
+
+	int errnosave = errno;
+	int fd = open (keyString (parentKey), O_RDONLY | O_CLOEXEC);
+	struct stat buf;
+	if (fd == -1 || fstat (fd, &buf) == -1)
+	{
+		ELEKTRA_SET_ERROR_GET (parentKey);
+		if (fd != -1) close (fd);
+		errno = errnosave;
+		return -1;
+	}
+
+	size_t size = buf.st_size;
+	if (size < MMAPSTORAGE_HEADER_SIZE)
+	{
+		close (fd);
+		if (size == 0) return 0; // a new file without keys
+		ELEKTRA_SET_ERROR (147, parentKey, "file is too short");
+		return -1;
+	}
+
+	// private and writable: modifications do not reach the file
+	char * map = mmap (0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED)
+	{
+		ELEKTRA_SET_ERROR_GET (parentKey);
+		errno = errnosave;
+		return -1;
+	}
+
+	if (memcmp (map, MMAPSTORAGE_MAGIC, sizeof (MMAPSTORAGE_MAGIC) - 1))
+	{
+		munmap (map, size);
+		ELEKTRA_SET_ERROR (147, parentKey, "wrong magic, not a mmapstorage file");
+		return -1;
+	}
+
+	// the keys keep the mapping alive, it is unmapped with the last of them
+	ElektraArena * arena = elektraArenaNew (0);
+	if (!arena || elektraArenaAdopt (arena, map, size, mmapstorageUnmap) == -1)
+	{
+		munmap (map, size);
+		elektraArenaDel (arena);
+		ELEKTRA_SET_ERROR (87, parentKey, "could not create arena");
+		return -1;
+	}
+
+	uint64_t keyCount = mmapstorageGet (map + 16, 8);
+	ElektraKsBuilder * builder = elektraKsBuilderNew (keyCount <= size / MMAPSTORAGE_KEY_RECORD_SIZE ? keyCount : 0);
+	int ret = builder ? mmapstorageRead (map, size, arena, builder) : -1;
+	if (ret == 1 && elektraKsBuilderFinish (builder, returned) == -1) ret = -1;
+	elektraKsBuilderDel (builder);
+	elektraArenaDel (arena);
+
+	if (ret == 0)
+	{
+		ELEKTRA_SET_ERROR (147, parentKey, keyString (parentKey));
+		return -1;
+	}
+	if (ret == -1)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "could not create keys");
+		return -1;
+	}
+	return 1;
+}
+
+Plugin * ELEKTRA_PLUGIN_EXPORT (mmapstorage)
+{
+	// clang-format off
+	return elektraPluginExport ("mmapstorage",
+		ELEKTRA_PLUGIN_GET,	&elektraMmapstorageGet,
+		ELEKTRA_PLUGIN_SET,	&elektraMmapstorageSet,
+		ELEKTRA_PLUGIN_END);
+}
@@ -0,0 +1,259 @@
+/**
+ * @file
+ *
+ * @brief Tests for mmapstorage plugin
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ *
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tests_plugin.h>
+
+static KeySet * getKeys (void)
+{
+	Key *k1, *k2;
+	// clang-format off
+	KeySet * ks = ksNew (10,
+			k1 = keyNew ("user/tests/mmapstorage",
+				KEY_VALUE, "root key",
+				KEY_META, "a", "b",
+				KEY_END),
+			k2 = keyNew ("user/tests/mmapstorage/a",
+				KEY_VALUE, "a value",
+				KEY_META, "ab", "cd",
+				KEY_END),
+			keyNew ("user/tests/mmapstorage/b",
+				KEY_VALUE, "b value",
+				KEY_META, "longer val", "here some even more with ugly €@\\1¹²³¼ chars",
+				KEY_META, "ab", "cd",
+				KEY_END),
+			keyNew ("user/tests/mmapstorage/escaped\\/name/#0", KEY_VALUE, "", KEY_END),
+			keyNew ("user/tests/mmapstorage/binary", KEY_BINARY, KEY_SIZE, 4, KEY_VALUE, "\0\1\0\2", KEY_END),
+			keyNew ("user/tests/mmapstorage/nobinary", KEY_BINARY, KEY_END),
+			keyNew ("user/tests/mmapstorage/novalue", KEY_END),
+			KS_END);
+	// clang-format on
+	keyCopyMeta (k1, k2, "ab");
+
+	return ks;
+}
+
+static void test_roundtrip (void)
+{
+	printf ("Test write and read keys\n");
+
+	Key * parentKey = keyNew ("user/tests/mmapstorage", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("mmapstorage");
+
+	KeySet * ks = getKeys ();
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+
+	KeySet * read = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, read, parentKey) == 1, "call to kdbGet was not successful");
+	succeed_if (output_error (parentKey), "error in kdbGet");
+	compare_keyset (read, ks);
+
+	Key * k1 = ksLookupByName (read, "user/tests/mmapstorage", 0);
+	Key * k2 = ksLookupByName (read, "user/tests/mmapstorage/a", 0);
+	Key * k3 = ksLookupByName (read, "user/tests/mmapstorage/b", 0);
+	exit_if_fail (k1 && k2 && k3, "did not find key");
+	succeed_if_same_string (keyString (keyGetMeta (k1, "ab")), "cd");
+	succeed_if (keyGetMeta (k1, "ab") == keyGetMeta (k2, "ab"), "metadata does not point to the same storage");
+	succeed_if (keyGetMeta (k1, "ab") == keyGetMeta (k3, "ab"), "equal metadata not shared");
+	succeed_if (keySetMeta (k1, "new", "meta") > 0, "could not add metadata");
+
+	Key * binary = ksLookupByName (read, "user/tests/mmapstorage/binary", 0);
+	succeed_if (binary && keyIsBinary (binary) && keyGetValueSize (binary) == 4, "binary key not restored");
+	succeed_if (binary && !memcmp (keyValue (binary), "\0\1\0\2", 4), "binary value not restored");
+	Key * nobinary = ksLookupByName (read, "user/tests/mmapstorage/nobinary", 0);
+	succeed_if (nobinary && keyIsBinary (nobinary) && keyValue (nobinary) == 0, "binary key without value not restored");
+	Key * novalue = ksLookupByName (read, "user/tests/mmapstorage/novalue", 0);
+	succeed_if (novalue && !keyIsBinary (novalue) && novalue->data.v == 0, "key without value not restored");
+
+	// modified keys copy, other keys stay unchanged
+	Key * escaped = ksLookupByName (read, "user/tests/mmapstorage/escaped\\/name/#0", 0);
+	exit_if_fail (escaped, "did not find escaped key");
+	keyIncRef (escaped);
+	keySetString (k2, "changed");
+	succeed_if_same_string (keyString (k2), "changed");
+	succeed_if_same_string (keyString (k3), "b value");
+	Key * child = keyDup (escaped);
+	keyAddBaseName (child, "child");
+	succeed_if_same_string (keyName (child), "user/tests/mmapstorage/escaped\\/name/#0/child");
+	keyDel (child);
+
+	// write like a resolver does, the keys read before stay valid
+	char * tmpfile = elektraFormat ("%s.tmp", elektraFilename ());
+	keySetString (parentKey, tmpfile);
+	succeed_if (plugin->kdbSet (plugin, read, parentKey) == 1, "call to kdbSet was not successful");
+	succeed_if (rename (tmpfile, elektraFilename ()) == 0, "could not rename file");
+	keySetString (parentKey, elektraFilename ());
+	elektraFree (tmpfile);
+
+	KeySet * reread = ksNew (0, KS_END);
+	succeed_if (plugin->kdbGet (plugin, reread, parentKey) == 1, "call to kdbGet was not successful");
+	compare_keyset (reread, read);
+	ksDel (read);
+	succeed_if_same_string (keyName (escaped), "user/tests/mmapstorage/escaped\\/name/#0");
+	succeed_if_same_string (keyString (escaped), "");
+	succeed_if_same_string (keyString (ksLookupByName (reread, "user/tests/mmapstorage/a", 0)), "changed");
+	succeed_if_same_string (keyString (keyGetMeta (ksLookupByName (reread, "user/tests/mmapstorage", 0), "new")), "meta");
+
+	keyDecRef (escaped);
+	keyDel (escaped);
+	ksDel (reread);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_empty (void)
+{
+	printf ("Test write and read empty key set\n");
+
+	Key * parentKey = keyNew ("user/tests/mmapstorage", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("mmapstorage");
+
+	KeySet * ks = ksNew (0, KS_END);
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 1, "call to kdbGet was not successful");
+	succeed_if (ksGetSize (ks) == 0, "keys read from empty file");
+
+	FILE * f = fopen (keyString (parentKey), "w");
+	exit_if_fail (f, "could not truncate file");
+	fclose (f);
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "empty file should be no error");
+	succeed_if (ksGetSize (ks) == 0, "keys read from empty file");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+static void test_corrupt (void)
+{
+	printf ("Test read corrupt file\n");
+
+	Key * parentKey = keyNew ("user/tests/mmapstorage", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("mmapstorage");
+
+	KeySet * ks = getKeys ();
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+
+	struct stat buf;
+	succeed_if (stat (keyString (parentKey), &buf) == 0, "could not stat file");
+	for (off_t cut = 1; cut < buf.st_size; cut += 7)
+	{
+		succeed_if (truncate (keyString (parentKey), buf.st_size - cut) == 0, "could not truncate file");
+
+		KeySet * read = ksNew (1, keyNew ("user/tests/mmapstorage/unchanged", KEY_END), KS_END);
+		succeed_if (plugin->kdbGet (plugin, read, parentKey) == -1, "corrupt file was read");
+		succeed_if (keyGetMeta (parentKey, "error"), "no error for corrupt file");
+		succeed_if (ksGetSize (read) == 1, "keys changed although file is corrupt");
+		ksDel (read);
+		keySetMeta (parentKey, "error", 0);
+	}
+
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+
+static void test_corruptName (void)
+{
+	printf ("Test read file with corrupt names\n");
+
+	Key * parentKey = keyNew ("user/tests/mmapstorage", KEY_VALUE, elektraFilename (), KEY_END);
+	KeySet * conf = ksNew (0, KS_END);
+	PLUGIN_OPEN ("mmapstorage");
+
+	KeySet * ks = getKeys ();
+	succeed_if (plugin->kdbSet (plugin, ks, parentKey) == 1, "call to kdbSet was not successful");
+
+	struct stat buf;
+	exit_if_fail (stat (keyString (parentKey), &buf) == 0, "could not stat file");
+	char * original = elektraMalloc (buf.st_size);
+	FILE * f = fopen (keyString (parentKey), "rb");
+	exit_if_fail (f && fread (original, 1, buf.st_size, f) == (size_t)buf.st_size, "could not read file");
+	fclose (f);
+
+	// escaped name directly followed by the unescaped one
+	const char name[] = "user/tests/mmapstorage/a";
+	char * found = 0;
+	for (off_t i = 0; !found && i + (off_t)sizeof (name) <= buf.st_size; ++i)
+	{
+		if (!memcmp (original + i, name, sizeof (name))) found = original + i;
+	}
+	exit_if_fail (found, "name not found in file");
+
+	// the file size and all offsets stay the same, only a name differs
+	const struct
+	{
+		size_t offset;
+		char byte;
+	} corruptions[] = {
+		{ sizeof (name) - 2, 'x' },		 // escaped name differs from unescaped name
+		{ sizeof (name) + sizeof (name) - 2, 'x' }, // unescaped name differs from escaped name
+		{ 4, '\0' },				 // escaped name contains null
+		{ sizeof (name) - 2, '\\' },		 // escaped name ends with an escape
+	};
+
+	for (size_t i = 0; i < sizeof (corruptions) / sizeof (corruptions[0]); ++i)
+	{
+		char saved = found[corruptions[i].offset];
+		found[corruptions[i].offset] = corruptions[i].byte;
+		f = fopen (keyString (parentKey), "wb");
+		exit_if_fail (f && fwrite (original, 1, buf.st_size, f) == (size_t)buf.st_size, "could not write file");
+		fclose (f);
+		found[corruptions[i].offset] = saved;
+
+		KeySet * read = ksNew (1, keyNew ("user/tests/mmapstorage/unchanged", KEY_END), KS_END);
+		succeed_if (plugin->kdbGet (plugin, read, parentKey) == -1, "file with corrupt name was read");
+		succeed_if_same_string (keyString (keyGetMeta (parentKey, "error/number")), "147");
+		succeed_if (ksGetSize (read) == 1, "keys changed although file is corrupt");
+		ksDel (read);
+		keySetMeta (parentKey, "error", 0);
+		keySetMeta (parentKey, "error/number", 0);
+	}
+
+	elektraFree (original);
+	ksDel (ks);
+	keyDel (parentKey);
+	PLUGIN_CLOSE ();
+}
+
+int main (int argc, char ** argv)
+{
+	printf ("MMAPSTORAGE     TESTS\n");
+	printf ("==================\n\n");
+
+	init (argc, argv);
+
+	test_roundtrip ();
+	test_empty ();
+	test_corrupt ();
+	test_corruptName ();
+
+	printf ("\ntestmod_mmapstorage RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
@@ -0,0 +1,334 @@
+/**
+ * @file
+ *
+ * @brief Group commit of the files written by one kdbSet()
+ *
+ * kdbSet() prepares all files before it commits the first one,
+ * within the calling thread. So all files prepared by a thread and
+ * not yet committed belong to the same kdbSet(). The first commit
+ * makes the temporary files of all of them durable in parallel, the
+ * last commit syncs every directory with a renamed file once. So a
+ * kdbSet() on many backends does not wait for the syncs one after
+ * the other.
+ *
+ * Without threads (variants without mutex) every file is committed
+ * on its own.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include "resolver.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#ifdef ELEKTRA_LOCK_MUTEX
+#include <pthread.h>
+#endif
+
+#define GROUP_THREADS 8
+
+struct _resolverGroup
+{
+	resolverHandle ** handles; ///< prepared, but not yet committed
+	size_t size;
+	size_t alloc;
+	char ** dirs; ///< directories with committed files, each once
+	size_t dirsSize;
+	size_t dirsAlloc;
+	int synced; ///< if the temporary files of handles are durable
+};
+
+typedef struct
+{
+	const char * name; ///< the file or directory to sync
+	int directory;	   ///< if the directory entries need to be synced
+	int error;	   ///< errno of the failed sync, 0 on success
+} resolverSync;
+
+typedef struct
+{
+	resolverSync * jobs;
+	size_t size;
+	size_t next; ///< the next job to take
+} resolverSyncPool;
+
+#ifdef ELEKTRA_LOCK_MUTEX
+static __thread resolverGroup * groupCurrent = 0; // the files prepared by this thread
+#endif
+
+static resolverGroup * groupNew (void)
+{
+	return elektraCalloc (sizeof (resolverGroup));
+}
+
+static void groupDel (resolverGroup * g)
+{
+	for (size_t i = 0; i < g->dirsSize; ++i)
+	{
+		elektraFree (g->dirs[i]);
+	}
+	elektraFree (g->dirs);
+	elektraFree (g->handles);
+	elektraFree (g);
+}
+
+static void groupSyncOne (resolverSync * job)
+{
+	int fd = open (job->name, O_RDONLY);
+	if (fd == -1)
+	{
+		job->error = errno;
+		return;
+	}
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+	// the metadata of the temporary file does not matter, it gets renamed
+	int ret = job->directory ? fsync (fd) : fdatasync (fd);
+#else
+	int ret = fsync (fd);
+#endif
+	job->error = ret == -1 ? errno : 0;
+	close (fd);
+}
+
+static void * groupWorker (void * data)
+{
+	resolverSyncPool * pool = data;
+	size_t job;
+	while ((job = __atomic_fetch_add (&pool->next, 1, __ATOMIC_SEQ_CST)) < pool->size)
+	{
+		groupSyncOne (&pool->jobs[job]);
+	}
+	return 0;
+}
+
+/**
+ * @brief Sync all files, in parallel if possible
+ *
+ * The calling thread works, too.
+ */
+static void groupSyncAll (resolverSync * jobs, size_t size)
+{
+	resolverSyncPool pool = { jobs, size, 0 };
+#ifdef ELEKTRA_LOCK_MUTEX
+	pthread_t workers[GROUP_THREADS];
+	size_t started = 0;
+	while (started + 1 < size && started < GROUP_THREADS)
+	{
+		if (pthread_create (&workers[started], 0, groupWorker, &pool) != 0) break;
+		++started;
+	}
+	groupWorker (&pool);
+	for (size_t i = 0; i < started; ++i)
+	{
+		pthread_join (workers[i], 0);
+	}
+#else
+	groupWorker (&pool);
+#endif
+}
+
+static ssize_t groupFind (resolverGroup * g, resolverHandle * p)
+{
+	for (size_t i = 0; g && i < g->size; ++i)
+	{
+		if (g->handles[i] == p) return i;
+	}
+	return -1;
+}
+
+static void groupAddDir (resolverGroup * g, const char * dirname)
+{
+	for (size_t i = 0; i < g->dirsSize; ++i)
+	{
+		if (!strcmp (g->dirs[i], dirname)) return;
+	}
+
+	if (g->dirsSize == g->dirsAlloc)
+	{
+		size_t alloc = g->dirsAlloc ? g->dirsAlloc * 2 : 4;
+		if (elektraRealloc ((void **)&g->dirs, alloc * sizeof (char *)) == -1) return;
+		g->dirsAlloc = alloc;
+	}
+	g->dirs[g->dirsSize] = elektraStrDup (dirname);
+	if (g->dirs[g->dirsSize]) ++g->dirsSize;
+}
+
+/**
+ * @brief Add a prepared file to the group of the current kdbSet()
+ *
+ * @pre the file is locked
+ *
+ * @param p the handle whose temporary file gets written
+ *
+ * @retval 0 on success
+ * @retval -1 if the file will be committed on its own
+ */
+int ELEKTRA_PLUGIN_FUNCTION (resolver, groupJoin) (resolverHandle * p)
+{
+#ifdef ELEKTRA_LOCK_MUTEX
+	if (!groupCurrent) groupCurrent = groupNew ();
+	if (!groupCurrent) return -1;
+
+	resolverGroup * g = groupCurrent;
+	if (groupFind (g, p) != -1) return 0;
+	if (g->size == g->alloc)
+	{
+		size_t alloc = g->alloc ? g->alloc * 2 : 4;
+		if (elektraRealloc ((void **)&g->handles, alloc * sizeof (resolverHandle *)) == -1) return -1;
+		g->alloc = alloc;
+	}
+	g->handles[g->size++] = p;
+	return 0;
+#else
+	(void)p;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Make the temporary file durable before it gets renamed
+ *
+ * The first call of a group syncs the temporary files of all
+ * files in the group, later calls do not need to wait.
+ *
+ * @pre the file is locked
+ *
+ * @param p the handle to commit
+ * @param parentKey to add a warning if the file could not be synced
+ */
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupSync) (resolverHandle * p, Key * parentKey)
+{
+	resolverGroup * g = 0;
+#ifdef ELEKTRA_LOCK_MUTEX
+	if (groupFind (groupCurrent, p) != -1) g = groupCurrent;
+#endif
+
+	resolverSync * jobs = g && !g->synced ? elektraCalloc (g->size * sizeof (resolverSync)) : 0;
+	if (jobs)
+	{
+		for (size_t i = 0; i < g->size; ++i)
+		{
+			jobs[i].name = g->handles[i]->tempfile;
+		}
+		groupSyncAll (jobs, g->size);
+		for (size_t i = 0; i < g->size; ++i)
+		{
+			g->handles[i]->syncError = jobs[i].error;
+		}
+		elektraFree (jobs);
+		g->synced = 1;
+	}
+	else if (!g || !g->synced)
+	{
+		resolverSync job = { p->tempfile, 0, 0 };
+		groupSyncOne (&job);
+		p->syncError = job.error;
+	}
+
+	if (p->syncError)
+	{
+		ELEKTRA_ADD_WARNINGF (145, parentKey, "Could not sync temporary file \"%s\", because %s", p->tempfile,
+				      strerror (p->syncError));
+	}
+}
+
+/**
+ * @brief Remove a file from the group
+ *
+ * @pre the file is locked
+ *
+ * @param p the handle which was committed or aborted
+ * @param committed if the file was renamed, then its directory needs a sync
+ *
+ * @return the group to be flushed with ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush),
+ *         it is returned for the last file of the group only
+ */
+resolverGroup * ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave) (resolverHandle * p, int committed)
+{
+	resolverGroup * g = 0;
+#ifdef ELEKTRA_LOCK_MUTEX
+	ssize_t found = groupFind (groupCurrent, p);
+	if (found != -1)
+	{
+		g = groupCurrent;
+		g->handles[found] = g->handles[--g->size];
+		if (committed) groupAddDir (g, p->dirname);
+		if (g->size > 0) return 0;
+		groupCurrent = 0;
+		return g;
+	}
+#endif
+
+	if (!committed) return 0;
+	g = groupNew ();
+	if (g) groupAddDir (g, p->dirname);
+	return g;
+}
+
+/**
+ * @brief Remove a file from the group when its plugin is closed
+ *
+ * A file prepared but neither committed nor aborted must not stay
+ * in the group of the thread, the group would keep a dangling
+ * pointer to its handle. If it was the last file of the group, the
+ * directories of the other files are synced, warnings are dropped.
+ *
+ * @param p the handle which gets freed
+ */
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupRemove) (resolverHandle * p)
+{
+	resolverGroup * g = ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave) (p, 0);
+	if (!g) return;
+
+	Key * warningsKey = keyNew (0, KEY_END);
+	ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush) (g, warningsKey);
+	keyDel (warningsKey);
+}
+
+/**
+ * @brief Sync the directories of all committed files of the group
+ *
+ * The group is freed afterwards. Should be called after the file
+ * was unlocked, so that other threads do not need to wait.
+ *
+ * @param g the group returned by ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave), may be 0
+ * @param parentKey to add warnings for directories which could not be synced
+ */
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush) (resolverGroup * g, Key * parentKey)
+{
+	if (!g) return;
+
+	resolverSync * jobs = elektraCalloc ((g->dirsSize ? g->dirsSize : 1) * sizeof (resolverSync));
+	for (size_t i = 0; jobs && i < g->dirsSize; ++i)
+	{
+		jobs[i].name = g->dirs[i];
+		jobs[i].directory = 1;
+	}
+
+	if (jobs)
+	{
+		groupSyncAll (jobs, g->dirsSize);
+		for (size_t i = 0; i < g->dirsSize; ++i)
+		{
+			if (!jobs[i].error) continue;
+			ELEKTRA_ADD_WARNINGF (88, parentKey, "Could not sync directory \"%s\", because %s", g->dirs[i],
+					      strerror (jobs[i].error));
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < g->dirsSize; ++i)
+		{
+			resolverSync job = { g->dirs[i], 1, 0 };
+			groupSyncOne (&job);
+			if (!job.error) continue;
+			ELEKTRA_ADD_WARNINGF (88, parentKey, "Could not sync directory \"%s\", because %s", g->dirs[i],
+					      strerror (job.error));
+		}
+	}
+
+	elektraFree (jobs);
+	groupDel (g);
+}
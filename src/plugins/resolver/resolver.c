@@ -27,7 +27,6 @@
 #include <sys/time.h>
 #include <unistd.h>
 
-#include <dirent.h>
 #include <kdberrors.h>
 #include <sys/types.h>
 
@@ -47,16 +46,20 @@
 #endif
 
 #ifdef ELEKTRA_LOCK_MUTEX
-#if defined(PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP)
-static pthread_mutex_t elektraResolverMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
-#elif defined(PTHREAD_RECURSIVE_MUTEX_INITIALIZER)
-static pthread_mutex_t elektraResolverMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
-#else
-static pthread_mutex_t elektraResolverMutex;
-static pthread_mutex_t elektraResolverInitMutex = PTHREAD_MUTEX_INITIALIZER;
-static unsigned char elektraResolverMutexInitialized = 0;
-#define ELEKTRA_RESOLVER_RECURSIVE_MUTEX_INITIALIZATION
-#endif
+/**
+ * A configuration file locked by a thread of this process.
+ */
+struct _resolverLock
+{
+	dev_t dev;
+	ino_t ino;
+	pthread_t owner;
+	size_t count; ///< how often the owner locked the file
+	struct _resolverLock * next;
+};
+
+static pthread_mutex_t elektraResolverLocksMutex = PTHREAD_MUTEX_INITIALIZER;
+static struct _resolverLock * elektraResolverLocks = 0; // protected by elektraResolverLocksMutex
 #endif
 
 static void resolverInit (resolverHandle * p, const char * path)
@@ -67,6 +70,8 @@ static void resolverInit (resolverHandle * p, const char * path)
 	p->filemode = KDB_FILE_MODE;
 	p->dirmode = KDB_FILE_MODE | KDB_DIR_MODE;
 	p->removalNeeded = 0;
+	p->syncError = 0;
+	p->lock = 0;
 
 	p->filename = 0;
 	p->dirname = 0;
@@ -76,6 +81,10 @@ static void resolverInit (resolverHandle * p, const char * path)
 
 	p->uid = 0;
 	p->gid = 0;
+
+	p->notify = 0;
+	p->wd = -1;
+	p->dirty = 1;
 }
 
 static resolverHandle * elektraGetResolverHandle (Plugin * handle, Key * parentKey)
@@ -105,6 +114,8 @@ static resolverHandle * elektraGetResolverHandle (Plugin * handle, Key * parentK
 
 static void resolverCloseOne (resolverHandle * p)
 {
+	// a file prepared by kdbSet() but never committed or aborted
+	if (p->fd > -1) ELEKTRA_PLUGIN_FUNCTION (resolver, groupRemove) (p);
 	elektraFree (p->filename);
 	p->filename = 0;
 	elektraFree (p->dirname);
@@ -115,6 +126,12 @@ static void resolverCloseOne (resolverHandle * p)
 
 static void resolverClose (resolverHandles * p)
 {
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (&p->spec);
+	ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (&p->dir);
+	ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (&p->user);
+	ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (&p->system);
+#endif
 	resolverCloseOne (&p->spec);
 	resolverCloseOne (&p->dir);
 	resolverCloseOne (&p->user);
@@ -198,29 +215,64 @@ static int elektraUnlockFile (int fd ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNU
 }
 
 /**
- * @brief mutex lock for multithread-safety
+ * @brief lock the configuration file for other threads
+ *
+ * File locks only work between processes, so the threads of this process
+ * need another lock for the file. The lock is identified by device
+ * and inode of the opened configuration file, so threads writing
+ * other files do not need to wait. The owner may lock a file again,
+ * e.g. if several backends share it.
+ *
+ * @param pk the resolver handle with the opened configuration file
  *
  * @retval 0 on success
- * @retval -1 on error
+ * @retval -1 on error (another thread has the lock)
  */
-static int elektraLockMutex (Key * parentKey ELEKTRA_UNUSED)
+static int elektraLockMutex (resolverHandle * pk ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
 {
 #ifdef ELEKTRA_LOCK_MUTEX
-	int ret = pthread_mutex_trylock (&elektraResolverMutex);
-	if (ret != 0)
+	struct stat buf;
+	if (fstat (pk->fd, &buf) == -1)
 	{
-		if (errno == EBUSY       // for trylock
-		    || errno == EDEADLK) // for error checking mutex, if enabled
-		{
-			ELEKTRA_SET_ERROR (30, parentKey, "conflict because other thread writes to configuration indicated by mutex lock");
-		}
-		else
+		ELEKTRA_SET_ERRORF (30, parentKey, "assuming conflict because of failed stat for mutex lock with message: %s",
+				    strerror (errno));
+		return -1;
+	}
+
+	pthread_mutex_lock (&elektraResolverLocksMutex);
+	struct _resolverLock * lock = elektraResolverLocks;
+	while (lock && (lock->dev != buf.st_dev || lock->ino != buf.st_ino))
+	{
+		lock = lock->next;
+	}
+
+	if (lock && !pthread_equal (lock->owner, pthread_self ()))
+	{
+		pthread_mutex_unlock (&elektraResolverLocksMutex);
+		ELEKTRA_SET_ERROR (30, parentKey, "conflict because other thread writes to configuration indicated by mutex lock");
+		return -1;
+	}
+
+	if (!lock)
+	{
+		lock = elektraMalloc (sizeof (struct _resolverLock));
+		if (!lock)
 		{
-			ELEKTRA_SET_ERRORF (30, parentKey, "assuming conflict because of failed mutex lock with message: %s",
-					    strerror (errno));
+			pthread_mutex_unlock (&elektraResolverLocksMutex);
+			ELEKTRA_SET_ERROR (87, parentKey, "Out of memory");
+			return -1;
 		}
-		return -1;
+		lock->dev = buf.st_dev;
+		lock->ino = buf.st_ino;
+		lock->owner = pthread_self ();
+		lock->count = 0;
+		lock->next = elektraResolverLocks;
+		elektraResolverLocks = lock;
 	}
+	++lock->count;
+	pthread_mutex_unlock (&elektraResolverLocksMutex);
+
+	pk->lock = lock;
 	return 0;
 #else
 	return 0;
@@ -228,23 +280,29 @@ static int elektraLockMutex (Key * parentKey ELEKTRA_UNUSED)
 }
 
 /**
- * @brief mutex unlock for multithread-safety
+ * @brief give the lock of elektraLockMutex() back
  *
- * @retval 0 on success
- * @retval -1 on error
+ * @param pk the resolver handle which has the lock
  */
-static int elektraUnlockMutex (Key * parentKey ELEKTRA_UNUSED)
+static void elektraUnlockMutex (resolverHandle * pk ELEKTRA_UNUSED)
 {
 #ifdef ELEKTRA_LOCK_MUTEX
-	int ret = pthread_mutex_unlock (&elektraResolverMutex);
-	if (ret != 0)
+	struct _resolverLock * lock = pk->lock;
+	if (!lock) return;
+	pk->lock = 0;
+
+	pthread_mutex_lock (&elektraResolverLocksMutex);
+	if (--lock->count == 0)
 	{
-		ELEKTRA_ADD_WARNINGF (32, parentKey, "mutex unlock failed with message: %s", strerror (errno));
-		return -1;
+		struct _resolverLock ** prev = &elektraResolverLocks;
+		while (*prev != lock)
+		{
+			prev = &(*prev)->next;
+		}
+		*prev = lock->next;
+		elektraFree (lock);
 	}
-	return 0;
-#else
-	return 0;
+	pthread_mutex_unlock (&elektraResolverLocksMutex);
 #endif
 }
 
@@ -374,41 +432,6 @@ int ELEKTRA_PLUGIN_FUNCTION (resolver, open) (Plugin * handle, Key * errorKey)
 	resolverInit (&p->user, path);
 	resolverInit (&p->system, path);
 
-#if defined(ELEKTRA_RESOLVER_RECURSIVE_MUTEX_INITIALIZATION)
-	// PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP is available in glibc only
-	// so we use another mutex for the initialization of the recursive mutex,
-	// since this section must be thread safe.
-	pthread_mutex_lock (&elektraResolverInitMutex);
-	if (!elektraResolverMutexInitialized)
-	{
-		pthread_mutexattr_t mutexAttr;
-		int mutexError;
-
-		if ((mutexError = pthread_mutexattr_init (&mutexAttr)) != 0)
-		{
-			ELEKTRA_SET_ERRORF (35, errorKey, "Could not initialize recursive mutex: pthread_mutexattr_init returned %d",
-					    mutexError);
-			pthread_mutex_unlock (&elektraResolverInitMutex);
-			return -1;
-		}
-		if ((mutexError = pthread_mutexattr_settype (&mutexAttr, PTHREAD_MUTEX_RECURSIVE)) != 0)
-		{
-			ELEKTRA_SET_ERRORF (35, errorKey, "Could not initialize recursive mutex: pthread_mutexattr_settype returned %d",
-					    mutexError);
-			pthread_mutex_unlock (&elektraResolverInitMutex);
-			return -1;
-		}
-		if ((mutexError = pthread_mutex_init (&elektraResolverMutex, &mutexAttr)) != 0)
-		{
-			ELEKTRA_SET_ERRORF (35, errorKey, "Could not initialize recursive mutex: pthread_mutex_init returned %d",
-					    mutexError);
-			pthread_mutex_unlock (&elektraResolverInitMutex);
-			return -1;
-		}
-		elektraResolverMutexInitialized = 1;
-	}
-	pthread_mutex_unlock (&elektraResolverInitMutex);
-#endif
 
 	// system and spec files need to be world-readable, otherwise they are
 	// useless
@@ -419,6 +442,18 @@ int ELEKTRA_PLUGIN_FUNCTION (resolver, open) (Plugin * handle, Key * errorKey)
 
 	int ret = mapFilesForNamespaces (p, errorKey);
 
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	if (ret != -1 && ksLookupByName (resolverConfig, "/inotify", 0))
+	{
+		// failing watches are not fatal, get() will stat() as usual
+		resolverHandle * handles[] = { &p->spec, &p->dir, &p->user, &p->system };
+		for (size_t i = 0; i < sizeof (handles) / sizeof (handles[0]); ++i)
+		{
+			if (handles[i]->filename) ELEKTRA_PLUGIN_FUNCTION (resolver, watch) (handles[i]);
+		}
+	}
+#endif
+
 	elektraPluginSetData (handle, p);
 
 	return ret; /* success */
@@ -457,6 +492,11 @@ int ELEKTRA_PLUGIN_FUNCTION (resolver, get) (Plugin * handle, KeySet * returned,
 
 	keySetString (parentKey, pk->filename);
 
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	// no event since last time, so the stat() below cannot tell anything new
+	if (pk->notify && !ELEKTRA_PLUGIN_FUNCTION (resolver, changed) (pk)) return 0;
+#endif
+
 	int errnoSave = errno;
 	struct stat buf;
 
@@ -687,6 +727,9 @@ static int elektraRemoveConfigurationFile (resolverHandle * pk, Key * parentKey)
 	{
 		ELEKTRA_SET_ERROR (28, parentKey, strerror (errno));
 	}
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	ELEKTRA_PLUGIN_FUNCTION (resolver, touch) (pk->filename);
+#endif
 
 	return 0;
 }
@@ -728,7 +771,7 @@ static int elektraSetPrepare (resolverHandle * pk, Key * parentKey)
 		pk->removalNeeded = 1;
 	}
 
-	if (elektraLockMutex (parentKey) != 0)
+	if (elektraLockMutex (pk, parentKey) != 0)
 	{
 		elektraCloseFile (pk->fd, parentKey);
 		pk->fd = -1;
@@ -739,7 +782,7 @@ static int elektraSetPrepare (resolverHandle * pk, Key * parentKey)
 	if (elektraLockFile (pk->fd, parentKey) == -1)
 	{
 		elektraCloseFile (pk->fd, parentKey);
-		elektraUnlockMutex (parentKey);
+		elektraUnlockMutex (pk);
 		pk->fd = -1;
 		return -1;
 	}
@@ -748,7 +791,7 @@ static int elektraSetPrepare (resolverHandle * pk, Key * parentKey)
 	{
 		elektraUnlockFile (pk->fd, parentKey);
 		elektraCloseFile (pk->fd, parentKey);
-		elektraUnlockMutex (parentKey);
+		elektraUnlockMutex (pk);
 		pk->fd = -1;
 		return -1;
 	}
@@ -798,11 +841,17 @@ static int elektraSetCommit (resolverHandle * pk, Key * parentKey)
 {
 	int ret = 0;
 
+	// the content must be durable before it replaces the configuration file
+	ELEKTRA_PLUGIN_FUNCTION (resolver, groupSync) (pk, parentKey);
+
 	if (rename (pk->tempfile, pk->filename) == -1)
 	{
 		ELEKTRA_SET_ERROR (31, parentKey, strerror (errno));
 		ret = -1;
 	}
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	ELEKTRA_PLUGIN_FUNCTION (resolver, touch) (pk->filename);
+#endif
 
 	struct stat buf;
 	if (stat (pk->filename, &buf) == -1)
@@ -828,15 +877,11 @@ static int elektraSetCommit (resolverHandle * pk, Key * parentKey)
 	}
 	elektraUnlockFile (pk->fd, parentKey);
 	elektraCloseFile (pk->fd, parentKey);
-	elektraUnlockMutex (parentKey);
+	resolverGroup * group = ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave) (pk, 1);
+	elektraUnlockMutex (pk);
 
-	DIR * dirp = opendir (pk->dirname);
-	// checking dirp not needed, fsync will have EBADF
-	if (fsync (dirfd (dirp)) == -1)
-	{
-		ELEKTRA_ADD_WARNINGF (88, parentKey, "Could not sync directory \"%s\", because %s", pk->dirname, strerror (errno));
-	}
-	closedir (dirp);
+	// the last commit of the group syncs all directories once
+	ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush) (group, parentKey);
 
 	return ret;
 }
@@ -870,6 +915,11 @@ int ELEKTRA_PLUGIN_FUNCTION (resolver, set) (Plugin * handle, KeySet * ks, Key *
 			{
 				ret = -1;
 			}
+			else
+			{
+				// commit together with the other files of this kdbSet()
+				ELEKTRA_PLUGIN_FUNCTION (resolver, groupJoin) (pk);
+			}
 		}
 	}
 	else if (pk->fd == -2)
@@ -934,7 +984,9 @@ int ELEKTRA_PLUGIN_FUNCTION (resolver, error) (Plugin * handle, KeySet * r ELEKT
 		{ // removal needed state (= resolver created file, but error)
 			elektraUnlinkFile (pk->filename, parentKey);
 		}
-		elektraUnlockMutex (parentKey);
+		resolverGroup * group = ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave) (pk, 0);
+		elektraUnlockMutex (pk);
+		ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush) (group, parentKey);
 	}
 
 	// reset for next time
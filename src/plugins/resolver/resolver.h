@@ -30,6 +30,8 @@ struct _resolverHandle
 	mode_t filemode;       ///< The mode to set (from previous file)
 	mode_t dirmode;	///< The mode to set for new directories
 	int removalNeeded;     ///< Error on freshly created files need removal
+	int syncError;	       ///< errno of syncing the temporary file, 0 on success
+	struct _resolverLock * lock; ///< lock of the file for the other threads
 
 	char * dirname;  ///< directory where real+temp file is
 	char * filename; ///< the full path to the configuration file
@@ -41,9 +43,14 @@ struct _resolverHandle
 
 	gid_t gid;
 	uid_t uid;
+
+	int notify; ///< if changes are detected with inotify
+	int wd;	    ///< inotify watch of the directory of the file
+	int dirty;  ///< if the file might have changed, set by the watcher thread
 };
 
 typedef struct _resolverHandles resolverHandles;
+typedef struct _resolverGroup resolverGroup;
 
 struct _resolverHandles
 {
@@ -56,6 +63,19 @@ struct _resolverHandles
 int ELEKTRA_PLUGIN_FUNCTION (resolver, checkFile) (const char * filename);
 int ELEKTRA_PLUGIN_FUNCTION (resolver, filename) (Key * forKey, resolverHandle * p, Key * warningsKey);
 
+int ELEKTRA_PLUGIN_FUNCTION (resolver, groupJoin) (resolverHandle * p);
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupSync) (resolverHandle * p, Key * parentKey);
+resolverGroup * ELEKTRA_PLUGIN_FUNCTION (resolver, groupLeave) (resolverHandle * p, int committed);
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupRemove) (resolverHandle * p);
+void ELEKTRA_PLUGIN_FUNCTION (resolver, groupFlush) (resolverGroup * g, Key * parentKey);
+
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+int ELEKTRA_PLUGIN_FUNCTION (resolver, watch) (resolverHandle * p);
+void ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (resolverHandle * p);
+int ELEKTRA_PLUGIN_FUNCTION (resolver, changed) (resolverHandle * p);
+void ELEKTRA_PLUGIN_FUNCTION (resolver, touch) (const char * filename);
+#endif
+
 int ELEKTRA_PLUGIN_FUNCTION (resolver, open) (Plugin * handle, Key * errorKey);
 int ELEKTRA_PLUGIN_FUNCTION (resolver, close) (Plugin * handle, Key * errorKey);
 int ELEKTRA_PLUGIN_FUNCTION (resolver, get) (Plugin * handle, KeySet * ks, Key * parentKey);
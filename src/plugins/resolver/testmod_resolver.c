@@ -11,6 +11,8 @@
 #include <kdbinternal.h>
 
 #include <langinfo.h>
+#include <pthread.h>
+#include <utime.h>
 
 #include "resolver.h"
 
@@ -235,6 +237,300 @@ void test_checkfile ()
 	elektraModulesClose (modules, 0);
 	ksDel (modules);
 }
+static Plugin * openGroupPlugin (KeySet * modules, const char * path)
+{
+	KeySet * conf = ksNew (1, keyNew ("system/path", KEY_VALUE, path, KEY_END), KS_END);
+	Plugin * plugin = elektraPluginOpen ("resolver", modules, conf, 0);
+	exit_if_fail (plugin, "could not load resolver plugin");
+	return plugin;
+}
+
+static void writeGroupFile (const char * filename, const char * content)
+{
+	FILE * f = fopen (filename, "w");
+	exit_if_fail (f, "could not write temporary file");
+	fputs (content, f);
+	fclose (f);
+}
+
+static int groupFileIs (const char * filename, const char * content)
+{
+	char buffer[100] = "";
+	FILE * f = fopen (filename, "r");
+	if (!f) return 0;
+	if (!fgets (buffer, sizeof (buffer), f)) buffer[0] = '\0';
+	fclose (f);
+	return !strcmp (buffer, content);
+}
+
+void test_group ()
+{
+	printf ("Group commit of several files\n");
+
+	const char * names[] = { "/group/a.ecf", "/group/b.ecf", "/group/sub/c.ecf" };
+	const size_t size = sizeof (names) / sizeof (names[0]);
+	char * paths[size];
+	Plugin * plugins[size];
+	Key * parentKeys[size];
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+	KeySet * ks = ksNew (1, keyNew ("system/tests/group/key", KEY_VALUE, "value", KEY_END), KS_END);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		size_t len = tempHomeLen + strlen (names[i]) + 1;
+		paths[i] = elektraMalloc (len);
+		snprintf (paths[i], len, "%s%s", tempHome, names[i]);
+		plugins[i] = openGroupPlugin (modules, paths[i]);
+		parentKeys[i] = keyNew ("system/tests/group", KEY_END);
+	}
+
+	// prepare all files, like kdbSet() does
+	for (size_t i = 0; i < size; ++i)
+	{
+		succeed_if (plugins[i]->kdbSet (plugins[i], ks, parentKeys[i]) == 1, "could not prepare file");
+		writeGroupFile (keyString (parentKeys[i]), names[i]);
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		resolverHandles * h = elektraPluginGetData (plugins[i]);
+		succeed_if (plugins[i]->kdbSet (plugins[i], ks, parentKeys[i]) == 1, "could not commit file");
+		succeed_if (h->system.syncError == 0, "temporary file not synced");
+		succeed_if (h->system.fd == -1, "file not committed");
+		succeed_if (access (h->system.tempfile, F_OK) == -1, "temporary file still there");
+		succeed_if (!keyGetMeta (parentKeys[i], "warnings"), "commit had warnings");
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		succeed_if (groupFileIs (paths[i], names[i]), "committed file has wrong content");
+	}
+
+	// abort some files of a group, commit the others
+	for (size_t i = 0; i < size; ++i)
+	{
+		plugins[i]->kdbGet (plugins[i], ks, parentKeys[i]);
+		succeed_if (plugins[i]->kdbSet (plugins[i], ks, parentKeys[i]) == 1, "could not prepare file");
+		writeGroupFile (keyString (parentKeys[i]), "changed");
+	}
+
+	succeed_if (plugins[0]->kdbError (plugins[0], ks, parentKeys[0]) == 0, "could not abort file");
+	for (size_t i = 1; i < size; ++i)
+	{
+		succeed_if (plugins[i]->kdbSet (plugins[i], ks, parentKeys[i]) == 1, "could not commit file");
+	}
+
+	succeed_if (groupFileIs (paths[0], names[0]), "aborted file changed");
+	for (size_t i = 1; i < size; ++i)
+	{
+		succeed_if (groupFileIs (paths[i], "changed"), "committed file not changed");
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		unlink (paths[i]);
+		keyDel (parentKeys[i]);
+		elektraPluginClose (plugins[i], 0);
+		elektraFree (paths[i]);
+	}
+	ksDel (ks);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+void test_groupClose ()
+{
+	printf ("Close a plugin with a prepared file of a group\n");
+
+	const char * names[] = { "/groupclose/a.ecf", "/groupclose/b.ecf" };
+	char * paths[2];
+	Plugin * plugins[2];
+	Key * parentKeys[2];
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+	KeySet * ks = ksNew (1, keyNew ("system/tests/group/key", KEY_VALUE, "value", KEY_END), KS_END);
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		size_t len = tempHomeLen + strlen (names[i]) + 1;
+		paths[i] = elektraMalloc (len);
+		snprintf (paths[i], len, "%s%s", tempHome, names[i]);
+		plugins[i] = openGroupPlugin (modules, paths[i]);
+		parentKeys[i] = keyNew ("system/tests/group", KEY_END);
+		succeed_if (plugins[i]->kdbSet (plugins[i], ks, parentKeys[i]) == 1, "could not prepare file");
+		writeGroupFile (keyString (parentKeys[i]), names[i]);
+	}
+
+	// the handle of the first file is freed, it must not be synced anymore
+	unlink (keyString (parentKeys[0]));
+	elektraPluginClose (plugins[0], 0);
+
+	succeed_if (plugins[1]->kdbSet (plugins[1], ks, parentKeys[1]) == 1, "could not commit file");
+	succeed_if (!keyGetMeta (parentKeys[1], "warnings"), "commit had warnings");
+	succeed_if (groupFileIs (paths[1], names[1]), "committed file has wrong content");
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		unlink (paths[i]);
+		keyDel (parentKeys[i]);
+		elektraFree (paths[i]);
+	}
+	elektraPluginClose (plugins[1], 0);
+	ksDel (ks);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+typedef struct
+{
+	Plugin * plugin;
+	KeySet * ks;
+	Key * parentKey;
+	int ret;
+} lockJob;
+
+static void * lockThread (void * data)
+{
+	lockJob * job = data;
+	job->ret = job->plugin->kdbSet (job->plugin, job->ks, job->parentKey);
+	job->plugin->kdbError (job->plugin, job->ks, job->parentKey);
+	return 0;
+}
+
+static int lockInThread (Plugin * plugin, KeySet * ks)
+{
+	lockJob job = { plugin, ks, keyNew ("system/tests/lock", KEY_END), 0 };
+	pthread_t thread;
+	exit_if_fail (pthread_create (&thread, 0, lockThread, &job) == 0, "could not create thread");
+	pthread_join (thread, 0);
+	keyDel (job.parentKey);
+	return job.ret;
+}
+
+void test_lock ()
+{
+	printf ("Locking of files for other threads\n");
+
+	const char * names[] = { "/lock/a.ecf", "/lock/b.ecf" };
+	char * paths[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		size_t len = tempHomeLen + strlen (names[i]) + 1;
+		paths[i] = elektraMalloc (len);
+		snprintf (paths[i], len, "%s%s", tempHome, names[i]);
+	}
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+	KeySet * ks = ksNew (1, keyNew ("system/tests/lock/key", KEY_VALUE, "value", KEY_END), KS_END);
+	Key * parentKey = keyNew ("system/tests/lock", KEY_END);
+	Key * otherKey = keyNew ("system/tests/lock", KEY_END);
+
+	Plugin * a = openGroupPlugin (modules, paths[0]);
+	Plugin * sameFile = openGroupPlugin (modules, paths[0]);
+	Plugin * b = openGroupPlugin (modules, paths[1]);
+
+	succeed_if (a->kdbSet (a, ks, parentKey) == 1, "could not prepare file");
+	succeed_if (lockInThread (sameFile, ks) == -1, "other thread could lock the same file");
+	succeed_if (lockInThread (b, ks) == 1, "other thread could not lock other file");
+
+	// the same thread may lock the file again
+	succeed_if (sameFile->kdbSet (sameFile, ks, otherKey) == 1, "could not prepare the same file twice");
+	succeed_if (sameFile->kdbError (sameFile, ks, otherKey) == 0, "could not abort file");
+	succeed_if (lockInThread (sameFile, ks) == -1, "file unlocked while still prepared");
+
+	succeed_if (a->kdbError (a, ks, parentKey) == 0, "could not abort file");
+	succeed_if (lockInThread (sameFile, ks) == 1, "file still locked after abort");
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		unlink (paths[i]);
+		elektraFree (paths[i]);
+	}
+	elektraPluginClose (a, 0);
+	elektraPluginClose (sameFile, 0);
+	elektraPluginClose (b, 0);
+	keyDel (parentKey);
+	keyDel (otherKey);
+	ksDel (ks);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+static int waitDirty (resolverHandle * p)
+{
+	// events are delivered asynchronously
+	for (int i = 0; i < 200; ++i)
+	{
+		if (__atomic_load_n (&p->dirty, __ATOMIC_SEQ_CST)) return 1;
+		usleep (10000);
+	}
+	return 0;
+}
+
+void test_inotify ()
+{
+	printf ("Change detection with inotify\n");
+
+	int pathLen = tempHomeLen + sizeof ("/inotify.ecf");
+	char * path = elektraMalloc (pathLen);
+	exit_if_fail (path != 0, "elektraMalloc failed");
+	snprintf (path, pathLen, "%s/inotify.ecf", tempHome);
+	unlink (path);
+
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+	KeySet * conf = ksNew (2, keyNew ("system/path", KEY_VALUE, path, KEY_END), keyNew ("system/inotify", KEY_END), KS_END);
+	Plugin * plugin = elektraPluginOpen ("resolver", modules, conf, 0);
+	exit_if_fail (plugin, "could not load resolver plugin");
+
+	resolverHandles * h = elektraPluginGetData (plugin);
+	exit_if_fail (h != 0, "no plugin handle");
+	succeed_if_same_string (h->system.filename, path);
+	succeed_if (h->system.notify, "file not watched");
+	succeed_if (h->system.wd != -1, "directory not watched");
+
+	Key * parentKey = keyNew ("system/tests/inotify", KEY_END);
+	KeySet * ks = ksNew (0, KS_END);
+
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "file does not exist");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "file still does not exist");
+
+	FILE * f = fopen (path, "w");
+	exit_if_fail (f, "could not create file");
+	fputs ("key = value\n", f);
+	fclose (f);
+
+	succeed_if (waitDirty (&h->system), "creation of file not detected");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 1, "new file not detected");
+	succeed_if_same_string (keyString (parentKey), path);
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "file did not change");
+	succeed_if (h->system.dirty == 0, "file should be clean");
+
+	struct utimbuf times = { 1000000000, 1000000000 };
+	succeed_if (utime (path, &times) == 0, "could not change mtime");
+	succeed_if (waitDirty (&h->system), "change of mtime not detected");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 1, "changed file not detected");
+	succeed_if (h->system.mtime.tv_sec == 1000000000, "mtime not updated");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "file did not change");
+
+	succeed_if (unlink (path) == 0, "could not remove file");
+	succeed_if (waitDirty (&h->system), "removal of file not detected");
+	succeed_if (plugin->kdbGet (plugin, ks, parentKey) == 0, "file was removed");
+	succeed_if (h->system.mtime.tv_sec == 0, "mtime not reset");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	elektraPluginClose (plugin, 0);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+	elektraFree (path);
+}
+#endif
 
 
 int main (int argc, char ** argv)
@@ -249,6 +545,12 @@ int main (int argc, char ** argv)
 	test_lockname ();
 	test_tempname ();
 	test_checkfile ();
+	test_group ();
+	test_groupClose ();
+	test_lock ();
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+	test_inotify ();
+#endif
 
 
 	printf ("\ntest_backendhelpers RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
@@ -0,0 +1,331 @@
+/**
+ * @file
+ *
+ * @brief Change detection for the resolver with inotify
+ *
+ * A watcher thread receives the events of the directories of all
+ * watched configuration files and marks the files as dirty.
+ * kdbGet() only needs to stat() files which are dirty.
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include "resolver.h"
+
+#ifdef ELEKTRA_RESOLVER_INOTIFY
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_EVENTS                                                                                                                       \
+	(IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+typedef struct
+{
+	int fd;	/*!< the inotify instance */
+	int stop; /*!< read end of the pipe to stop the thread */
+} resolverWatcher;
+
+static pthread_mutex_t watchMutex = PTHREAD_MUTEX_INITIALIZER;
+static resolverHandle ** watchHandles = 0; // protected by watchMutex, as is wd of every handle
+static size_t watchSize = 0;
+static size_t watchAlloc = 0;
+static int watchFd = -1;
+static int watchPipe[2] = { -1, -1 };
+static int watchFailed = 0; // set if the thread stopped on error
+static pthread_t watchThread;
+
+static void watchSetDirty (resolverHandle * p)
+{
+	__atomic_store_n (&p->dirty, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Add the watch for the directory of the file
+ *
+ * @pre watchMutex is locked
+ */
+static void watchAdd (resolverHandle * p)
+{
+	char * dir = elektraStrDup (p->filename);
+	char * slash = strrchr (dir, '/');
+	if (slash == dir)
+		slash[1] = '\0';
+	else if (slash)
+		*slash = '\0';
+
+	p->wd = slash ? inotify_add_watch (watchFd, dir, WATCH_EVENTS) : -1;
+	elektraFree (dir);
+}
+
+/**
+ * @brief Process one event of the watcher
+ *
+ * @pre watchMutex is locked
+ */
+static void watchEvent (int fd, const struct inotify_event * event)
+{
+	if (event->mask & IN_Q_OVERFLOW)
+	{
+		// events got lost, so everything might have changed
+		for (size_t i = 0; i < watchSize; ++i)
+		{
+			watchSetDirty (watchHandles[i]);
+		}
+		return;
+	}
+
+	// the directory itself is gone (IN_IGNORED follows) or moved away
+	const int lost = event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT);
+	if (lost && !(event->mask & IN_IGNORED)) inotify_rm_watch (fd, event->wd);
+
+	for (size_t i = 0; i < watchSize; ++i)
+	{
+		resolverHandle * p = watchHandles[i];
+		if (p->wd != event->wd) continue;
+
+		if (lost)
+		{
+			p->wd = -1;
+			watchSetDirty (p);
+		}
+		else if (event->len && !strcmp (event->name, strrchr (p->filename, '/') + 1))
+		{
+			watchSetDirty (p);
+		}
+	}
+}
+
+static void * watchMain (void * data)
+{
+	resolverWatcher * watcher = data;
+	char buffer[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+	struct pollfd fds[2] = { { watcher->fd, POLLIN, 0 }, { watcher->stop, POLLIN, 0 } };
+
+	for (;;)
+	{
+		if (poll (fds, 2, -1) == -1)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (fds[1].revents) break;
+
+		ssize_t len = read (watcher->fd, buffer, sizeof (buffer));
+		if (len == -1)
+		{
+			if (errno == EINTR || errno == EAGAIN) continue;
+			break;
+		}
+
+		pthread_mutex_lock (&watchMutex);
+		for (char * ptr = buffer; ptr < buffer + len;)
+		{
+			const struct inotify_event * event = (const struct inotify_event *)ptr;
+			if (watcher->fd == watchFd) watchEvent (watcher->fd, event);
+			ptr += sizeof (struct inotify_event) + event->len;
+		}
+		pthread_mutex_unlock (&watchMutex);
+	}
+
+	pthread_mutex_lock (&watchMutex);
+	if (watcher->fd == watchFd && !fds[1].revents)
+	{
+		// no more events will be received, fall back to stat()
+		watchFailed = 1;
+		for (size_t i = 0; i < watchSize; ++i)
+		{
+			watchSetDirty (watchHandles[i]);
+		}
+	}
+	pthread_mutex_unlock (&watchMutex);
+	elektraFree (watcher);
+	return 0;
+}
+
+/**
+ * @brief Start the watcher thread
+ *
+ * @pre watchMutex is locked
+ *
+ * @retval 0 on success
+ * @retval -1 on error
+ */
+static int watchStart (void)
+{
+	resolverWatcher * watcher = elektraMalloc (sizeof (resolverWatcher));
+	if (!watcher) return -1;
+
+	watchFd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+	if (watchFd == -1) goto error;
+	if (pipe (watchPipe) == -1) goto error;
+
+	watcher->fd = watchFd;
+	watcher->stop = watchPipe[0];
+	watchFailed = 0;
+	if (pthread_create (&watchThread, 0, watchMain, watcher) != 0) goto error;
+	return 0;
+
+error:
+	if (watchFd != -1) close (watchFd);
+	if (watchPipe[0] != -1) close (watchPipe[0]);
+	if (watchPipe[1] != -1) close (watchPipe[1]);
+	watchFd = watchPipe[0] = watchPipe[1] = -1;
+	elektraFree (watcher);
+	return -1;
+}
+
+/**
+ * @brief Watch the file of a resolver handle for changes
+ *
+ * Until ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) is called,
+ * ELEKTRA_PLUGIN_FUNCTION (resolver, changed) tells if the file
+ * might have changed.
+ *
+ * @param p the handle with the filename to watch
+ *
+ * @retval 0 on success
+ * @retval -1 if no watcher could be started (then stat() is used)
+ */
+int ELEKTRA_PLUGIN_FUNCTION (resolver, watch) (resolverHandle * p)
+{
+	int ret = 0;
+
+	pthread_mutex_lock (&watchMutex);
+	if (watchSize == watchAlloc)
+	{
+		size_t alloc = watchAlloc ? watchAlloc * 2 : 4;
+		if (elektraRealloc ((void **)&watchHandles, alloc * sizeof (resolverHandle *)) == -1)
+		{
+			pthread_mutex_unlock (&watchMutex);
+			return -1;
+		}
+		watchAlloc = alloc;
+	}
+
+	if (watchFd == -1 && watchStart () == -1)
+	{
+		ret = -1;
+	}
+	else
+	{
+		watchHandles[watchSize++] = p;
+		p->notify = 1;
+		watchSetDirty (p);
+		watchAdd (p);
+	}
+	pthread_mutex_unlock (&watchMutex);
+
+	return ret;
+}
+
+/**
+ * @brief Stop watching the file of a resolver handle
+ *
+ * The watcher thread is stopped with the last watched file.
+ *
+ * @param p the handle passed to ELEKTRA_PLUGIN_FUNCTION (resolver, watch) before
+ */
+void ELEKTRA_PLUGIN_FUNCTION (resolver, unwatch) (resolverHandle * p)
+{
+	if (!p->notify) return;
+
+	int stopFd = -1;
+	int readFd = -1;
+	int fd = -1;
+	pthread_t thread;
+
+	pthread_mutex_lock (&watchMutex);
+	int shared = 0;
+	for (size_t i = 0; i < watchSize; ++i)
+	{
+		if (watchHandles[i] == p)
+		{
+			watchHandles[i] = watchHandles[--watchSize];
+			--i;
+		}
+		else if (p->wd != -1 && watchHandles[i]->wd == p->wd)
+		{
+			shared = 1;
+		}
+	}
+	if (p->wd != -1 && !shared) inotify_rm_watch (watchFd, p->wd);
+	p->wd = -1;
+	p->notify = 0;
+
+	if (watchSize == 0)
+	{
+		// a new watcher might be started as soon as the lock is released
+		fd = watchFd;
+		readFd = watchPipe[0];
+		stopFd = watchPipe[1];
+		thread = watchThread;
+		watchFd = watchPipe[0] = watchPipe[1] = -1;
+		elektraFree (watchHandles);
+		watchHandles = 0;
+		watchAlloc = 0;
+	}
+	pthread_mutex_unlock (&watchMutex);
+
+	if (stopFd != -1)
+	{
+		// wake up the thread and wait for it, the plugin might be unloaded afterwards
+		char stop = 0;
+		if (write (stopFd, &stop, 1) == 1) pthread_join (thread, 0);
+		close (stopFd);
+		close (readFd);
+		close (fd);
+	}
+}
+
+/**
+ * @brief Check if the file might have changed since the last call
+ *
+ * Does not need any system call if the file did not change.
+ * Otherwise the dirty flag is reset (before the caller stat()s the file)
+ * and a lost watch is added again.
+ *
+ * @param p the watched handle
+ *
+ * @retval 0 if the file did not change
+ * @retval 1 if the file might have changed
+ */
+int ELEKTRA_PLUGIN_FUNCTION (resolver, changed) (resolverHandle * p)
+{
+	if (!__atomic_load_n (&p->dirty, __ATOMIC_SEQ_CST)) return 0;
+
+	pthread_mutex_lock (&watchMutex);
+	if (!watchFailed)
+	{
+		__atomic_store_n (&p->dirty, 0, __ATOMIC_SEQ_CST);
+		if (p->wd == -1) watchAdd (p);
+		// without watch we cannot know about changes
+		if (p->wd == -1) watchSetDirty (p);
+	}
+	pthread_mutex_unlock (&watchMutex);
+	return 1;
+}
+
+/**
+ * @brief Mark all handles of this process watching a file as dirty
+ *
+ * Used after the resolver itself changed the file, so that
+ * other handles do not depend on the asynchronous event.
+ *
+ * @param filename the file which was changed
+ */
+void ELEKTRA_PLUGIN_FUNCTION (resolver, touch) (const char * filename)
+{
+	pthread_mutex_lock (&watchMutex);
+	for (size_t i = 0; i < watchSize; ++i)
+	{
+		if (!strcmp (watchHandles[i]->filename, filename)) watchSetDirty (watchHandles[i]);
+	}
+	pthread_mutex_unlock (&watchMutex);
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "name.h"
 
+#include <kdbhelper.h>
 #include <string.h>
 
 #include "iterator.h"
@@ -79,3 +80,97 @@ ssize_t elektraKeyCountEqualLevel (const Key * cmp1, const Key * cmp2)
 
 	return counter;
 }
+
+/**
+ * @brief Split the name of a key into its levels
+ *
+ * The levels point into the name of the key, so the name must
+ * not change as long as the levels are used. Storage of @p levels
+ * is reused, so splitting the names of many keys one after the
+ * other does not allocate for every key.
+ *
+ * @param levels the levels to fill, zero initialized before first use
+ * @param key the key to split the name of
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+int elektraKeyNameLevelsSet (keyNameLevels * levels, const Key * key)
+{
+	const char * name = keyName (key);
+	size_t size = 0;
+
+	levels->count = 0;
+	while (*(name = keyNameGetOneLevel (name + size, &size)))
+	{
+		if (levels->count == levels->alloc)
+		{
+			size_t alloc = levels->alloc ? levels->alloc * 2 : 16;
+			if (elektraRealloc ((void **)&levels->level, alloc * sizeof (const char *)) == -1) return -1;
+			if (elektraRealloc ((void **)&levels->size, alloc * sizeof (size_t)) == -1) return -1;
+			levels->alloc = alloc;
+		}
+		levels->level[levels->count] = name;
+		levels->size[levels->count] = size;
+		++levels->count;
+	}
+	levels->end = name;
+	return 0;
+}
+
+/**
+ * @brief Count how many levels are equal (starting from begin)
+ *
+ * Same as elektraKeyCountEqualLevel(), but for already split names.
+ *
+ * @param levels1 one name to compare
+ * @param levels2 the other name to compare
+ *
+ * @return number of equal levels
+ */
+size_t elektraKeyNameLevelsEqual (const keyNameLevels * levels1, const keyNameLevels * levels2)
+{
+	size_t counter = 0;
+	while (counter < levels1->count && counter < levels2->count && levels1->size[counter] == levels2->size[counter] &&
+	       !strncmp (levels1->level[counter], levels2->level[counter], levels1->size[counter]))
+	{
+		++counter;
+	}
+	return counter;
+}
+
+/**
+ * @brief Get one level of a split name
+ *
+ * @param levels the split name
+ * @param i the level to get, counting from 0
+ * @param size set to the size of the level
+ *
+ * @return the start of the level,
+ *         the end of the name (with @p size 0) if there are not so many levels
+ */
+const char * elektraKeyNameLevel (const keyNameLevels * levels, size_t i, size_t * size)
+{
+	if (i >= levels->count)
+	{
+		*size = 0;
+		return levels->end;
+	}
+	*size = levels->size[i];
+	return levels->level[i];
+}
+
+/**
+ * @brief Free the storage of split names
+ *
+ * @param levels the levels to free, can be reused afterwards
+ */
+void elektraKeyNameLevelsClear (keyNameLevels * levels)
+{
+	elektraFree (levels->level);
+	elektraFree (levels->size);
+	levels->level = 0;
+	levels->size = 0;
+	levels->count = 0;
+	levels->alloc = 0;
+}
@@ -11,7 +11,26 @@
 
 #include "kdb.h"
 
+/**
+ * @brief The levels of a key name, split once
+ *
+ * @see elektraKeyNameLevelsSet()
+ */
+typedef struct _keyNameLevels
+{
+	const char ** level; ///< where every level starts within the name
+	size_t * size;	     ///< size of every level
+	size_t count;	     ///< number of levels
+	size_t alloc;	     ///< allocated size of level and size
+	const char * end;    ///< the null byte at the end of the name
+} keyNameLevels;
+
 ssize_t elektraKeyCountLevel (const Key * cur);
 ssize_t elektraKeyCountEqualLevel (const Key * cmp1, const Key * cmp2);
 
+int elektraKeyNameLevelsSet (keyNameLevels * levels, const Key * key);
+size_t elektraKeyNameLevelsEqual (const keyNameLevels * levels1, const keyNameLevels * levels2);
+const char * elektraKeyNameLevel (const keyNameLevels * levels, size_t i, size_t * size);
+void elektraKeyNameLevelsClear (keyNameLevels * levels);
+
 #endif
@@ -80,22 +80,22 @@ lookahead_t elektraLookahead (const char * pnext, size_t size)
  * yields the name for the value
  *
  * @param g the generator
- * @param next the key
+ * @param next the split name of the key
  * @retval 0 no value needed afterwards
  * @retval 1 value is needed
  */
-static int elektraGenOpenValue (yajl_gen g, const Key * next)
+static int elektraGenOpenValue (yajl_gen g, const keyNameLevels * next)
 {
-	keyNameReverseIterator last = elektraKeyNameGetReverseIterator (next);
-	elektraKeyNameReverseNext (&last);
+	size_t size;
+	const char * last = elektraKeyNameLevel (next, next->count - 1, &size);
 
 	int valueNeeded = 1;
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraGenOpenValue next: \"%.*s\"\n", (int)last.size, last.current);
+	printf ("elektraGenOpenValue next: \"%.*s\"\n", (int)size, last);
 #endif
 
-	if (!strcmp (last.current, "###empty_array"))
+	if (!strcmp (last, "###empty_array"))
 	{
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("GEN empty array in value\n");
@@ -104,7 +104,7 @@ static int elektraGenOpenValue (yajl_gen g, const Key * next)
 		yajl_gen_array_close (g);
 		valueNeeded = 0;
 	}
-	else if (!strcmp (last.current, "___empty_map"))
+	else if (!strcmp (last, "___empty_map"))
 	{
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("GEN empty map in value\n");
@@ -113,12 +113,12 @@ static int elektraGenOpenValue (yajl_gen g, const Key * next)
 		yajl_gen_map_close (g);
 		valueNeeded = 0;
 	}
-	else if (last.current[0] != '#')
+	else if (last[0] != '#')
 	{
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("GEN string (L1,3)\n");
 #endif
-		yajl_gen_string (g, (const unsigned char *)last.current, last.size - 1);
+		yajl_gen_string (g, (const unsigned char *)last, size);
 	}
 
 	return valueNeeded;
@@ -138,10 +138,11 @@ static int elektraGenOpenValue (yajl_gen g, const Key * next)
  * @param g handle to generate to
  * @param parentKey needed for adding warnings/errors
  * @param cur the key to generate the value from
+ * @param curLevels the split name of cur
  */
-static void elektraGenValue (yajl_gen g, Key * parentKey, const Key * cur)
+static void elektraGenValue (yajl_gen g, Key * parentKey, const Key * cur, const keyNameLevels * curLevels)
 {
-	if (!elektraGenOpenValue (g, cur))
+	if (!elektraGenOpenValue (g, curLevels))
 	{
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("Do not yield value\n");
@@ -300,31 +301,63 @@ int elektraYajlSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 #ifdef ELEKTRA_YAJL_VERBOSE
 	printf ("parentKey: %s, cur: %s\n", keyName (parentKey), keyName (cur));
 #endif
-	elektraGenOpenInitial (g, parentKey, cur);
+
+	// every name is split once, the levels of next are reused as
+	// levels of cur in the next iteration
+	keyNameLevels levels[3];
+	memset (levels, 0, sizeof (levels));
+	keyNameLevels * parentLevels = &levels[0];
+	keyNameLevels * curLevels = &levels[1];
+	keyNameLevels * nextLevels = &levels[2];
+	int ret = elektraKeyNameLevelsSet (parentLevels, parentKey) == 0 && elektraKeyNameLevelsSet (curLevels, cur) == 0;
+
+	if (ret) elektraGenOpenInitial (g, parentLevels, curLevels);
 
 	Key * next = 0;
-	while ((next = elektraNextNotBelow (returned)) != 0)
+	while (ret && (next = elektraNextNotBelow (returned)) != 0)
 	{
-		elektraGenValue (g, parentKey, cur);
-		elektraGenClose (g, cur, next);
+		if (elektraKeyNameLevelsSet (nextLevels, next) == -1)
+		{
+			ret = 0;
+			break;
+		}
+
+		elektraGenValue (g, parentKey, cur, curLevels);
+		elektraGenClose (g, curLevels, nextLevels);
 
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("\nITERATE: %s next: %s\n", keyName (cur), keyName (next));
 #endif
-		elektraGenOpen (g, cur, next);
+		elektraGenOpen (g, curLevels, nextLevels);
 
 		cur = next;
+		keyNameLevels * swap = curLevels;
+		curLevels = nextLevels;
+		nextLevels = swap;
 	}
 
+	if (ret)
+	{
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("\nleaving loop: %s\n", keyName (cur));
+		printf ("\nleaving loop: %s\n", keyName (cur));
 #endif
 
-	elektraGenValue (g, parentKey, cur);
+		elektraGenValue (g, parentKey, cur, curLevels);
 
-	elektraGenCloseFinally (g, cur, parentKey);
+		elektraGenCloseFinally (g, curLevels, parentLevels);
 
-	int ret = elektraGenWriteFile (g, parentKey);
+		ret = elektraGenWriteFile (g, parentKey);
+	}
+	else
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "could not split key names");
+		ret = -1;
+	}
+
+	for (size_t i = 0; i < sizeof (levels) / sizeof (levels[0]); ++i)
+	{
+		elektraKeyNameLevelsClear (&levels[i]);
+	}
 	yajl_gen_free (g);
 
 	return ret;
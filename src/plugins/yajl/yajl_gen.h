@@ -52,10 +52,10 @@ typedef enum {
 
 lookahead_t elektraLookahead (const char * pnext, size_t size);
 
-void elektraGenOpenInitial (yajl_gen g, Key * parentKey, const Key * first);
-void elektraGenOpen (yajl_gen g, const Key * cur, const Key * next);
+void elektraGenOpenInitial (yajl_gen g, const keyNameLevels * parentKey, const keyNameLevels * first);
+void elektraGenOpen (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next);
 
-void elektraGenClose (yajl_gen g, const Key * cur, const Key * next);
-void elektraGenCloseFinally (yajl_gen g, const Key * cur, const Key * next);
+void elektraGenClose (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next);
+void elektraGenCloseFinally (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next);
 
 #endif
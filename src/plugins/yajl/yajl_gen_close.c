@@ -13,18 +13,18 @@
  * arrays at very last position.
  *
  * @param g generate array there
- * @param key the key to look at
+ * @param key the split name of the key to look at
  */
-static void elektraGenCloseLast (yajl_gen g, const Key * key)
+static void elektraGenCloseLast (yajl_gen g, const keyNameLevels * key)
 {
-	keyNameReverseIterator last = elektraKeyNameGetReverseIterator (key);
-	elektraKeyNameReverseNext (&last);
+	if (!key->count) return;
+	const char * last = key->level[key->count - 1];
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("last startup entry: \"%.*s\"\n", (int)last.size, last.current);
+	printf ("last startup entry: \"%s\"\n", last);
 #endif
 
-	if (last.current[0] == '#' && strcmp (last.current, "###empty_array"))
+	if (last[0] == '#' && strcmp (last, "###empty_array"))
 	{
 #ifdef ELEKTRA_YAJL_VERBOSE
 		printf ("GEN array close last\n");
@@ -67,23 +67,20 @@ static void elektraGenCloseLast (yajl_gen g, const Key * key)
  *
  *
  * @param g to yield json information
- * @param cur the key which name is used for closing
+ * @param cur the split name which is used for closing
  * @param levels the number of levels to close
  */
-static void elektraGenCloseIterate (yajl_gen g, const Key * cur, int levels)
+static void elektraGenCloseIterate (yajl_gen g, const keyNameLevels * cur, int levels)
 {
-	keyNameReverseIterator curIt = elektraKeyNameGetReverseIterator (cur);
-
-	// jump last element
-	elektraKeyNameReverseNext (&curIt);
-
 	for (int i = 0; i < levels; ++i)
 	{
-		elektraKeyNameReverseNext (&curIt);
+		// jump last element
+		size_t size;
+		const char * current = elektraKeyNameLevel (cur, cur->count - 2 - i, &size);
 
-		lookahead_t lookahead = elektraLookahead (curIt.current, curIt.size);
+		lookahead_t lookahead = elektraLookahead (current, size);
 
-		if (curIt.current[0] == '#')
+		if (current[0] == '#')
 		{
 			if (lookahead == LOOKAHEAD_MAP)
 			{
@@ -270,29 +267,24 @@ static void elektraGenCloseFirst (yajl_gen g, const char * pcur, size_t csize, c
  * [eq: 1, cur: 5, next: 5, gen: 3]
  *
  * @param g
- * @param cur
- * @param next
+ * @param cur split name of the current key
+ * @param next split name of the next key
  */
-void elektraGenClose (yajl_gen g, const Key * cur, const Key * next)
+void elektraGenClose (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next)
 {
-	int curLevels = elektraKeyCountLevel (cur);
+	int curLevels = cur->count;
 #ifdef ELEKTRA_YAJL_VERBOSE
-	int nextLevels = elektraKeyCountLevel (next);
+	int nextLevels = next->count;
 #endif
-	int equalLevels = elektraKeyCountEqualLevel (cur, next);
+	int equalLevels = elektraKeyNameLevelsEqual (cur, next);
 
 	// 1 for last level not to iterate, 1 before 1 after equal
 	int levels = curLevels - equalLevels - 2;
 
-	const char * pcur = keyName (cur);
 	size_t csize = 0;
-	const char * pnext = keyName (next);
 	size_t nsize = 0;
-	for (int i = 0; i < equalLevels + 1; ++i)
-	{
-		pcur = keyNameGetOneLevel (pcur + csize, &csize);
-		pnext = keyNameGetOneLevel (pnext + nsize, &nsize);
-	}
+	const char * pcur = elektraKeyNameLevel (cur, equalLevels, &csize);
+	const char * pnext = elektraKeyNameLevel (next, equalLevels, &nsize);
 
 #ifdef ELEKTRA_YAJL_VERBOSE
 	printf ("elektraGenClose, eq: %d, cur: %s %d, next: %s %d, "
@@ -316,29 +308,26 @@ void elektraGenClose (yajl_gen g, const Key * cur, const Key * next)
  * Will fully iterate over all elements.
  *
  * @param g handle to yield close events
- * @param cur current key
- * @param next the last key (the parentKey)
+ * @param cur split name of the current key
+ * @param next split name of the last key (the parentKey)
  */
-void elektraGenCloseFinally (yajl_gen g, const Key * cur, const Key * next)
+void elektraGenCloseFinally (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next)
 {
-	int curLevels = elektraKeyCountLevel (cur);
+	int curLevels = cur->count;
 #ifdef ELEKTRA_YAJL_VERBOSE
-	int nextLevels = elektraKeyCountLevel (next);
+	int nextLevels = next->count;
 #endif
-	int equalLevels = elektraKeyCountEqualLevel (cur, next);
+	int equalLevels = elektraKeyNameLevelsEqual (cur, next);
 
 	// 1 for last level not to iterate, 1 after equal
 	int levels = curLevels - equalLevels - 1;
 
-	const char * pcur = keyName (cur);
 	size_t csize = 0;
-	const char * pnext = keyName (next);
+	const char * pcur = elektraKeyNameLevel (cur, equalLevels, &csize);
+#ifdef ELEKTRA_YAJL_VERBOSE
 	size_t nsize = 0;
-	for (int i = 0; i < equalLevels + 1; ++i)
-	{
-		pcur = keyNameGetOneLevel (pcur + csize, &csize);
-		pnext = keyNameGetOneLevel (pnext + nsize, &nsize);
-	}
+	const char * pnext = elektraKeyNameLevel (next, equalLevels, &nsize);
+#endif
 
 #ifdef ELEKTRA_YAJL_VERBOSE
 	printf ("elektraGenFinally, eq: %d, cur: %s %d, next: %s %d, "
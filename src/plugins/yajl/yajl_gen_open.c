@@ -42,20 +42,21 @@
  * found map start, yield string + map
  *
  * @param g to yield maps, strings
- * @param pnext a pointer to the name of the key at the correct pos
+ * @param next the split name of the key
+ * @param from the first level to iterate
  * @param levels to iterate, if smaller or equal zero it does nothing
  */
-static void elektraGenOpenIterate (yajl_gen g, const char * pnext, int levels)
+static void elektraGenOpenIterate (yajl_gen g, const keyNameLevels * next, size_t from, int levels)
 {
 	size_t size = 0;
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraGenOpenIterate levels: %d,  next: \"%s\"\n", levels, pnext);
+	printf ("elektraGenOpenIterate levels: %d,  next: \"%s\"\n", levels, elektraKeyNameLevel (next, from, &size));
 #endif
 
 	for (int i = 0; i < levels; ++i)
 	{
-		pnext = keyNameGetOneLevel (pnext + size, &size);
+		const char * pnext = elektraKeyNameLevel (next, from + i, &size);
 
 		lookahead_t lookahead = elektraLookahead (pnext, size);
 
@@ -109,18 +110,18 @@ static void elektraGenOpenIterate (yajl_gen g, const char * pnext, int levels)
  * arrays at very last position.
  *
  * @param g generate array there
- * @param key the key to look at
+ * @param key the split name of the key to look at
  */
-static void elektraGenOpenLast (yajl_gen g, const Key * key)
+static void elektraGenOpenLast (yajl_gen g, const keyNameLevels * key)
 {
-	keyNameReverseIterator last = elektraKeyNameGetReverseIterator (key);
-	elektraKeyNameReverseNext (&last);
+	if (!key->count) return;
+	const char * last = key->level[key->count - 1];
 
 #ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("last startup entry: \"%.*s\"\n", (int)last.size, last.current);
+	printf ("last startup entry: \"%s\"\n", last);
 #endif
 
-	if (last.current[0] == '#' && strcmp (last.current, "###empty_array"))
+	if (last[0] == '#' && strcmp (last, "###empty_array"))
 	{
 // is an array, but not an empty one
 #ifdef ELEKTRA_YAJL_VERBOSE
@@ -147,22 +148,18 @@ static void elektraGenOpenLast (yajl_gen g, const Key * key)
  * @see elektraGenOpen
  *
  * @param g
- * @param parentKey
- * @param first
+ * @param parentKey the split name of the parent key
+ * @param first the split name of the first key
  */
-void elektraGenOpenInitial (yajl_gen g, Key * parentKey, const Key * first)
+void elektraGenOpenInitial (yajl_gen g, const keyNameLevels * parentKey, const keyNameLevels * first)
 {
-	const char * pfirst = keyName (first);
 	size_t csize = 0;
 
-	int equalLevels = elektraKeyCountEqualLevel (parentKey, first);
-	int firstLevels = elektraKeyCountLevel (first);
+	int equalLevels = elektraKeyNameLevelsEqual (parentKey, first);
+	int firstLevels = first->count;
 
 	// forward all equal levels
-	for (int i = 0; i < equalLevels + 1; ++i)
-	{
-		pfirst = keyNameGetOneLevel (pfirst + csize, &csize);
-	}
+	const char * pfirst = elektraKeyNameLevel (first, equalLevels, &csize);
 
 	// calculate levels: do not iterate over last element
 	const int levelsToOpen = firstLevels - equalLevels - 1;
@@ -187,7 +184,7 @@ void elektraGenOpenInitial (yajl_gen g, Key * parentKey, const Key * first)
 	}
 
 
-	elektraGenOpenIterate (g, pfirst, levelsToOpen);
+	elektraGenOpenIterate (g, first, equalLevels, levelsToOpen);
 
 	elektraGenOpenLast (g, first);
 }
@@ -427,33 +424,27 @@ static void elektraGenOpenFirst (yajl_gen g, const char * cur, const char * next
  * @pre cur and next have a name which is not equal
  *
  * @param g handle to generate to
- * @param cur current key of iteration
- * @param next next key of iteration
+ * @param cur split name of the current key of iteration
+ * @param next split name of the next key of iteration
  */
-void elektraGenOpen (yajl_gen g, const Key * cur, const Key * next)
+void elektraGenOpen (yajl_gen g, const keyNameLevels * cur, const keyNameLevels * next)
 {
-	const char * pcur = keyName (cur);
-	const char * pnext = keyName (next);
-	// size_t curLevels = elektraKeyCountLevel(cur);
-	size_t nextLevels = elektraKeyCountLevel (next);
+	size_t nextLevels = next->count;
 	size_t size = 0;
 	size_t csize = 0;
 
-	size_t equalLevels = elektraKeyCountEqualLevel (cur, next);
+	size_t equalLevels = elektraKeyNameLevelsEqual (cur, next);
 
 	// forward all equal levels
-	for (size_t i = 0; i < equalLevels + 1; ++i)
-	{
-		pnext = keyNameGetOneLevel (pnext + size, &size);
-		pcur = keyNameGetOneLevel (pcur + csize, &csize);
-	}
+	const char * pnext = elektraKeyNameLevel (next, equalLevels, &size);
+	const char * pcur = elektraKeyNameLevel (cur, equalLevels, &csize);
 
 	// always skip first and last level
 	const int levelsToSkip = 2;
 
 	// calculate levels which are neither already handled
 	// nor the last one
-	int levels = nextLevels - equalLevels - levelsToSkip;
+	int levels = (int)nextLevels - (int)equalLevels - levelsToSkip;
 
 	int actionRequired = equalLevels + 1 < nextLevels;
 
@@ -466,11 +457,9 @@ void elektraGenOpen (yajl_gen g, const Key * cur, const Key * next)
 	{
 		elektraGenOpenFirst (g, pcur, pnext, size);
 
-		// skip the first level we did already
-		pnext = keyNameGetOneLevel (pnext + size, &size);
-
+		// skip the first level we did already and
 		// now yield everything else in the string but the last value
-		elektraGenOpenIterate (g, pnext, levels);
+		elektraGenOpenIterate (g, next, equalLevels + 1, levels);
 
 		elektraGenOpenLast (g, next);
 	}
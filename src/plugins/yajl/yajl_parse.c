@@ -15,40 +15,122 @@
 #include <kdbconfig.h>
 #include <kdbease.h>
 #include <kdberrors.h>
+#include <kdbproposal.h>
 #include <yajl/yajl_parse.h>
 
 
 /**
- @retval 0 if ksCurrent does not hold an array entry
+ * @brief The state while parsing one file
+ *
+ * All keys are collected by a builder and sorted once after
+ * parsing. The keys of the maps and arrays not closed yet are kept
+ * on a stack, so the keys parsed so far never need to be looked up.
+ *
+ * A key is passed to the builder when it is not current anymore,
+ * so a marker for an empty map or array can still be dropped.
+ */
+typedef struct
+{
+	ElektraKsBuilder * builder; ///< collects all parsed keys
+	ElektraArena * arena;	    ///< all parsed keys are allocated from
+	Key * current;		    ///< the key which gets the next value, not added yet
+	Key ** parents;		    ///< the keys of the maps and arrays not closed yet, not added yet
+	size_t size;		    ///< number of parents
+	size_t alloc;		    ///< allocated size of parents
+	int error;		    ///< if memory could not be allocated
+} yajlParseContext;
+
+/**
+ * @brief Pass the current key to the builder
+ *
+ * @param ctx the parse context
+ *
+ * @retval 1 on success
+ * @retval 0 on memory error
+ */
+static int elektraYajlAddCurrent (yajlParseContext * ctx)
+{
+	Key * current = ctx->current;
+	ctx->current = 0;
+	if (elektraKsBuilderAdd (ctx->builder, current) == -1)
+	{
+		ctx->error = 1;
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Make key the current key
+ *
+ * The previous current key is added, unless its basename is @p marker.
+ * Then it was a marker for an empty map or array which is not empty.
+ *
+ * @param ctx the parse context
+ * @param key the new current key
+ * @param marker the basename of the previous current key to drop (or NULL)
+ *
+ * @retval 1 on success
+ * @retval 0 on memory error
+ */
+static int elektraYajlSetCurrent (yajlParseContext * ctx, Key * key, const char * marker)
+{
+	if (ctx->current && marker && !strcmp (keyBaseName (ctx->current), marker))
+	{
+		keyDel (ctx->current);
+		ctx->current = 0;
+	}
+	else if (ctx->current && !elektraYajlAddCurrent (ctx))
+	{
+		keyDel (key);
+		return 0;
+	}
+
+	ctx->current = key;
+	if (!key)
+	{
+		ctx->error = 1;
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ @retval 0 if current does not hold an array entry
  @retval 1 if the array entry will be used because its the first
  @retval 2 if a new array entry was created
- @retval -1 error in snprintf
+ @retval -1 on memory error
  */
-static int elektraYajlIncrementArrayEntry (KeySet * ks)
+static int elektraYajlIncrementArrayEntry (yajlParseContext * ctx)
 {
-	Key * current = ksCurrent (ks);
+	Key * current = ctx->current;
 	const char * baseName = keyBaseName (current);
 
 	if (baseName && *baseName == '#')
 	{
-		current = keyNew (keyName (current), KEY_END);
+		current = elektraArenaKeyNew (ctx->arena, keyName (current), KEY_END);
+		if (!current)
+		{
+			ctx->error = 1;
+			return -1;
+		}
+
+		int ret;
 		if (!strcmp (baseName, "###empty_array"))
 		{
-			// get rid of previous key
-			keyDel (ksLookup (ks, current, KDB_O_POP));
 			// we have a new array entry
 			keySetBaseName (current, 0);
 			keyAddName (current, "#0");
-			ksAppendKey (ks, current);
-			return 1;
+			ret = 1;
 		}
 		else
 		{
 			// we are in an array
 			elektraArrayIncName (current);
-			ksAppendKey (ks, current);
-			return 2;
+			ret = 2;
 		}
+		// get rid of the marker for the empty array
+		return elektraYajlSetCurrent (ctx, current, "###empty_array") ? ret : -1;
 	}
 	else
 	{
@@ -57,12 +139,53 @@ static int elektraYajlIncrementArrayEntry (KeySet * ks)
 	}
 }
 
+/**
+ * @brief Enter a map or array with the current key
+ *
+ * @param ctx the parse context
+ * @param name the marker for the empty map or array
+ *
+ * @retval 1 on success
+ * @retval 0 on memory error
+ */
+static int elektraYajlPushParent (yajlParseContext * ctx, const char * name)
+{
+	if (elektraYajlIncrementArrayEntry (ctx) == -1) return 0;
+
+	if (ctx->size == ctx->alloc)
+	{
+		size_t alloc = ctx->alloc ? ctx->alloc * 2 : 16;
+		if (elektraRealloc ((void **)&ctx->parents, alloc * sizeof (Key *)) == -1)
+		{
+			ctx->error = 1;
+			return 0;
+		}
+		ctx->alloc = alloc;
+	}
+
+	Key * newKey = elektraArenaKeyNew (ctx->arena, keyName (ctx->current), KEY_END);
+	if (!newKey)
+	{
+		ctx->error = 1;
+		return 0;
+	}
+	// add a pseudo element for empty map or array
+	keyAddName (newKey, name);
+
+#ifdef ELEKTRA_YAJL_VERBOSE
+	printf ("elektraYajlPushParent with new key %s\n", keyName (newKey));
+#endif
+
+	ctx->parents[ctx->size++] = ctx->current;
+	ctx->current = newKey;
+	return 1;
+}
+
 static int elektraYajlParseNull (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	if (elektraYajlIncrementArrayEntry (ctx) == -1) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = ((yajlParseContext *)ctx)->current;
 
 	keySetBinary (current, NULL, 0);
 
@@ -75,10 +198,9 @@ static int elektraYajlParseNull (void * ctx)
 
 static int elektraYajlParseBoolean (void * ctx, int boolean)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	if (elektraYajlIncrementArrayEntry (ctx) == -1) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = ((yajlParseContext *)ctx)->current;
 
 	if (boolean == 1)
 	{
@@ -99,10 +221,9 @@ static int elektraYajlParseBoolean (void * ctx, int boolean)
 
 static int elektraYajlParseNumber (void * ctx, const char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	if (elektraYajlIncrementArrayEntry (ctx) == -1) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = ((yajlParseContext *)ctx)->current;
 
 	unsigned char delim = stringVal[stringLen];
 	char * stringValue = (char *)stringVal;
@@ -123,10 +244,9 @@ static int elektraYajlParseNumber (void * ctx, const char * stringVal, yajl_size
 
 static int elektraYajlParseString (void * ctx, const unsigned char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	if (elektraYajlIncrementArrayEntry (ctx) == -1) return 0;
 
-	Key * current = ksCurrent (ks);
+	Key * current = ((yajlParseContext *)ctx)->current;
 
 	unsigned char delim = stringVal[stringLen];
 	char * stringValue = (char *)stringVal;
@@ -145,10 +265,15 @@ static int elektraYajlParseString (void * ctx, const unsigned char * stringVal,
 
 static int elektraYajlParseMapKey (void * ctx, const unsigned char * stringVal, yajl_size_type stringLen)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
+	yajlParseContext * context = ctx;
+	if (elektraYajlIncrementArrayEntry (context) == -1) return 0;
 
-	Key * currentKey = keyNew (keyName (ksCurrent (ks)), KEY_END);
+	Key * currentKey = elektraArenaKeyNew (context->arena, keyName (context->current), KEY_END);
+	if (!currentKey)
+	{
+		context->error = 1;
+		return 0;
+	}
 	keySetString (currentKey, 0);
 
 	unsigned char delim = stringVal[stringLen];
@@ -158,91 +283,61 @@ static int elektraYajlParseMapKey (void * ctx, const unsigned char * stringVal,
 #ifdef ELEKTRA_YAJL_VERBOSE
 	printf ("elektraYajlParseMapKey stringValue: %s currentKey: %s\n", stringValue, keyName (currentKey));
 #endif
-	if (currentKey && !strcmp (keyBaseName (currentKey), "___empty_map"))
-	{
-		// remove old key
-		keyDel (ksLookup (ks, currentKey, KDB_O_POP));
-		// now we know the name of the object
-		keySetBaseName (currentKey, stringValue);
-	}
-	else
-	{
-		// we entered a new pair (inside the previous object)
-		keySetBaseName (currentKey, stringValue);
-	}
-	ksAppendKey (ks, currentKey);
+	// we entered a new pair (inside the previous object)
+	keySetBaseName (currentKey, stringValue);
 
 	// restore old character in buffer
 	stringValue[stringLen] = delim;
 
-	return 1;
+	// get rid of the marker for the empty map
+	return elektraYajlSetCurrent (context, currentKey, "___empty_map");
 }
 
 static int elektraYajlParseStartMap (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
-
-	Key * currentKey = ksCurrent (ks);
-
-	Key * newKey = keyNew (keyName (currentKey), KEY_END);
-	// add a pseudo element for empty map
-	keyAddBaseName (newKey, "___empty_map");
-	ksAppendKey (ks, newKey);
-
-#ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraYajlParseStartMap with new key %s\n", keyName (newKey));
-#endif
-
-	return 1;
+	return elektraYajlPushParent (ctx, "___empty_map");
 }
 
 static int elektraYajlParseEnd (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	Key * currentKey = ksCurrent (ks);
-
-	Key * lookupKey = keyNew (keyName (currentKey), KEY_END);
-	keySetBaseName (lookupKey, 0); // remove current baseName
+	yajlParseContext * context = ctx;
 
 	// lets point current to the correct place
-	Key * foundKey = ksLookup (ks, lookupKey, 0);
-
-#ifdef ELEKTRA_YAJL_VERBOSE
-	if (foundKey)
-	{
-		printf ("elektraYajlParseEnd %s\n", keyName (foundKey));
-	}
-	else
+	if (context->size > 0)
 	{
-		printf ("elektraYajlParseEnd did not find key!\n");
+		if (!elektraYajlAddCurrent (context)) return 0;
+		context->current = context->parents[--context->size];
 	}
-#else
-	(void)foundKey; // foundKey is not used, but lookup is needed
-#endif
 
-	keyDel (lookupKey);
+#ifdef ELEKTRA_YAJL_VERBOSE
+	printf ("elektraYajlParseEnd %s\n", keyName (context->current));
+#endif
 
 	return 1;
 }
 
 static int elektraYajlParseStartArray (void * ctx)
 {
-	KeySet * ks = (KeySet *)ctx;
-	elektraYajlIncrementArrayEntry (ks);
-
-	Key * currentKey = ksCurrent (ks);
-
-	Key * newKey = keyNew (keyName (currentKey), KEY_END);
-	// add a pseudo element for empty array
-	keyAddName (newKey, "###empty_array");
-	ksAppendKey (ks, newKey);
-
-#ifdef ELEKTRA_YAJL_VERBOSE
-	printf ("elektraYajlParseStartArray with new key %s\n", keyName (newKey));
-#endif
+	return elektraYajlPushParent (ctx, "###empty_array");
+}
 
-	return 1;
+/**
+ * @brief Free everything of the parse context
+ *
+ * Keys which were not passed to a key set are deleted.
+ *
+ * @param ctx the parse context
+ */
+static void elektraYajlParseContextFree (yajlParseContext * ctx)
+{
+	keyDel (ctx->current);
+	while (ctx->size > 0)
+	{
+		keyDel (ctx->parents[--ctx->size]);
+	}
+	elektraKsBuilderDel (ctx->builder);
+	elektraArenaDel (ctx->arena);
+	elektraFree (ctx->parents);
 }
 
 /**
@@ -320,13 +415,22 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 				     elektraYajlParseStartArray,
 				     elektraYajlParseEnd };
 
-	ksAppendKey (returned, keyNew (keyName ((parentKey)), KEY_END));
+	yajlParseContext ctx;
+	memset (&ctx, 0, sizeof (ctx));
+	ctx.builder = elektraKsBuilderNew (0);
+	ctx.arena = elektraArenaNew (0);
+	if (!ctx.builder || !ctx.arena || !elektraYajlSetCurrent (&ctx, elektraArenaKeyNew (ctx.arena, keyName (parentKey), KEY_END), 0))
+	{
+		elektraYajlParseContextFree (&ctx);
+		ELEKTRA_SET_ERROR (87, parentKey, "could not start parsing");
+		return -1;
+	}
 
 #if YAJL_MAJOR == 1
 	yajl_parser_config cfg = { 1, 1 };
-	yajl_handle hand = yajl_alloc (&callbacks, &cfg, NULL, returned);
+	yajl_handle hand = yajl_alloc (&callbacks, &cfg, NULL, &ctx);
 #else
-	yajl_handle hand = yajl_alloc (&callbacks, NULL, returned);
+	yajl_handle hand = yajl_alloc (&callbacks, NULL, &ctx);
 	yajl_config (hand, yajl_allow_comments, 1);
 #endif
 
@@ -337,6 +441,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 	if (!fileHandle)
 	{
 		yajl_free (hand);
+		elektraYajlParseContextFree (&ctx);
 		ELEKTRA_SET_ERROR_GET (parentKey);
 		errno = errnosave;
 		return -1;
@@ -352,6 +457,7 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 				ELEKTRA_SET_ERROR (76, parentKey, keyString (parentKey));
 				fclose (fileHandle);
 				yajl_free (hand);
+				elektraYajlParseContextFree (&ctx);
 				return -1;
 			}
 			done = 1;
@@ -375,13 +481,21 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 #if YAJL_MAJOR == 1
 		test_status = test_status && (stat != yajl_status_insufficient_data);
 #endif
-		if (test_status)
+		if (test_status && ctx.error)
+		{
+			ELEKTRA_SET_ERROR (87, parentKey, "could not create keys");
+		}
+		else if (test_status)
 		{
 			unsigned char * str = yajl_get_error (hand, 1, fileData, rd);
 			ELEKTRA_SET_ERROR (77, parentKey, (char *)str);
 			yajl_free_error (hand, str);
+		}
+		if (test_status)
+		{
 			yajl_free (hand);
 			fclose (fileHandle);
+			elektraYajlParseContextFree (&ctx);
 
 			return -1;
 		}
@@ -389,6 +503,16 @@ int elektraYajlGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned, Key * par
 
 	yajl_free (hand);
 	fclose (fileHandle);
+
+	// all keys are sorted at once
+	int ret = -1;
+	if (ctx.size == 0 && elektraYajlAddCurrent (&ctx)) ret = elektraKsBuilderFinish (ctx.builder, returned);
+	elektraYajlParseContextFree (&ctx);
+	if (ret == -1)
+	{
+		ELEKTRA_SET_ERROR (87, parentKey, "could not add keys");
+		return -1;
+	}
 	elektraYajlParseSuppressEmpty (returned, parentKey);
 
 	return 1; /* success */
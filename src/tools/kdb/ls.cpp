@@ -21,6 +21,19 @@ LsCommand::LsCommand () : kdb (root)
 {
 }
 
+template <typename Keys>
+static void printKeys (Cmdline const & cl, Keys const & part)
+{
+	if (cl.verbose) cout << "size of requested keys: " << part.size () << endl;
+	cout.setf (std::ios_base::unitbuf);
+	if (cl.null)
+	{
+		cout.unsetf (std::ios_base::skipws);
+	}
+
+	cout << part;
+}
+
 int LsCommand::execute (Cmdline const & cl)
 {
 	if (cl.arguments.size () != 1)
@@ -36,16 +49,15 @@ int LsCommand::execute (Cmdline const & cl)
 
 	if (cl.verbose) cout << "size of all keys in mountpoint: " << ks.size () << endl;
 
-	KeySet part (ks.cut (root));
-
-	if (cl.verbose) cout << "size of requested keys: " << part.size () << endl;
-	cout.setf (std::ios_base::unitbuf);
-	if (cl.null)
+	if (root.getName ()[0] == '/')
 	{
-		cout.unsetf (std::ios_base::skipws);
+		// a view only covers a single namespace
+		printKeys (cl, ks.cut (root));
+	}
+	else
+	{
+		printKeys (cl, KeySetView (ks, root));
 	}
-
-	cout << part;
 
 	printWarnings (cerr, root);
 
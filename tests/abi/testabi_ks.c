@@ -3158,6 +3158,51 @@ static void test_ksAppend2 ()
 	ksDel (ks);
 }
 
+static void test_ksAppendMerge ()
+{
+	printf ("Test appending interleaved keysets\n");
+
+	Key * a = keyNew ("user/a", KEY_VALUE, "a", KEY_END);
+	Key * c = keyNew ("user/c", KEY_VALUE, "c", KEY_END);
+	Key * e = keyNew ("user/e", KEY_VALUE, "e", KEY_END);
+	Key * b = keyNew ("user/b", KEY_VALUE, "b", KEY_END);
+	Key * c2 = keyNew ("user/c", KEY_VALUE, "c2", KEY_END);
+	Key * f = keyNew ("user/f", KEY_VALUE, "f", KEY_END);
+
+	KeySet * ks = ksNew (3, a, c, e, KS_END);
+	KeySet * other = ksNew (4, b, c2, e, f, KS_END);
+	keyIncRef (c);
+
+	succeed_if (ksAppend (ks, other) == 5, "size not correct");
+	succeed_if (ksCurrent (ks) == f, "cursor should be at last appended key");
+	succeed_if (keyGetRef (c) == 1, "replaced key should be released");
+	succeed_if (keyGetRef (c2) == 2, "ref of appended key wrong");
+	succeed_if (keyGetRef (e) == 2, "ref of key in both keysets wrong");
+
+	ksRewind (ks);
+	succeed_if (ksNext (ks) == a, "wrong order");
+	succeed_if (ksNext (ks) == b, "wrong order");
+	succeed_if (ksNext (ks) == c2, "c should be replaced");
+	succeed_if (ksNext (ks) == e, "wrong order");
+	succeed_if (ksNext (ks) == f, "wrong order");
+	succeed_if (ksNext (ks) == 0, "too many keys");
+
+	succeed_if (ksAppend (ks, ks) == 5, "appending to itself should not change anything");
+	ksDel (other);
+	succeed_if (keyGetRef (e) == 1, "ref wrong");
+
+	KeySet * front = ksNew (2, keyNew ("system/a", KEY_END), keyNew ("dir/a", KEY_END), KS_END);
+	succeed_if (ksAppend (ks, front) == 7, "size not correct");
+	succeed_if_same_string (keyName (ksHead (ks)), "dir/a");
+	succeed_if_same_string (keyName (ksCurrent (ks)), "system/a");
+	succeed_if (ksTail (ks) == f, "tail should stay");
+	ksDel (front);
+
+	keyDecRef (c);
+	keyDel (c);
+	ksDel (ks);
+}
+
 
 int main (int argc, char ** argv)
 {
@@ -3208,6 +3253,7 @@ int main (int argc, char ** argv)
 	test_simpleLookup ();
 	test_nsLookup ();
 	test_ksAppend2 ();
+	test_ksAppendMerge ();
 
 	// BUGS:
 	// test_ksLookupValue();
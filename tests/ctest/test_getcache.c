@@ -0,0 +1,531 @@
+/**
+ * @file
+ *
+ * @brief Tests for the cache of parsed keys within kdbGet() and kdbOpen()
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <tests_internal.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <kdberrors.h>
+
+static char * cacheDir;
+static char * cacheFile;
+static int storageCalls;
+static int postCalls;
+
+static int cacheResolverGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey)
+{
+	keySetString (parentKey, cacheFile);
+	return 1;
+}
+
+static int cacheResolverSet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey)
+{
+	keySetString (parentKey, cacheFile);
+	return 1;
+}
+
+/**
+ * Returns the content of the file and some other keys,
+ * warns depending on the name of the mountpoint.
+ *
+ * The plugin "stateful" remembers that it parsed the file
+ * and is not cacheable, all others are.
+ */
+static int cacheStorageGet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	if (!strncmp (keyName (parentKey), "system/elektra/modules/", sizeof ("system/elektra/modules/") - 1))
+	{
+		if (strcmp (handle->name, "stateful"))
+		{
+			Key * k = keyDup (parentKey);
+			keyAddName (k, "infos/cacheable");
+			keySetString (k, "1");
+			ksAppendKey (returned, k);
+		}
+		return 1;
+	}
+
+	++storageCalls;
+	if (!strcmp (handle->name, "stateful")) elektraPluginSetData (handle, cacheFile);
+
+	char content[100] = "";
+	FILE * f = fopen (keyString (parentKey), "r");
+	if (f)
+	{
+		if (!fgets (content, sizeof (content), f)) content[0] = '\0';
+		fclose (f);
+	}
+
+	Key * k = keyDup (parentKey);
+	keySetString (k, content);
+	keySetMeta (k, "comment", "the content");
+	keySetMeta (k, "order", "1");
+	ksAppendKey (returned, k);
+
+	k = keyDup (parentKey);
+	keyAddBaseName (k, "binary");
+	keySetBinary (k, "\0\1\2", 3);
+	ksAppendKey (returned, k);
+
+	k = keyDup (parentKey);
+	keyAddBaseName (k, "null");
+	keySetBinary (k, 0, 0);
+	ksAppendKey (returned, k);
+
+	k = keyNew (keyName (parentKey), KEY_END);
+	keyAddBaseName (k, "section");
+	ksAppendKey (returned, k);
+
+	k = keyDup (parentKey);
+	keyAddBaseName (k, "empty");
+	keySetString (k, "");
+	ksAppendKey (returned, k);
+
+	if (strstr (keyName (parentKey), "warn"))
+	{
+		ELEKTRA_ADD_WARNING (105, parentKey, "parsed with warning");
+	}
+	return 1;
+}
+
+/**
+ * Writes the value of the parent, the plugin "stateful"
+ * fails without the state of its kdbGet().
+ */
+static int cacheStorageSet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	if (!strcmp (handle->name, "stateful") && !elektraPluginGetData (handle))
+	{
+		ELEKTRA_SET_ERROR (75, parentKey, "state of kdbGet() missing");
+		return -1;
+	}
+
+	Key * k = ksLookupByName (returned, keyName (parentKey), 0);
+	FILE * f = fopen (keyString (parentKey), "w");
+	if (!f) return -1;
+	if (k) fputs (keyString (k), f);
+	fclose (f);
+	return 1;
+}
+
+static int cachePostGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey ELEKTRA_UNUSED)
+{
+	++postCalls;
+	return 1;
+}
+
+static Plugin * cachePlugin (const char * name, kdbGetPtr get, kdbSetPtr set)
+{
+	Plugin * plugin = elektraPluginExport (name, ELEKTRA_PLUGIN_GET, get, ELEKTRA_PLUGIN_SET, set, ELEKTRA_PLUGIN_END);
+	plugin->config = ksNew (1, keyNew ("user/format", KEY_VALUE, name, KEY_END), KS_END);
+	plugin->refcounter = 1;
+	return plugin;
+}
+
+static KDB * cacheOpen (const char * mountpoint, const char * storage, int cache)
+{
+	KDB * handle = elektraCalloc (sizeof (struct _KDB));
+	handle->split = elektraSplitNew ();
+	if (cache) handle->cache = elektraStrDup (cacheDir);
+
+	Backend * backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (mountpoint, KEY_VALUE, mountpoint, KEY_END);
+	keyIncRef (backend->mountpoint);
+	backend->getplugins[RESOLVER_PLUGIN] = cachePlugin ("resolver", cacheResolverGet, cacheResolverSet);
+	backend->getplugins[STORAGE_PLUGIN] = cachePlugin (storage, cacheStorageGet, cacheStorageSet);
+	backend->getplugins[STORAGE_PLUGIN + 1] = cachePlugin ("post", cachePostGet, 0);
+	backend->setplugins[RESOLVER_PLUGIN] = backend->getplugins[RESOLVER_PLUGIN];
+	backend->setplugins[STORAGE_PLUGIN] = backend->getplugins[STORAGE_PLUGIN];
+	backend->setplugins[COMMIT_PLUGIN] = backend->getplugins[RESOLVER_PLUGIN];
+	backend->getplugins[RESOLVER_PLUGIN]->refcounter = 3;
+	backend->getplugins[STORAGE_PLUGIN]->refcounter = 2;
+	elektraMountBackend (handle, backend, 0);
+	return handle;
+}
+
+static KeySet * cacheGet (const char * mountpoint, const char * storage, int cache)
+{
+	KDB * handle = cacheOpen (mountpoint, storage, cache);
+	Key * parentKey = keyNew (mountpoint, KEY_END);
+	KeySet * ks = ksNew (0, KS_END);
+	succeed_if (kdbGet (handle, ks, parentKey) == 1, "kdbGet failed");
+	kdbClose (handle, parentKey);
+	keyDel (parentKey);
+	return ks;
+}
+
+static void cacheWriteFile (const char * content)
+{
+	FILE * f = fopen (cacheFile, "w");
+	exit_if_fail (f, "could not write configuration file");
+	fputs (content, f);
+	fclose (f);
+}
+
+static void cacheClear (void)
+{
+	DIR * dir = opendir (cacheDir);
+	if (!dir) return;
+	struct dirent * entry;
+	char name[1024];
+	while ((entry = readdir (dir)) != 0)
+	{
+		if (entry->d_name[0] == '.') continue;
+		snprintf (name, sizeof (name), "%s/%s", cacheDir, entry->d_name);
+		unlink (name);
+	}
+	closedir (dir);
+}
+
+static void cacheCorrupt (void)
+{
+	DIR * dir = opendir (cacheDir);
+	exit_if_fail (dir, "no cache directory");
+	struct dirent * entry;
+	char name[1024];
+	while ((entry = readdir (dir)) != 0)
+	{
+		if (entry->d_name[0] == '.') continue;
+		snprintf (name, sizeof (name), "%s/%s", cacheDir, entry->d_name);
+		struct stat buf;
+		succeed_if (stat (name, &buf) == 0, "could not stat cache file");
+		succeed_if (truncate (name, buf.st_size - 5) == 0, "could not truncate cache file");
+	}
+	closedir (dir);
+}
+
+static void test_hit ()
+{
+	printf ("Test kdbGet with cache\n");
+
+	cacheWriteFile ("value");
+	storageCalls = postCalls = 0;
+
+	KeySet * parsed = cacheGet ("user/tests/cache", "storage", 1);
+	succeed_if (storageCalls == 1, "storage not called without cache");
+	succeed_if (postCalls == 1, "post storage plugin not called");
+	succeed_if_same_string (keyString (ksLookupByName (parsed, "user/tests/cache", 0)), "value");
+	succeed_if (ksGetSize (parsed) == 5, "wrong number of keys");
+
+	KeySet * cached = cacheGet ("user/tests/cache", "storage", 1);
+	succeed_if (storageCalls == 1, "storage called although file did not change");
+	succeed_if (postCalls == 2, "post storage plugin not called with cache");
+	compare_keyset (parsed, cached);
+
+	Key * null = ksLookupByName (cached, "user/tests/cache/null", 0);
+	succeed_if (null && keyIsBinary (null) && keyValue (null) == 0, "null binary key not restored");
+	Key * section = ksLookupByName (cached, "user/tests/cache/section", 0);
+	succeed_if (section && section->data.v == 0, "key without value not restored");
+
+	ksDel (parsed);
+	ksDel (cached);
+}
+
+static void test_changed ()
+{
+	printf ("Test kdbGet with changed file\n");
+
+	cacheWriteFile ("value");
+	storageCalls = 0;
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	succeed_if (storageCalls <= 1, "cache not used");
+
+	cacheWriteFile ("other value");
+	storageCalls = 0;
+	KeySet * ks = cacheGet ("user/tests/cache", "storage", 1);
+	succeed_if (storageCalls == 1, "changed file not parsed");
+	succeed_if_same_string (keyString (ksLookupByName (ks, "user/tests/cache", 0)), "other value");
+	ksDel (ks);
+
+	storageCalls = 0;
+	ks = cacheGet ("user/tests/cache", "other", 1);
+	succeed_if (storageCalls == 1, "cache of other plugin used");
+	ksDel (ks);
+
+	storageCalls = 0;
+	ks = cacheGet ("user/tests/cache", "storage", 0);
+	succeed_if (storageCalls == 1, "cache used although disabled");
+	ksDel (ks);
+}
+
+static void test_corrupt ()
+{
+	printf ("Test kdbGet with corrupt cache\n");
+
+	cacheWriteFile ("value");
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	cacheCorrupt ();
+
+	storageCalls = 0;
+	KeySet * ks = cacheGet ("user/tests/cache", "storage", 1);
+	succeed_if (storageCalls == 1, "corrupt cache used");
+	succeed_if_same_string (keyString (ksLookupByName (ks, "user/tests/cache", 0)), "value");
+	succeed_if (ksGetSize (ks) == 5, "wrong number of keys");
+	ksDel (ks);
+
+	storageCalls = 0;
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	succeed_if (storageCalls == 0, "cache not rewritten");
+}
+
+static void test_warnings ()
+{
+	printf ("Test kdbGet with warnings\n");
+
+	cacheWriteFile ("value");
+	storageCalls = 0;
+
+	ksDel (cacheGet ("user/tests/cache/warn", "storage", 1));
+	ksDel (cacheGet ("user/tests/cache/warn", "storage", 1));
+	succeed_if (storageCalls == 2, "result with warnings was cached");
+}
+
+static void test_set (const char * storage, int expectedCalls)
+{
+	printf ("Test kdbSet after kdbGet with cache and storage %s\n", storage);
+
+	cacheWriteFile ("value");
+	storageCalls = 0;
+	ksDel (cacheGet ("user/tests/cache", storage, 1));
+
+	KDB * handle = cacheOpen ("user/tests/cache", storage, 1);
+	Key * parentKey = keyNew ("user/tests/cache", KEY_END);
+	KeySet * ks = ksNew (0, KS_END);
+	succeed_if (kdbGet (handle, ks, parentKey) == 1, "kdbGet failed");
+	succeed_if (storageCalls == expectedCalls, "storage plugin called wrong number of times");
+
+	keySetString (ksLookupByName (ks, "user/tests/cache", 0), "changed");
+	succeed_if (kdbSet (handle, ks, parentKey) == 1, "kdbSet after kdbGet failed");
+	succeed_if (!keyGetMeta (parentKey, "error"), "kdbSet set an error");
+	kdbClose (handle, parentKey);
+	keyDel (parentKey);
+	ksDel (ks);
+
+	ks = cacheGet ("user/tests/cache", storage, 1);
+	succeed_if_same_string (keyString (ksLookupByName (ks, "user/tests/cache", 0)), "changed");
+	ksDel (ks);
+}
+
+/**
+ * Sets system/elektra/threads and system/elektra/cache in the
+ * bootstrap configuration, NULL values remove the keys.
+ *
+ * @return the bootstrap file
+ * @retval 0 if the bootstrap configuration cannot be written
+ */
+static char * bootstrapWrite (const char * threads, const char * cache)
+{
+	Key * parentKey = keyNew (KDB_SYSTEM_ELEKTRA, KEY_END);
+	KDB * handle = kdbOpen (parentKey);
+	KeySet * ks = ksNew (0, KS_END);
+	char * file = 0;
+
+	if (handle && kdbGet (handle, ks, parentKey) != -1)
+	{
+		file = elektraStrDup (keyString (parentKey));
+		const char * names[] = { KDB_SYSTEM_ELEKTRA "/threads", KDB_SYSTEM_ELEKTRA "/cache" };
+		const char * values[] = { threads, cache };
+		for (size_t i = 0; i < 2; ++i)
+		{
+			if (values[i])
+				ksAppendKey (ks, keyNew (names[i], KEY_VALUE, values[i], KEY_END));
+			else
+				keyDel (ksLookupByName (ks, names[i], KDB_O_POP));
+		}
+		if (kdbSet (handle, ks, parentKey) == -1)
+		{
+			elektraFree (file);
+			file = 0;
+		}
+	}
+
+	ksDel (ks);
+	kdbClose (handle, parentKey);
+	keyDel (parentKey);
+	return file;
+}
+
+/**
+ * @return the number of threads kdbOpen() read from the bootstrap configuration
+ */
+static size_t bootstrapThreads (void)
+{
+	Key * errorKey = keyNew ("", KEY_END);
+	KDB * handle = kdbOpen (errorKey);
+	exit_if_fail (handle, "kdbOpen failed");
+	size_t threads = handle->threads;
+	kdbClose (handle, errorKey);
+	keyDel (errorKey);
+	return threads;
+}
+
+/**
+ * Changes the number of threads within @p file from 2 to 3 in place,
+ * the file keeps its inode, size and modification time.
+ */
+static void bootstrapChange (const char * file)
+{
+	struct stat buf;
+	exit_if_fail (stat (file, &buf) == 0, "could not stat bootstrap file");
+
+	char * content = elektraMalloc (buf.st_size);
+	FILE * f = fopen (file, "r+b");
+	exit_if_fail (f && fread (content, 1, buf.st_size, f) == (size_t)buf.st_size, "could not read bootstrap file");
+
+	// the dump format stores the name and then the value
+	const char name[] = KDB_SYSTEM_ELEKTRA "/threads";
+	off_t found = -1;
+	for (off_t i = 0; found == -1 && i + (off_t)sizeof (name) < buf.st_size; ++i)
+	{
+		if (!memcmp (content + i, name, sizeof (name)) && content[i + sizeof (name)] == '2') found = i + sizeof (name);
+	}
+	exit_if_fail (found != -1, "number of threads not found in bootstrap file");
+
+	succeed_if (fseek (f, found, SEEK_SET) == 0 && fputc ('3', f) == '3', "could not change bootstrap file");
+	fclose (f);
+	elektraFree (content);
+
+	struct timespec times[2] = { buf.st_atim, buf.st_mtim };
+	succeed_if (utimensat (AT_FDCWD, file, times, 0) == 0, "could not set modification time");
+}
+
+static void bootstrapTouch (const char * file)
+{
+	struct stat buf;
+	exit_if_fail (stat (file, &buf) == 0, "could not stat bootstrap file");
+	struct timespec times[2] = { buf.st_atim, buf.st_mtim };
+	++times[1].tv_sec;
+	succeed_if (utimensat (AT_FDCWD, file, times, 0) == 0, "could not set modification time");
+}
+
+static void test_bootstrap ()
+{
+	printf ("Test cache of bootstrap configuration\n");
+
+	size_t size = tempHomeLen + sizeof ("/" KDB_DB_CACHE);
+	char * dir = elektraMalloc (size);
+	snprintf (dir, size, "%s/" KDB_DB_CACHE, tempHome);
+	struct stat buf;
+
+	// keep the bootstrap configuration of the system
+	Key * parentKey = keyNew (KDB_SYSTEM_ELEKTRA, KEY_END);
+	KDB * handle = kdbOpen (parentKey);
+	KeySet * original = ksNew (0, KS_END);
+	if (handle) kdbGet (handle, original, parentKey);
+	kdbClose (handle, parentKey);
+	keyDel (parentKey);
+	Key * threads = ksLookupByName (original, KDB_SYSTEM_ELEKTRA "/threads", 0);
+	Key * cache = ksLookupByName (original, KDB_SYSTEM_ELEKTRA "/cache", 0);
+
+	// without system/elektra/cache nothing is written
+	char * file = bootstrapWrite ("2", 0);
+	if (!file)
+	{
+		printf ("bootstrap configuration not writeable, skipped\n");
+		ksDel (original);
+		elektraFree (dir);
+		return;
+	}
+	succeed_if (bootstrapThreads () == 2, "bootstrap configuration not read");
+	succeed_if (bootstrapThreads () == 2, "bootstrap configuration not read");
+	succeed_if (stat (dir, &buf) == -1, "cache directory created without opt-in");
+
+	// miss, then hit
+	elektraFree (bootstrapWrite ("2", cacheDir));
+	succeed_if (bootstrapThreads () == 2, "bootstrap configuration not read");
+	succeed_if (stat (dir, &buf) == 0, "cache directory not created");
+	bootstrapChange (file);
+	succeed_if (bootstrapThreads () == 2, "bootstrap configuration not read from cache");
+
+	// a changed modification time invalidates the cache
+	bootstrapTouch (file);
+	succeed_if (bootstrapThreads () == 3, "changed bootstrap configuration read from cache");
+
+	elektraFree (bootstrapWrite (threads ? keyString (threads) : 0, cache ? keyString (cache) : 0));
+	elektraFree (file);
+	ksDel (original);
+
+	char * saved = cacheDir;
+	cacheDir = dir;
+	cacheClear ();
+	cacheDir = saved;
+	rmdir (dir);
+	char * parent = strrchr (dir, '/');
+	if (parent > dir + strlen (tempHome))
+	{
+		*parent = '\0';
+		rmdir (dir);
+	}
+	elektraFree (dir);
+}
+
+static void test_nested ()
+{
+	printf ("Test kdbGet with missing parents of cache directory\n");
+
+	char * dir = cacheDir;
+	size_t size = strlen (dir) + sizeof ("/nested/deep");
+	char * nested = elektraMalloc (size);
+	char * deep = elektraMalloc (size);
+	snprintf (nested, size, "%s/nested", dir);
+	snprintf (deep, size, "%s/nested/deep", dir);
+	cacheDir = deep;
+
+	cacheWriteFile ("value");
+	storageCalls = 0;
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	ksDel (cacheGet ("user/tests/cache", "storage", 1));
+	succeed_if (storageCalls == 1, "cache not written to new directory");
+
+	struct stat buf;
+	succeed_if (stat (deep, &buf) == 0 && (buf.st_mode & 0777) == 0700, "cache directory not private");
+
+	cacheClear ();
+	rmdir (deep);
+	rmdir (nested);
+	elektraFree (deep);
+	elektraFree (nested);
+	cacheDir = dir;
+}
+
+
+int main (int argc, char ** argv)
+{
+	printf ("GET CACHE TESTS\n");
+	printf ("==================\n\n");
+
+	init (argc, argv);
+
+	cacheDir = elektraMalloc (tempHomeLen + sizeof ("/cache"));
+	snprintf (cacheDir, tempHomeLen + sizeof ("/cache"), "%s/cache", tempHome);
+	cacheFile = elektraMalloc (tempHomeLen + sizeof ("/cache.ini"));
+	snprintf (cacheFile, tempHomeLen + sizeof ("/cache.ini"), "%s/cache.ini", tempHome);
+
+	test_hit ();
+	test_changed ();
+	test_corrupt ();
+	test_warnings ();
+	test_set ("storage", 1);
+	test_set ("stateful", 2);
+	test_bootstrap ();
+	test_nested ();
+
+	cacheClear ();
+	rmdir (cacheDir);
+	unlink (cacheFile);
+	elektraFree (cacheDir);
+	elektraFree (cacheFile);
+
+	printf ("\ntest_getcache RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
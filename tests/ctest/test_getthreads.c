@@ -0,0 +1,221 @@
+/**
+ * @file
+ *
+ * @brief Tests for updating backends in parallel within kdbGet()
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <tests_internal.h>
+
+#include <kdberrors.h>
+
+static int threadsResolverGet (Plugin * handle ELEKTRA_UNUSED, KeySet * returned ELEKTRA_UNUSED, Key * parentKey)
+{
+	keySetString (parentKey, "threads.file");
+	return 1;
+}
+
+/**
+ * Returns some keys below the parentKey,
+ * warns and fails depending on the name of the mountpoint.
+ */
+static int threadsStorageGet (Plugin * handle, KeySet * returned, Key * parentKey)
+{
+	if (!strncmp (keyName (parentKey), "system/elektra/modules/", sizeof ("system/elektra/modules/") - 1))
+	{
+		if (!strcmp (handle->name, "safe"))
+		{
+			ksAppendKey (returned, keyNew ("system/elektra/modules/safe/infos/threadsafe", KEY_VALUE, "1", KEY_END));
+		}
+		if (!strcmp (handle->name, "optout"))
+		{
+			ksAppendKey (returned, keyNew ("system/elektra/modules/optout/infos/threadsafe", KEY_VALUE, "0", KEY_END));
+		}
+		return 1;
+	}
+
+	// state passed on within the meta data of the parentKey
+	const Key * in = keyGetMeta (parentKey, "tests/in");
+
+	char name[10];
+	for (int i = 0; i < 100; ++i)
+	{
+		Key * k = keyNew (keyName (parentKey), KEY_VALUE, handle->name, KEY_END);
+		snprintf (name, sizeof (name), "key%d", i);
+		keyAddBaseName (k, name);
+		if (in) keySetMeta (k, "in", keyString (in));
+		ksAppendKey (returned, k);
+	}
+	keySetMeta (parentKey, "tests/last", keyName (parentKey));
+	keySetMeta (parentKey, "tests/remove", 0);
+
+	if (strstr (keyName (parentKey), "warn"))
+	{
+		ELEKTRA_ADD_WARNING (105, parentKey, keyName (parentKey));
+		ELEKTRA_ADD_WARNING (105, parentKey, handle->name);
+	}
+	if (strstr (keyName (parentKey), "error"))
+	{
+		ELEKTRA_SET_ERROR (10, parentKey, keyName (parentKey));
+		return -1;
+	}
+	return 1;
+}
+
+static Plugin * threadsPlugin (const char * name, kdbGetPtr get)
+{
+	Plugin * plugin = elektraPluginExport (name, ELEKTRA_PLUGIN_GET, get, ELEKTRA_PLUGIN_END);
+	plugin->refcounter = 1;
+	return plugin;
+}
+
+static void threadsMount (KDB * handle, const char * mountpoint, const char * storage)
+{
+	Backend * backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (mountpoint, KEY_VALUE, mountpoint, KEY_END);
+	keyIncRef (backend->mountpoint);
+	backend->getplugins[RESOLVER_PLUGIN] = threadsPlugin ("resolver", threadsResolverGet);
+	backend->getplugins[STORAGE_PLUGIN] = threadsPlugin (storage, threadsStorageGet);
+	elektraMountBackend (handle, backend, 0);
+}
+
+static KDB * threadsOpen (const char ** mountpoints, size_t threads)
+{
+	KDB * handle = elektraCalloc (sizeof (struct _KDB));
+	handle->split = elektraSplitNew ();
+	for (size_t i = 0; mountpoints[i]; ++i)
+	{
+		threadsMount (handle, mountpoints[i], strstr (mountpoints[i], "unsafe") ? "unsafe" : "safe");
+	}
+	handle->threads = threads;
+	return handle;
+}
+
+/**
+ * Compares everything kdbGet() returned with threads to the
+ * sequential result.
+ */
+static void test_get (const char ** mountpoints, const char * name, int expected)
+{
+	KDB * sequential = threadsOpen (mountpoints, 0);
+	KDB * parallel = threadsOpen (mountpoints, 4);
+
+	Key * parentSequential = keyNew (name, KEY_META, "tests/in", "from caller", KEY_META, "tests/remove", "", KEY_END);
+	Key * parentParallel = keyNew (name, KEY_META, "tests/in", "from caller", KEY_META, "tests/remove", "", KEY_END);
+	KeySet * ksSequential = ksNew (0, KS_END);
+	KeySet * ksParallel = ksNew (0, KS_END);
+
+	succeed_if (kdbGet (sequential, ksSequential, parentSequential) == expected, "sequential kdbGet wrong return value");
+	succeed_if (kdbGet (parallel, ksParallel, parentParallel) == expected, "parallel kdbGet wrong return value");
+
+	compare_key (parentSequential, parentParallel);
+	succeed_if (keyGetMeta (parentParallel, "tests/last"), "meta data set by plugins not merged");
+	succeed_if (!keyGetMeta (parentParallel, "tests/remove"), "meta data removed by plugins not removed");
+	if (expected == 1)
+	{
+		succeed_if (ksGetSize (ksParallel) > 0, "no keys returned");
+		succeed_if_same_string (keyString (keyGetMeta (ksAtCursor (ksParallel, 0), "in")), "from caller");
+		compare_keyset (ksSequential, ksParallel);
+	}
+	else
+	{
+		succeed_if (ksGetSize (ksParallel) == 0, "keys returned on error");
+	}
+
+	const Key * meta;
+	keyRewindMeta (parentSequential);
+	keyRewindMeta (parentParallel);
+	while ((meta = keyNextMeta (parentSequential)) != 0)
+	{
+		const Key * other = keyNextMeta (parentParallel);
+		exit_if_fail (other, "meta data of parentKey missing");
+		succeed_if_same_string (keyName (meta), keyName (other));
+		succeed_if_same_string (keyString (meta), keyString (other));
+	}
+	succeed_if (keyNextMeta (parentParallel) == 0, "too much meta data in parentKey");
+
+	ksDel (ksSequential);
+	ksDel (ksParallel);
+	kdbClose (sequential, parentSequential);
+	kdbClose (parallel, parentParallel);
+	keyDel (parentSequential);
+	keyDel (parentParallel);
+}
+
+static void test_simple ()
+{
+	printf ("Test parallel kdbGet\n");
+
+	const char * mountpoints[] = { "user/tests/threads",   "user/tests/threads/a", "user/tests/threads/b",
+				       "user/tests/threads/c", "user/tests/threads/d", 0 };
+	test_get (mountpoints, "user/tests/threads", 1);
+}
+
+static void test_cascading ()
+{
+	printf ("Test parallel kdbGet with cascading mountpoints\n");
+
+	const char * mountpoints[] = { "/tests/threads", "/tests/threads/a", "/tests/threads/b", "user/tests/threads/c", 0 };
+	test_get (mountpoints, "/tests/threads", 1);
+}
+
+static void test_warnings ()
+{
+	printf ("Test warnings of parallel kdbGet\n");
+
+	const char * mountpoints[] = { "user/tests/threads",	     "user/tests/threads/a",	     "user/tests/threads/warn1",
+				       "user/tests/threads/b",	     "user/tests/threads/warn2",     "user/tests/threads/warn3",
+				       "user/tests/threads/unsafewarn", "user/tests/threads/warn4", 0 };
+	test_get (mountpoints, "user/tests/threads", 1);
+}
+
+static void test_error ()
+{
+	printf ("Test errors of parallel kdbGet\n");
+
+	const char * mountpoints[] = { "user/tests/threads",	     "user/tests/threads/warn1", "user/tests/threads/error1",
+				       "user/tests/threads/warn2",    "user/tests/threads/error2", "user/tests/threads/unsafewarn",
+				       "user/tests/threads/unsafe",   0 };
+	test_get (mountpoints, "user/tests/threads", -1);
+}
+
+static void test_unsafe ()
+{
+	printf ("Test opt-in of thread-safe plugins\n");
+
+	Plugin * safe = threadsPlugin ("safe", threadsStorageGet);
+	Plugin * unsafe = threadsPlugin ("unsafe", threadsStorageGet);
+	Plugin * optout = threadsPlugin ("optout", threadsStorageGet);
+
+	succeed_if (elektraPluginThreadSafe (safe) == 1, "plugin opted in");
+	succeed_if (safe->threadsafe == 1, "answer should be cached");
+	succeed_if (elektraPluginThreadSafe (unsafe) == 0, "plugin without clause should not be thread-safe");
+	succeed_if (unsafe->threadsafe == -1, "answer should be cached");
+	succeed_if (elektraPluginThreadSafe (unsafe) == 0, "plugin without clause should not be thread-safe");
+	succeed_if (elektraPluginThreadSafe (optout) == 0, "plugin opted out");
+	succeed_if (elektraPluginThreadSafe (0) == 0, "null pointer");
+
+	elektraPluginClose (safe, 0);
+	elektraPluginClose (unsafe, 0);
+	elektraPluginClose (optout, 0);
+}
+
+
+int main (int argc, char ** argv)
+{
+	printf ("GET THREADS TESTS\n");
+	printf ("==================\n\n");
+
+	init (argc, argv);
+
+	test_simple ();
+	test_cascading ();
+	test_warnings ();
+	test_error ();
+	test_unsafe ();
+
+	printf ("\ntest_getthreads RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
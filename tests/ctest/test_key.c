@@ -1627,6 +1627,72 @@ static void test_keyFixedNew ()
 	keyDel (k2);
 }
 
+static void test_keyInline ()
+{
+	printf ("Test inline names and values\n");
+
+	Key * key = keyNew ("user/sw/app", KEY_VALUE, "short", KEY_END);
+	succeed_if (elektraKeyIsInline (key, key->key), "name should be stored inline");
+	succeed_if (elektraKeyIsInline (key, key->data.v), "value should be stored inline");
+	succeed_if_same_string (keyName (key), "user/sw/app");
+	succeed_if_same_string (keyString (key), "short");
+	succeed_if (!memcmp (keyUnescapedName (key), "user\0sw\0app", keyGetUnescapedNameSize (key)), "wrong unescaped name");
+
+	// grow the name beyond the inline buffer, the value stays
+	keyAddBaseName (key, "a_very_long_base_name_which_does_not_fit_into_the_buffer");
+	succeed_if (!elektraKeyIsInline (key, key->key), "name should be allocated");
+	succeed_if_same_string (keyName (key), "user/sw/app/a_very_long_base_name_which_does_not_fit_into_the_buffer");
+	succeed_if_same_string (keyString (key), "short");
+
+	// long values are allocated, short ones go back inline
+	char longValue[KEY_INLINE_MAX_SIZE + 10];
+	memset (longValue, 'x', sizeof (longValue) - 1);
+	longValue[sizeof (longValue) - 1] = 0;
+	keySetString (key, longValue);
+	succeed_if (!elektraKeyIsInline (key, key->data.v), "value should be allocated");
+	succeed_if_same_string (keyString (key), longValue);
+
+	keySetName (key, "user/x");
+	succeed_if (elektraKeyIsInline (key, key->key), "name should be stored inline again");
+	keySetString (key, "s");
+	succeed_if (elektraKeyIsInline (key, key->data.v), "value should be stored inline again");
+	keySetString (key, keyString (key));
+	succeed_if_same_string (keyString (key), "s");
+	keySetName (key, "user/y/z");
+	succeed_if_same_string (keyName (key), "user/y/z");
+	succeed_if_same_string (keyString (key), "s");
+
+	Key * dup = keyDup (key);
+	succeed_if (elektraKeyIsInline (dup, dup->key), "name of dup should be stored inline");
+	succeed_if (elektraKeyIsInline (dup, dup->data.v), "value of dup should be stored inline");
+	succeed_if_same_string (keyName (dup), "user/y/z");
+	succeed_if_same_string (keyString (dup), "s");
+
+	Key * copy = keyNew (0);
+	keySetString (key, longValue);
+	keyCopy (copy, key);
+	succeed_if_same_string (keyName (copy), "user/y/z");
+	succeed_if_same_string (keyString (copy), longValue);
+	keyCopy (copy, dup);
+	succeed_if_same_string (keyString (copy), "s");
+	keyCopy (copy, copy);
+	succeed_if_same_string (keyName (copy), "user/y/z");
+	succeed_if_same_string (keyString (copy), "s");
+	keyCopy (copy, 0);
+	succeed_if (copy->key == 0, "name not cleared");
+	succeed_if (copy->inlineSize > 0, "inline buffer lost");
+
+	keySetBinary (copy, "\0\1", 2);
+	succeed_if (elektraKeyIsInline (copy, copy->data.v), "binary value should be stored inline");
+	succeed_if (keyGetValueSize (copy) == 2, "wrong value size");
+	keySetBinary (copy, 0, 0);
+	succeed_if (copy->data.v == 0, "value not removed");
+
+	keyDel (copy);
+	keyDel (dup);
+	keyDel (key);
+}
+
 static void test_keyFlags ()
 {
 	printf ("Test KEY_FLAGS\n");
@@ -1651,6 +1717,144 @@ static void test_keyFlags ()
 	keyDel (key2);
 }
 
+static void test_keyArena ()
+{
+	printf ("Test keys allocated from an arena\n");
+
+	ElektraArena * arena = elektraArenaNew (0);
+	exit_if_fail (arena, "could not create arena");
+
+	Key * parent = keyNew ("user/tests/arena", KEY_VALUE, "parent", KEY_END);
+	KeySet * ks = ksNew (20, KS_END);
+	char name[50];
+	for (int i = 0; i < 1000; ++i)
+	{
+		Key * key = elektraArenaKeyDup (arena, parent);
+		snprintf (name, sizeof (name), "key%d", i);
+		keyAddBaseName (key, name);
+		keySetString (key, name);
+		succeed_if (key->arena == arena, "key not allocated from arena");
+		ksAppendKey (ks, key);
+	}
+	succeed_if (ksGetSize (ks) == 1000, "wrong number of keys");
+
+	Key * key = elektraArenaKeyNew (arena, "user/tests/arena/key1000", KEY_VALUE, "value", KEY_META, "meta", "data", KEY_END);
+	succeed_if_same_string (keyName (key), "user/tests/arena/key1000");
+	succeed_if_same_string (keyString (key), "value");
+	succeed_if_same_string (keyString (keyGetMeta (key, "meta")), "data");
+
+	// a big key gets a chunk of its own
+	char longValue[KEY_INLINE_MAX_SIZE * 2];
+	memset (longValue, 'x', sizeof (longValue) - 1);
+	longValue[sizeof (longValue) - 1] = 0;
+	Key * big = elektraArenaKeyNew (arena, "user/tests/arena/big", KEY_VALUE, longValue, KEY_END);
+	succeed_if_same_string (keyString (big), longValue);
+	keyDel (big);
+
+	// keys escaping the key set keep the arena alive
+	Key * escaped = ksLookupByName (ks, "user/tests/arena/key42", 0);
+	keyIncRef (escaped);
+	KeySet * other = ksNew (1, KS_END);
+	ksAppendKey (other, ksLookupByName (ks, "user/tests/arena/key43", 0));
+	ksAppendKey (other, key);
+	Key * dup = keyDup (ksLookupByName (ks, "user/tests/arena/key44", 0));
+	succeed_if (dup->arena == 0, "dup should not be allocated from arena");
+
+	elektraArenaDel (arena);
+	ksDel (ks);
+
+	succeed_if_same_string (keyName (escaped), "user/tests/arena/key42");
+	succeed_if_same_string (keyString (escaped), "key42");
+	keyClear (escaped);
+	succeed_if (escaped->arena != 0, "arena lost on clear");
+	succeed_if (keySetName (escaped, "user/tests/arena/renamed/with/a/name/which/does/not/fit/into/the/key") > 0, "could not set name");
+	keySetString (escaped, longValue);
+	succeed_if (keyCopy (escaped, dup) == 1, "could not copy key");
+	succeed_if_same_string (keyName (escaped), "user/tests/arena/key44");
+	succeed_if_same_string (keyString (escaped), "key44");
+	keyDecRef (escaped);
+	keyDel (escaped);
+
+	succeed_if (ksGetSize (other) == 2, "wrong number of keys");
+	succeed_if_same_string (keyString (ksLookupByName (other, "user/tests/arena/key43", 0)), "key43");
+	succeed_if_same_string (keyString (ksLookupByName (other, "user/tests/arena/key1000", 0)), "value");
+	ksDel (other);
+
+	succeed_if_same_string (keyString (dup), "key44");
+	keyDel (dup);
+
+	// without an arena keys are allocated as usual
+	key = elektraArenaKeyNew (0, "user/tests/noarena", KEY_VALUE, "value", KEY_END);
+	succeed_if (key->arena == 0, "key should not have an arena");
+	dup = elektraArenaKeyDup (0, key);
+	succeed_if_same_string (keyString (dup), "value");
+	keyDel (dup);
+	keyDel (key);
+	keyDel (parent);
+}
+
+static int adoptedReleased;
+
+static void adoptedRelease (void * memory, size_t size)
+{
+	succeed_if (size == 64, "wrong size of adopted memory");
+	elektraFree (memory);
+	++adoptedReleased;
+}
+
+static void test_keyArenaView ()
+{
+	printf ("Test keys viewing adopted memory\n");
+
+	Key * source = keyNew ("user/tests/view", KEY_VALUE, "value", KEY_END);
+	char * memory = elektraCalloc (64);
+	size_t nameSize = keyGetNameSize (source);
+	size_t unescapedSize = keyGetUnescapedNameSize (source);
+	memcpy (memory, keyName (source), nameSize);
+	memcpy (memory + nameSize, keyUnescapedName (source), unescapedSize);
+	memcpy (memory + 48, "value", 6);
+
+	ElektraArena * arena = elektraArenaNew (0);
+	succeed_if (elektraArenaKeyView (arena, memory, nameSize, unescapedSize, 0, 0) == 0, "view without adopted memory");
+	succeed_if (elektraArenaAdopt (arena, memory, 64, adoptedRelease) == 0, "could not adopt memory");
+	succeed_if (elektraArenaAdopt (arena, memory, 64, adoptedRelease) == -1, "adopted memory twice");
+
+	succeed_if (elektraArenaKeyView (arena, "user/tests/view", nameSize, unescapedSize, 0, 0) == 0, "name outside of memory");
+	succeed_if (elektraArenaKeyView (arena, memory, 64, unescapedSize, 0, 0) == 0, "name exceeding memory");
+	succeed_if (elektraArenaKeyView (arena, memory, nameSize - 1, unescapedSize, 0, 0) == 0, "name without terminating null");
+	succeed_if (elektraArenaKeyView (arena, memory, nameSize, unescapedSize, memory + 48, 17) == 0, "value exceeding memory");
+
+	Key * key = elektraArenaKeyView (arena, memory, nameSize, unescapedSize, memory + 48, 6);
+	exit_if_fail (key, "could not create view");
+	succeed_if (key->key == memory && key->data.c == memory + 48, "name or value copied");
+	succeed_if (elektraKeyIsBorrowed (key, key->key), "name should be borrowed");
+	succeed_if (keyCmp (key, source) == 0, "view differs from source");
+	succeed_if_same_string (keyString (key), "value");
+
+	Key * empty = elektraArenaKeyView (arena, memory, nameSize, unescapedSize, 0, 0);
+	succeed_if (empty && empty->data.v == 0, "key without value expected");
+	keyDel (empty);
+
+	// modifications copy, the adopted memory stays as it is
+	Key * dup = keyDup (key);
+	keySetString (key, "other");
+	succeed_if_same_string (keyString (key), "other");
+	succeed_if_same_string (memory + 48, "value");
+	keyAddBaseName (key, "child");
+	succeed_if_same_string (keyName (key), "user/tests/view/child");
+	succeed_if_same_string (memory, "user/tests/view");
+
+	elektraArenaDel (arena);
+	succeed_if (adoptedReleased == 0, "memory released with keys left");
+	keyDel (key);
+	succeed_if (adoptedReleased == 1, "memory not released with last key");
+
+	succeed_if_same_string (keyName (dup), "user/tests/view");
+	succeed_if_same_string (keyString (dup), "value");
+	keyDel (dup);
+	keyDel (source);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("KEY      TESTS\n");
@@ -1679,6 +1883,9 @@ int main (int argc, char ** argv)
 	test_keyCopy ();
 	test_keyFixedNew ();
 	test_keyFlags ();
+	test_keyInline ();
+	test_keyArena ();
+	test_keyArenaView ();
 
 	printf ("\ntest_key RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
@@ -156,6 +156,296 @@ static void test_creatingLookup ()
 	ksDel (ks);
 }
 
+static void test_hashIndexLookup ()
+{
+	printf ("Test lookup with hash index\n");
+
+	Key * a = keyNew ("user/a", KEY_END);
+	Key * b = keyNew ("user/b", KEY_END);
+	Key * c = keyNew ("user/c", KEY_END);
+	KeySet * ks = ksNew (10, a, c, KS_END);
+
+	succeed_if (elektraKsHashIndex (ks, 1) == 1, "could not enable index");
+	succeed_if (ksLookupByName (ks, "user/a", 0) == a, "did not find key");
+	succeed_if (ksCurrent (ks) == a, "cursor not set");
+	succeed_if (ksLookupByName (ks, "user/b", 0) == 0, "found key which is not there");
+	succeed_if (ksCurrent (ks) == a, "cursor changed on failed lookup");
+
+	// insert in the middle invalidates the index
+	ksAppendKey (ks, b);
+	succeed_if (ksLookupByName (ks, "user/b", 0) == b, "did not find inserted key");
+	succeed_if (ksLookupByName (ks, "user/c", 0) == c, "did not find moved key");
+
+	// append at the end updates the index
+	Key * d = keyNew ("user/d", KEY_END);
+	ksAppendKey (ks, d);
+	succeed_if (ksLookupByName (ks, "user/d", 0) == d, "did not find appended key");
+
+	// replacement keeps the position
+	Key * b2 = keyNew ("user/b", KEY_VALUE, "new", KEY_END);
+	ksAppendKey (ks, b2);
+	succeed_if (ksLookupByName (ks, "user/b", 0) == b2, "did not find replaced key");
+
+	// pop leaves stale entries behind
+	keyDel (ksPop (ks));
+	succeed_if (ksLookupByName (ks, "user/d", 0) == 0, "found popped key");
+	Key * e = keyNew ("user/e", KEY_END);
+	ksAppendKey (ks, e);
+	succeed_if (ksLookupByName (ks, "user/d", 0) == 0, "found popped key in place of other key");
+	succeed_if (ksLookupByName (ks, "user/e", 0) == e, "did not find appended key");
+
+	// pop in the middle
+	keyDel (ksLookupByName (ks, "user/a", KDB_O_POP));
+	succeed_if (ksLookupByName (ks, "user/a", 0) == 0, "found popped key");
+	succeed_if (ksLookupByName (ks, "user/c", 0) == c, "did not find moved key");
+
+	Key * cut = keyNew ("user/b", KEY_END);
+	KeySet * cutted = ksCut (ks, cut);
+	succeed_if (ksLookupByName (ks, "user/b", 0) == 0, "found cut key");
+	succeed_if (ksLookupByName (ks, "user/e", 0) == e, "did not find key after cut");
+	keyDel (cut);
+	ksDel (cutted);
+
+	succeed_if (ksLookupByName (ks, "/c", 0) == c, "cascading lookup did not find key");
+
+	succeed_if (elektraKsHashIndex (ks, 0) == 0, "could not disable index");
+	succeed_if (ksLookupByName (ks, "user/e", 0) == e, "did not find key without index");
+	ksDel (ks);
+
+	ks = ksNew (0, KS_END);
+	elektraKsHashIndex (ks, 1);
+	char name[64];
+	for (int i = 0; i < 1000; ++i)
+	{
+		snprintf (name, sizeof (name), "user/many/%d", i);
+		ksAppendKey (ks, keyNew (name, KEY_END));
+		succeed_if (ksLookupByName (ks, name, 0) != 0, "did not find just appended key");
+	}
+	for (int i = 0; i < 1000; ++i)
+	{
+		snprintf (name, sizeof (name), "user/many/%d", i);
+		Key * found = ksLookupByName (ks, name, 0);
+		succeed_if (found && !strcmp (keyName (found), name), "did not find key");
+	}
+	ksDel (ks);
+}
+
+static void test_cascadingLookupNamespaces (int index)
+{
+	printf ("test cascading lookup order of namespaces %s hash index\n", index ? "with" : "without");
+	Key * d = keyNew ("dir/sw/app/key", KEY_END);
+	Key * u = keyNew ("user/sw/app/key", KEY_END);
+	Key * s = keyNew ("system/sw/app/key", KEY_END);
+	Key * c = keyNew ("/sw/app/key", KEY_CASCADING_NAME, KEY_END);
+	Key * r = keyNew ("system", KEY_END);
+	KeySet * ks = ksNew (10, keyNew ("dir/sw/app", KEY_END), keyNew ("dir/sw/app/key/below", KEY_END), keyNew ("user/sw/app/keyx", KEY_END),
+			     keyNew ("user/sw/app/ke", KEY_END), d, u, s, c, r, KS_END);
+	elektraKsHashIndex (ks, index);
+
+	succeed_if (ksLookupByName (ks, "/sw/app/key", 0) == d, "dir should be found first");
+	succeed_if (ksCurrent (ks) == d, "cursor not set to found key");
+	succeed_if (ksLookupByName (ks, "/sw/app/key", KDB_O_POP) == d, "dir should be popped");
+	keyDel (d);
+	succeed_if (ksLookupByName (ks, "/sw/app/key", 0) == u, "user should be found after dir");
+	keyDel (ksLookup (ks, u, KDB_O_POP));
+	succeed_if (ksLookupByName (ks, "/sw/app/key", 0) == s, "system should be found after user");
+	keyDel (ksLookup (ks, s, KDB_O_POP));
+	succeed_if (ksLookupByName (ks, "/sw/app/key", 0) == c, "cascading key should be found last");
+	succeed_if (ksLookupByName (ks, "/sw/app/key", KDB_O_NODEFAULT) == 0, "cascading key should not be found");
+	succeed_if (ksLookupByName (ks, "/sw/app/k", 0) == 0, "found prefix of key");
+	succeed_if (ksLookupByName (ks, "/", 0) == r, "root not found");
+
+	Key * p = keyNew ("spec/sw/app/key", KEY_END);
+	keySetMeta (p, "default", "from spec");
+	ksAppendKey (ks, p);
+	Key * found = ksLookupByName (ks, "/sw/app/key", 0);
+	succeed_if (found == c, "spec key should lead to cascading key");
+	found = ksLookupByName (ks, "/sw/app/key", KDB_O_NOSPEC | KDB_O_NODEFAULT);
+	succeed_if (found == 0, "spec key should not be found with KDB_O_NOSPEC");
+	ksDel (ks);
+}
+
+static void test_dupCopyOnWrite ()
+{
+	printf ("Test copy on write of ksDup\n");
+
+	Key * a = keyNew ("user/a", KEY_END);
+	Key * b = keyNew ("user/b", KEY_END);
+	Key * c = keyNew ("user/c", KEY_END);
+	KeySet * ks = ksNew (5, a, b, c, KS_END);
+
+	KeySet * dup1 = ksDup (ks);
+	KeySet * dup2 = ksDup (ks);
+	KeySet * dup3 = ksDup (dup1);
+	succeed_if (dup1->array == ks->array, "array should be shared");
+	succeed_if (dup3->array == ks->array, "array should be shared");
+	succeed_if (keyGetRef (a) == 4, "wrong reference count");
+	succeed_if (ksCurrent (dup1) == c, "cursor should be on the last key");
+
+	// modifications only affect the modified key set
+	ksAppendKey (dup1, keyNew ("user/d", KEY_END));
+	succeed_if (dup1->array != ks->array, "array should be copied on write");
+	succeed_if (ksGetSize (dup1) == 4, "wrong size");
+	succeed_if (ksGetSize (ks) == 3, "original modified");
+	succeed_if (ksGetSize (dup3) == 3, "other duplicate modified");
+
+	Key * popped = ksPop (dup2);
+	succeed_if (popped == c, "wrong key popped");
+	keyDel (popped);
+	succeed_if (ksGetSize (dup2) == 2, "wrong size");
+	succeed_if (ksLookupByName (ks, "user/c", 0) == c, "key removed from original");
+
+	KeySet * cut = ksCut (dup3, b);
+	succeed_if (ksGetSize (cut) == 1, "wrong size of cut");
+	succeed_if (ksGetSize (dup3) == 2, "wrong size");
+	succeed_if (ksLookupByName (ks, "user/b", 0) == b, "key removed from original");
+	ksDel (cut);
+
+	Key * lookup = ksLookupByName (dup3, "user/a", KDB_O_POP);
+	succeed_if (lookup == a, "wrong key popped");
+	keyDel (lookup);
+	succeed_if (ksLookupByName (ks, "user/a", 0) == a, "key removed from original");
+
+	// deleting the original keeps the duplicates valid
+	KeySet * dup4 = ksDup (ks);
+	ksDel (ks);
+	succeed_if (ksGetSize (dup4) == 3, "wrong size");
+	succeed_if (keyGetRef (c) == 3, "wrong reference count");
+	ksRewind (dup4);
+	succeed_if (ksNext (dup4) == a, "wrong key");
+	succeed_if (ksNext (dup4) == b, "wrong key");
+	succeed_if (ksNext (dup4) == c, "wrong key");
+	ksClear (dup4);
+	succeed_if (keyGetRef (c) == 2, "wrong reference count");
+	ksAppendKey (dup4, keyNew ("user/e", KEY_END));
+	succeed_if (ksGetSize (dup4) == 1, "wrong size");
+
+	ksDel (dup4);
+	ksDel (dup3);
+	ksDel (dup2);
+	ksDel (dup1);
+
+	// meta data of deep duplicates is shared too
+	ks = ksNew (5, keyNew ("user/a", KEY_META, "m", "v", KEY_END), KS_END);
+	KeySet * deep = ksDeepDup (ks);
+	Key * orig = ksLookupByName (ks, "user/a", 0);
+	Key * copy = ksLookupByName (deep, "user/a", 0);
+	succeed_if (orig != copy, "key should be duplicated");
+	succeed_if (orig->meta->array == copy->meta->array, "meta data should be shared");
+	keySetMeta (copy, "m", "other");
+	succeed_if_same_string (keyString (keyGetMeta (orig, "m")), "v");
+	succeed_if_same_string (keyString (keyGetMeta (copy, "m")), "other");
+	ksDel (deep);
+	succeed_if_same_string (keyString (keyGetMeta (orig, "m")), "v");
+	ksDel (ks);
+}
+
+static void test_ksView ()
+{
+	printf ("Test views on key sets\n");
+
+	KeySet * ks = ksNew (20, keyNew ("system/a", KEY_END), keyNew ("user", KEY_END), keyNew ("user/a", KEY_END),
+			     keyNew ("user/a/b", KEY_END), keyNew ("user/a/b/c", KEY_END), keyNew ("user/a/d", KEY_END),
+			     keyNew ("user/a%", KEY_END), keyNew ("user/a\\/b", KEY_END), keyNew ("user/aa", KEY_END),
+			     keyNew ("user/b", KEY_END), KS_END);
+
+	Key * root = keyNew ("user/a", KEY_END);
+	ElektraKeySetView view;
+	succeed_if (elektraKsView (ks, root, &view) == 0, "could not create view");
+	succeed_if (elektraKsViewSize (&view) == 4, "wrong size of view");
+	succeed_if_same_string (keyName (elektraKsViewAt (&view, 0)), "user/a");
+	succeed_if_same_string (keyName (elektraKsViewAt (&view, 1)), "user/a/b");
+	succeed_if_same_string (keyName (elektraKsViewAt (&view, 2)), "user/a/b/c");
+	succeed_if_same_string (keyName (elektraKsViewAt (&view, 3)), "user/a/d");
+	succeed_if (elektraKsViewAt (&view, 4) == 0, "position after end");
+
+	succeed_if (elektraKsViewLookupByName (&view, "user/a/b/c") != 0, "key in view not found");
+	succeed_if (elektraKsViewLookupByName (&view, "user/a/x") == 0, "found key not in key set");
+	succeed_if (elektraKsViewLookupByName (&view, "user/aa") == 0, "found key not in view");
+	succeed_if (elektraKsViewLookupByName (&view, "user/b") == 0, "found key not in view");
+
+	// the view contains the same keys as ksCut
+	KeySet * copy = ksDup (ks);
+	KeySet * cut = ksCut (copy, root);
+	succeed_if (ksGetSize (cut) == 4, "wrong size of cut");
+	ksDel (cut);
+	ksDel (copy);
+
+	keySetName (root, "user");
+	succeed_if (elektraKsView (ks, root, &view) == 0, "could not create view");
+	succeed_if (elektraKsViewSize (&view) == 9, "wrong size of view");
+	succeed_if_same_string (keyName (elektraKsViewAt (&view, 0)), "user");
+
+	keySetName (root, "user/a/b/c/d");
+	succeed_if (elektraKsView (ks, root, &view) == 0, "could not create view");
+	succeed_if (elektraKsViewSize (&view) == 0, "view should be empty");
+
+	keySetName (root, "/a");
+	succeed_if (elektraKsView (ks, root, &view) == -1, "cascading view should fail");
+	succeed_if (elektraKsView (0, root, &view) == -1, "null pointer");
+
+	keyDel (root);
+	ksDel (ks);
+}
+
+static void test_ksBuilder ()
+{
+	printf ("Test building key sets\n");
+
+	ElektraKsBuilder * builder = elektraKsBuilderNew (0);
+	exit_if_fail (builder, "could not create builder");
+
+	Key * first = keyNew ("user/b", KEY_VALUE, "first", KEY_END);
+	Key * last = keyNew ("user/b", KEY_VALUE, "last", KEY_END);
+	Key * twice = keyNew ("user/a/x", KEY_END);
+	succeed_if (elektraKsBuilderAdd (builder, keyNew ("user/c", KEY_END)) == 1, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, first) == 2, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, twice) == 3, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, keyNew ("user/a", KEY_END)) == 4, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, last) == 5, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, twice) == 6, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, keyNew (0)) == -1, "key without name added");
+	succeed_if (elektraKsBuilderAdd (builder, 0) == -1, "null key added");
+	succeed_if (keyGetRef (twice) == 2, "wrong reference counter");
+
+	KeySet * ks = ksNew (0, KS_END);
+	succeed_if (elektraKsBuilderFinish (builder, ks) == 4, "wrong size of key set");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 0)), "user/a");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 1)), "user/a/x");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 2)), "user/b");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 3)), "user/c");
+	succeed_if (ksAtCursor (ks, 2) == last, "last key added should win");
+	succeed_if (keyGetRef (twice) == 1, "wrong reference counter");
+	succeed_if (keyGetRef (last) == 1, "wrong reference counter");
+	succeed_if (ksLookupByName (ks, "user/a/x", 0) == twice, "could not lookup key");
+
+	// reuse the builder to merge into a non-empty key set
+	succeed_if (elektraKsBuilderAdd (builder, keyNew ("user/d", KEY_END)) == 1, "wrong size");
+	succeed_if (elektraKsBuilderAdd (builder, keyNew ("user/a", KEY_VALUE, "new", KEY_END)) == 2, "wrong size");
+	succeed_if (elektraKsBuilderFinish (builder, ks) == 5, "wrong size of key set");
+	succeed_if_same_string (keyString (ksLookupByName (ks, "user/a", 0)), "new");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 4)), "user/d");
+	succeed_if (keyGetRef (ksLookupByName (ks, "user/d", 0)) == 1, "wrong reference counter");
+	succeed_if (elektraKsBuilderFinish (builder, ks) == 5, "empty builder changed key set");
+
+	// keys not finished are freed with the builder
+	elektraKsBuilderAdd (builder, keyNew ("user/e", KEY_END));
+	elektraKsBuilderDel (builder);
+	ksDel (ks);
+
+	// ksNew sorts unsorted keys once, the last duplicate wins
+	ks = ksNew (5, keyNew ("user/z", KEY_END), keyNew ("user/y", KEY_VALUE, "1", KEY_END), keyNew ("user/x", KEY_END),
+		    keyNew ("user/y", KEY_VALUE, "2", KEY_END), keyNew (0), keyNew ("system/w", KEY_END), KS_END);
+	succeed_if (ksGetSize (ks) == 4, "wrong size of key set");
+	succeed_if (ksCurrent (ks) == 0, "key set not rewinded");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 0)), "system/w");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 1)), "user/x");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 2)), "user/y");
+	succeed_if_same_string (keyName (ksAtCursor (ks, 3)), "user/z");
+	succeed_if_same_string (keyString (ksLookupByName (ks, "user/y", 0)), "2");
+	ksDel (ks);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("KS         TESTS\n");
@@ -166,7 +456,13 @@ int main (int argc, char ** argv)
 	test_elektraRenameKeys ();
 	test_elektraEmptyKeys ();
 	test_cascadingLookup ();
+	test_cascadingLookupNamespaces (0);
+	test_cascadingLookupNamespaces (1);
 	test_creatingLookup ();
+	test_hashIndexLookup ();
+	test_dupCopyOnWrite ();
+	test_ksView ();
+	test_ksBuilder ();
 
 	printf ("\ntest_ks RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
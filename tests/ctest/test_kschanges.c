@@ -0,0 +1,162 @@
+/**
+ * @file
+ *
+ * @brief Tests for the tracking of changed keys
+ *
+ * @copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ */
+
+#include <tests_internal.h>
+
+static KeySet * tracked (void)
+{
+	KeySet * ks = ksNew (10, keyNew ("user/a", KEY_VALUE, "a", KEY_END), keyNew ("user/b", KEY_VALUE, "b", KEY_END),
+			     keyNew ("user/c", KEY_VALUE, "c", KEY_END), keyNew ("user/c/d", KEY_VALUE, "d", KEY_END),
+			     keyNew ("user/e", KEY_VALUE, "e", KEY_END), KS_END);
+	clear_sync (ks);
+	succeed_if (elektraKsTrack (ks) == 0, "could not track");
+	return ks;
+}
+
+static int changed (KeySet * ks, const char * name)
+{
+	KeySet * changes = elektraKsChanges (ks);
+	return changes && ksLookupByName (changes, name, 0) != 0;
+}
+
+static void test_untracked ()
+{
+	printf ("Test untracked keyset\n");
+
+	KeySet * ks = ksNew (1, keyNew ("user/a", KEY_END), KS_END);
+	succeed_if (elektraKsChanges (ks) == 0, "changes of untracked keyset");
+	ksDel (ks);
+
+	ks = tracked ();
+	KeySet * changes = elektraKsChanges (ks);
+	succeed_if (changes != 0, "no changes of tracked keyset");
+	succeed_if (ksGetSize (changes) == 0, "changes without modification");
+	ksDel (ks);
+}
+
+static void test_values ()
+{
+	printf ("Test tracking of values and metadata\n");
+
+	KeySet * ks = tracked ();
+	keySetString (ksLookupByName (ks, "user/a", 0), "x");
+	keySetMeta (ksLookupByName (ks, "user/b", 0), "comment", "x");
+	keySetBinary (ksLookupByName (ks, "user/e", 0), "x", 1);
+
+	succeed_if (changed (ks, "user/a"), "value not tracked");
+	succeed_if (changed (ks, "user/b"), "metadata not tracked");
+	succeed_if (changed (ks, "user/e"), "binary value not tracked");
+	succeed_if (!changed (ks, "user/c"), "unchanged key tracked");
+	succeed_if (ksGetSize (elektraKsChanges (ks)) == 3, "wrong number of changes");
+
+	keySetString (ksLookupByName (ks, "user/a", 0), "y");
+	succeed_if (ksGetSize (elektraKsChanges (ks)) == 3, "change recorded twice");
+	ksDel (ks);
+}
+
+static void test_structure ()
+{
+	printf ("Test tracking of added and removed keys\n");
+
+	KeySet * ks = tracked ();
+	ksAppendKey (ks, keyNew ("user/f", KEY_END));
+	succeed_if (changed (ks, "user/f"), "appended key not tracked");
+
+	Key * popped = ksLookupByName (ks, "user/e", KDB_O_POP);
+	succeed_if (changed (ks, "user/e"), "popped key not tracked");
+	keyDel (popped);
+
+	KeySet * cut = ksCut (ks, ksLookupByName (ks, "user/c", 0));
+	succeed_if (changed (ks, "user/c"), "cut key not tracked");
+	succeed_if (changed (ks, "user/c/d"), "cut key below not tracked");
+	succeed_if (!changed (ks, "user/a"), "key not cut tracked");
+	ksDel (cut);
+
+	KeySet * other = ksNew (1, keyNew ("user/a", KEY_VALUE, "new", KEY_END), KS_END);
+	ksAppend (ks, other);
+	succeed_if (changed (ks, "user/a"), "replaced key not tracked");
+	ksDel (other);
+
+	ksClear (ks);
+	succeed_if (changed (ks, "user/b"), "cleared key not tracked");
+	ksDel (ks);
+}
+
+static void test_shared ()
+{
+	printf ("Test keys shared between tracked keysets\n");
+
+	KeySet * ks = tracked ();
+	KeySet * dup = ksDup (ks);
+	succeed_if (elektraKsTrack (dup) == 0, "could not track");
+
+	succeed_if (elektraKsChanges (ks) == 0, "changes of keys shared with another tracked keyset are complete");
+	succeed_if (elektraKsChanges (dup) != 0, "changes of last tracked keyset incomplete");
+
+	keySetString (ksLookupByName (dup, "user/a", 0), "x");
+	succeed_if (changed (dup, "user/a"), "value not tracked");
+	ksDel (ks);
+	keySetString (ksLookupByName (dup, "user/b", 0), "x");
+	succeed_if (changed (dup, "user/b"), "value not tracked after other keyset was deleted");
+	ksDel (dup);
+
+	ks = tracked ();
+	Key * k = keyDup (ksLookupByName (ks, "user/a", 0));
+	keySetString (k, "x");
+	succeed_if (!changed (ks, "user/a"), "duplicated key tracked");
+	keyDel (k);
+
+	k = keyDup (ksLookupByName (ks, "user/b", 0));
+	ksAppendKey (ks, k);
+	keyIncRef (k);
+	ksDel (ks);
+	// the key outlives the keyset and its changes
+	keyDecRef (k);
+	keySetString (k, "y");
+	keyDel (k);
+}
+
+static void test_untrack ()
+{
+	printf ("Test untracking of keyset\n");
+
+	KeySet * ks = tracked ();
+	Key * k = ksLookupByName (ks, "user/a", 0);
+	keySetString (k, "x");
+
+	KeySetChanges * changes = elektraKsUntrack (ks);
+	succeed_if (elektraKsChanges (ks) == 0, "untracked keyset has changes");
+	succeed_if (ksLookupByName (changes->names, "user/a", 0) != 0, "changes lost");
+
+	ksAppendKey (ks, keyNew ("user/g", KEY_END));
+	succeed_if (ksLookupByName (changes->names, "user/g", 0) == 0, "untracked keyset recorded changes");
+
+	ks->changes = changes;
+	succeed_if (elektraKsTrack (ks) == 0, "could not track");
+	succeed_if (changed (ks, "user/a"), "changes lost");
+	succeed_if (changed (ks, "user/g"), "key needing sync not recorded");
+	ksDel (ks);
+}
+
+int main (int argc, char ** argv)
+{
+	printf ("KEYSET CHANGES TESTS\n");
+	printf ("====================\n\n");
+
+	init (argc, argv);
+
+	test_untracked ();
+	test_values ();
+	test_structure ();
+	test_shared ();
+	test_untrack ();
+
+	printf ("\ntest_kschanges RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
@@ -511,6 +511,84 @@ static void test_top ()
 	ksDel (testCycleOrder3);
 	elektraFree (array);
 }
+
+static void test_metaLookupNames ()
+{
+	printf ("Test lookup of meta names\n");
+	Key * key = keyNew ("user/test", KEY_META, "check/type", "string", KEY_META, "order", "5", KEY_META, "a/b/c", "abc",
+			    KEY_META, "x\\/y", "escaped", KEY_META, "user", "user", KEY_META, "", "empty", KEY_END);
+
+	succeed_if_same_string (keyString (keyGetMeta (key, "check/type")), "string");
+	succeed_if_same_string (keyString (keyGetMeta (key, "order")), "5");
+	succeed_if_same_string (keyString (keyGetMeta (key, "a/b/c")), "abc");
+	succeed_if_same_string (keyString (keyGetMeta (key, "a//b/c/")), "abc");
+	succeed_if_same_string (keyString (keyGetMeta (key, "a/./b/c")), "abc");
+	succeed_if_same_string (keyString (keyGetMeta (key, "a/b/x/../c")), "abc");
+	succeed_if_same_string (keyString (keyGetMeta (key, "x\\/y")), "escaped");
+	succeed_if_same_string (keyString (keyGetMeta (key, "user")), "user");
+	succeed_if (keyGetMeta (key, "check") == 0, "found parent of meta key");
+	succeed_if (keyGetMeta (key, "check/type/x") == 0, "found child of meta key");
+	succeed_if (keyGetMeta (key, "x/y") == 0, "found unescaped meta key");
+
+	Key * typeAtom = keyMetaAtom ("check/type");
+	Key * escapedAtom = keyMetaAtom ("x\\/y");
+	Key * missingAtom = keyMetaAtom ("check/missing");
+	succeed_if (keyGetMetaAtom (key, typeAtom) == keyGetMeta (key, "check/type"), "atom lookup differs");
+	succeed_if_same_string (keyString (keyGetMetaAtom (key, escapedAtom)), "escaped");
+	succeed_if (keyGetMetaAtom (key, missingAtom) == 0, "found missing meta key");
+	succeed_if (keyGetMetaAtom (0, typeAtom) == 0, "null key");
+	succeed_if (keyGetMetaAtom (key, 0) == 0, "null atom");
+	succeed_if (keySetName (typeAtom, "check/other") == -1, "atom name should be read only");
+
+	keyDel (typeAtom);
+	keyDel (escapedAtom);
+	keyDel (missingAtom);
+	keyDel (key);
+}
+
+static void test_ownerCache ()
+{
+	printf ("Test cached owner\n");
+	Key * key = keyNew ("user/test", KEY_END);
+	succeed_if (key->owner == 0, "owner cached without meta data");
+
+	keySetMeta (key, "owner", "hugo");
+	succeed_if_same_string (key->owner, "hugo");
+	keySetMeta (key, "owner", "max");
+	succeed_if_same_string (key->owner, "max");
+	keySetMeta (key, "other", "value");
+	succeed_if_same_string (key->owner, "max");
+
+	Key * dup = keyDup (key);
+	succeed_if_same_string (dup->owner, "max");
+	Key * copy = keyNew (0);
+	keyCopy (copy, key);
+	succeed_if_same_string (copy->owner, "max");
+	keyCopy (copy, 0);
+	succeed_if (copy->owner == 0, "owner not cleared");
+
+	Key * other = keyNew ("user/other", KEY_OWNER, "egon", KEY_END);
+	keyCopyMeta (copy, other, "owner");
+	succeed_if_same_string (copy->owner, "egon");
+	keyCopyAllMeta (copy, key);
+	succeed_if_same_string (copy->owner, "max");
+
+	keySetMeta (key, "owner", 0);
+	succeed_if (key->owner == 0, "owner not removed");
+	succeed_if_same_string (dup->owner, "max");
+
+	KeySet * ks = ksNew (5, dup, other, KS_END);
+	Key * same = keyNew ("user/test", KEY_OWNER, "hugo", KEY_END);
+	ksAppendKey (ks, same);
+	succeed_if (ksGetSize (ks) == 3, "keys with different owner should not replace each other");
+	succeed_if (ksLookup (ks, same, KDB_O_WITHOWNER) == same, "could not find key with owner");
+	succeed_if (ksLookup (ks, dup, KDB_O_WITHOWNER) == dup, "could not find key with owner");
+
+	ksDel (ks);
+	keyDel (copy);
+	keyDel (key);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("KEY META     TESTS\n");
@@ -527,6 +605,8 @@ int main (int argc, char ** argv)
 
 	test_metaArrayToKS ();
 	test_top ();
+	test_metaLookupNames ();
+	test_ownerCache ();
 	printf ("\ntest_meta RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
 	return nbError;
@@ -250,6 +250,98 @@ static void test_simpletrie ()
 }
 
 
+static void test_lazytrie ()
+{
+	printf ("Test lazy mount with plugins\n");
+
+	KDB * kdb = kdb_new ();
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+
+	KeySet * config = set_simple ();
+	ksAppendKey (config, keyNew ("system/elektra/mountpoints", KEY_END));
+	succeed_if (elektraMountOpenLazy (kdb, config, modules, 0) == 0, "could not open mount");
+
+	Key * key = keyNew ("user/tests/backend/simple/below", KEY_END);
+	Backend * backend = elektraTrieLookup (kdb->trie, key);
+	exit_if_fail (backend, "there should be a backend");
+
+	succeed_if (backend->getplugins[1] == 0, "plugin should not be opened yet");
+	succeed_if (backend->setplugins[1] == 0, "plugin should not be opened yet");
+	succeed_if (backend->config != 0, "config should be kept for loading");
+	succeed_if_same_string (keyName (backend->mountpoint), "user/tests/backend/simple");
+	succeed_if_same_string (keyString (backend->mountpoint), "simple");
+
+	Key * errorKey = keyNew ("user/tests/backend", KEY_END);
+	succeed_if (elektraKdbPrewarm (kdb, errorKey) == 0, "could not prewarm");
+	succeed_if (output_warnings (errorKey), "warnings found");
+	succeed_if_same_string (keyName (errorKey), "user/tests/backend");
+
+	succeed_if (backend->config == 0, "config should be consumed");
+	succeed_if (backend->getplugins[0] == 0, "there should be no plugin");
+	exit_if_fail (backend->getplugins[1] != 0, "there should be a plugin");
+	succeed_if (backend->setplugins[0] == 0, "there should be no plugin");
+	exit_if_fail (backend->setplugins[1] != 0, "there should be a plugin");
+
+	KeySet * test_config = set_pluginconf ();
+	compare_keyset (elektraPluginGetConfig (backend->getplugins[1]), test_config);
+	ksDel (test_config);
+
+	Plugin * plugin = backend->getplugins[1];
+	succeed_if (elektraBackendLoad (backend, errorKey) == 0, "loading again should do nothing");
+	succeed_if (backend->getplugins[1] == plugin, "plugin should not be reopened");
+
+	succeed_if (elektraKdbPrewarm (0, errorKey) == -1, "null pointer");
+	succeed_if (elektraKdbPrewarm (kdb, 0) == -1, "null pointer");
+
+	keyDel (errorKey);
+	keyDel (key);
+	kdb_del (kdb);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+static void test_lazymissing ()
+{
+	printf ("Test lazy mount with missing plugin\n");
+
+	KDB * kdb = kdb_new ();
+	KeySet * modules = ksNew (0, KS_END);
+	elektraModulesInit (modules, 0);
+
+	KeySet * config = ksNew (5, keyNew ("system/elektra/mountpoints", KEY_END), keyNew ("system/elektra/mountpoints/missing", KEY_END),
+				 keyNew ("system/elektra/mountpoints/missing/getplugins", KEY_END),
+				 keyNew ("system/elektra/mountpoints/missing/getplugins/#1nonexistingplugin", KEY_END),
+				 keyNew ("system/elektra/mountpoints/missing/mountpoint", KEY_VALUE, "user/tests/backend/missing", KEY_END),
+				 KS_END);
+	Key * errorKey = keyNew ("user/tests/backend/missing", KEY_END);
+	succeed_if (elektraMountOpenLazy (kdb, config, modules, errorKey) == 0, "could not open mount");
+	succeed_if (!keyGetMeta (errorKey, "warnings"), "no warnings expected before first use");
+
+	Backend * backend = elektraTrieLookup (kdb->trie, errorKey);
+	exit_if_fail (backend, "there should be a backend");
+	succeed_if (elektraBackendLoad (backend, errorKey) == -1, "loading should fail");
+	succeed_if (keyGetMeta (errorKey, "warnings"), "warnings expected after first use");
+	succeed_if (backend->config == 0, "config should be consumed");
+
+	// still mounted, but as missing backend
+	succeed_if (elektraTrieLookup (kdb->trie, errorKey) == backend, "backend should stay mounted");
+	succeed_if_same_string (keyName (backend->mountpoint), "user/tests/backend/missing");
+	succeed_if_same_string (keyString (backend->mountpoint), "missing");
+	exit_if_fail (backend->getplugins[0] != 0, "there should be the missing plugin");
+	succeed_if_same_string (backend->getplugins[0]->name, "missing");
+
+	KeySet * ks = ksNew (0, KS_END);
+	succeed_if (backend->getplugins[0]->kdbGet (backend->getplugins[0], ks, errorKey) == -1, "missing plugin should fail");
+	ksDel (ks);
+
+	keyDel (errorKey);
+	kdb_del (kdb);
+	elektraModulesClose (modules, 0);
+	ksDel (modules);
+}
+
+
 KeySet * set_two ()
 {
 	return ksNew (50, keyNew ("system/elektra/mountpoints", KEY_END), keyNew ("system/elektra/mountpoints/simple", KEY_END),
@@ -1046,6 +1138,8 @@ int main (int argc, char ** argv)
 	test_minimaltrie ();
 	test_simple ();
 	test_simpletrie ();
+	test_lazytrie ();
+	test_lazymissing ();
 	test_two ();
 	test_us ();
 	test_endings ();
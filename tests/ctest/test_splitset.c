@@ -1208,6 +1208,174 @@ static void test_state ()
 }
 
 
+static void test_ranges ()
+{
+	printf ("Test dividing ranges of nested mountpoints\n");
+
+	KDB * handle = kdb_open ();
+
+	succeed_if (elektraMountOpen (handle, set_realworld (), handle->modules, 0) == 0, "could not open mountpoints");
+	succeed_if (elektraMountDefault (handle, handle->modules, 1, 0) == 0, "could not open default backend");
+
+	KeySet * ks = ksNew (30, keyNew ("/cascading", KEY_END), keyNew ("dir/d", KEY_END), keyNew ("proc/p", KEY_END),
+			     keyNew ("spec/s", KEY_END), keyNew ("system/elektra/x", KEY_END), keyNew ("system/elektrax", KEY_END),
+			     keyNew ("system/hosts", KEY_END), keyNew ("system/hosts/a", KEY_END), keyNew ("system/hosts\\/a", KEY_END),
+			     keyNew ("system/hostsx", KEY_END), keyNew ("user/sw", KEY_END), keyNew ("user/sw/apps", KEY_END),
+			     keyNew ("user/sw/apps/app1", KEY_END), keyNew ("user/sw/apps/app1/default", KEY_END),
+			     keyNew ("user/sw/apps/app1/default/x", KEY_END), keyNew ("user/sw/apps/app1/defaultx", KEY_END),
+			     keyNew ("user/sw/apps/app2/y", KEY_END), keyNew ("user/sw/apps/app2/y/z", KEY_END),
+			     keyNew ("user/sw/apps/app3", KEY_END), keyNew ("user/sw/kde/default/k", KEY_END), keyNew ("user/sw/zzz", KEY_END),
+			     KS_END);
+
+	Split * split = elektraSplitNew ();
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivide (split, handle, ks) == 1, "should need sync");
+
+	// every key must be where a lookup of its backend puts it
+	Key * cur;
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != 0)
+	{
+		ssize_t found = elektraSplitSearchBackend (split, elektraMountGetBackend (handle, cur), cur);
+		for (size_t i = 0; i < split->size; ++i)
+		{
+			Key * inSplit = ksLookup (split->keysets[i], cur, 0);
+			if ((ssize_t)i == found)
+			{
+				succeed_if (inSplit == cur, "key not in split of its backend");
+			}
+			else
+			{
+				succeed_if (inSplit == 0, "key in wrong split");
+			}
+			if (inSplit && (ssize_t)i != found) printf ("%s in split %zu instead of %zd\n", keyName (cur), i, found);
+		}
+	}
+
+	elektraSplitDel (split);
+
+	split = elektraSplitNew ();
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitAppoint (split, handle, ks) == 1, "could not appoint keys");
+
+	ssize_t total = 0;
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		total += ksGetSize (split->keysets[i]);
+	}
+	succeed_if (total == ksGetSize (ks), "every key should be appointed once");
+	succeed_if (ksLookupByName (split->keysets[split->size - 1], "proc/p", 0) != 0, "proc key should be in default split");
+
+	elektraSplitDel (split);
+	ksDel (ks);
+	kdb_close (handle);
+}
+
+static void test_changes ()
+{
+	printf ("Test dividing only changed backends\n");
+
+	KDB * handle = kdb_open ();
+
+	succeed_if (elektraMountOpen (handle, set_realworld (), handle->modules, 0) == 0, "could not open mountpoints");
+	succeed_if (elektraMountDefault (handle, handle->modules, 1, 0) == 0, "could not open default backend");
+
+	KeySet * ks = ksNew (10, keyNew ("system/hosts/a", KEY_END), keyNew ("system/users/b", KEY_END),
+			     keyNew ("user/sw/apps/app1/default/x", KEY_END), keyNew ("user/sw/apps/app2/y", KEY_END), KS_END);
+	clear_sync (ks);
+
+	Split * split = elektraSplitNew ();
+	KeySet * changes = ksNew (0, KS_END);
+	Key * errorKey = 0;
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivideChanges (split, handle, ks, changes, &errorKey) == 0, "should not need sync without changes");
+	elektraSplitDel (split);
+
+	// a removed key only occurs in the changes
+	ksAppendKey (changes, keyNew ("system/hosts/removed", KEY_END));
+	ksAppendKey (changes, keyNew ("user/sw/apps/app2/y", KEY_END));
+
+	split = elektraSplitNew ();
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivideChanges (split, handle, ks, changes, &errorKey) == 1, "should need sync");
+
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		const char * mountpoint = split->handles[i] ? keyName (split->handles[i]->mountpoint) : "";
+		if (!strcmp (mountpoint, "system/hosts"))
+		{
+			succeed_if (split->syncbits[i] & SPLIT_FLAG_SYNC, "backend of removed key not synced");
+			succeed_if (ksGetSize (split->keysets[i]) == 1, "keys of backend not divided");
+		}
+		else if (!strcmp (mountpoint, "user/sw/apps/app2"))
+		{
+			succeed_if (split->syncbits[i] & SPLIT_FLAG_SYNC, "backend of changed key not synced");
+			succeed_if (ksGetSize (split->keysets[i]) == 1, "keys of backend not divided");
+		}
+		else
+		{
+			succeed_if (!(split->syncbits[i] & SPLIT_FLAG_SYNC), "unchanged backend synced");
+			succeed_if (ksGetSize (split->keysets[i]) == 0, "keys of unchanged backend divided");
+		}
+	}
+	elektraSplitDel (split);
+
+	// all keys removed
+	ksClear (ks);
+	split = elektraSplitNew ();
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivideChanges (split, handle, ks, changes, &errorKey) == 1, "should need sync without keys");
+	elektraSplitDel (split);
+	succeed_if (errorKey == 0, "error key set without error");
+
+	ksDel (changes);
+	ksDel (ks);
+	kdb_close (handle);
+}
+
+static void test_changesWithoutBackend ()
+{
+	printf ("Test dividing a removed key without backend\n");
+
+	KDB * handle = kdb_open ();
+
+	// without a root or default backend
+	KeySet * mountpoints = ksNew (5, keyNew ("system/elektra/mountpoints", KEY_END), keyNew ("system/elektra/mountpoints/hosts", KEY_END),
+				      keyNew ("system/elektra/mountpoints/hosts/mountpoint", KEY_VALUE, "system/hosts", KEY_END), KS_END);
+	succeed_if (elektraMountOpen (handle, mountpoints, handle->modules, 0) == 0, "could not open mountpoints");
+
+	KeySet * ks = ksNew (10, keyNew ("system/hosts/a", KEY_END), KS_END);
+	ksRewind (ks);
+	ksNext (ks);
+	KeySet * changes = ksNew (10, keyNew ("system/hosts/a", KEY_END), keyNew ("system/nomount/removed", KEY_END), KS_END);
+
+	Split * split = elektraSplitNew ();
+	Key * errorKey = 0;
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivideChanges (split, handle, ks, changes, &errorKey) == -1, "key without backend not detected");
+	exit_if_fail (errorKey, "no error key");
+	succeed_if_same_string (keyName (errorKey), "system/nomount/removed");
+	succeed_if_same_string (keyName (ksCurrent (ks)), "system/hosts/a");
+	elektraSplitDel (split);
+
+	// keys not stored by backends need none
+	ksAppendKey (ks, keyNew ("/cascading", KEY_END));
+	ksAppendKey (ks, keyNew ("proc/p", KEY_END));
+	split = elektraSplitNew ();
+	succeed_if (elektraSplitBuildup (split, handle, 0) == 1, "buildup failure");
+	succeed_if (elektraSplitDivide (split, handle, ks) == 1, "keys in other namespaces not skipped");
+	for (size_t i = 0; i < split->size; ++i)
+	{
+		succeed_if (!ksLookupByName (split->keysets[i], "proc/p", 0), "proc key divided");
+		succeed_if (!ksLookupByName (split->keysets[i], "/cascading", 0), "cascading key divided");
+	}
+	elektraSplitDel (split);
+
+	ksDel (changes);
+	ksDel (ks);
+	kdb_close (handle);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("SPLIT SET   TESTS\n");
@@ -1227,6 +1395,9 @@ int main (int argc, char ** argv)
 	test_emptysplit ();
 	test_nothingsync ();
 	test_state ();
+	test_ranges ();
+	test_changes ();
+	test_changesWithoutBackend ();
 
 	printf ("\ntest_splitset RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
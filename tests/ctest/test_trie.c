@@ -93,15 +93,10 @@ static void test_simple ()
 
 static void collect_mountpoints (Trie * trie, KeySet * mountpoints)
 {
-	int i;
-	for (i = 0; i < KDB_MAX_UCHAR; ++i)
+	if (trie->value) ksAppendKey (mountpoints, ((Backend *)trie->value)->mountpoint);
+	for (size_t i = 0; i < trie->size; ++i)
 	{
-		if (trie->value[i]) ksAppendKey (mountpoints, ((Backend *)trie->value[i])->mountpoint);
-		if (trie->children[i]) collect_mountpoints (trie->children[i], mountpoints);
-	}
-	if (trie->empty_value)
-	{
-		ksAppendKey (mountpoints, ((Backend *)trie->empty_value)->mountpoint);
+		collect_mountpoints (trie->children[i], mountpoints);
 	}
 }
 
@@ -789,6 +784,40 @@ static void test_emptyvalues ()
 }
 
 
+static void test_manychildren ()
+{
+	printf ("Test nodes with many children\n");
+
+	char name[64];
+	Trie * trie = test_insert (0, "user/", "user");
+	for (int i = 1; i < 256; ++i)
+	{
+		// every mountpoint starts with another character after "user/"
+		snprintf (name, sizeof (name), "user/%c%d/", i == '/' ? 'x' : i, i);
+		trie = test_insert (trie, name, name);
+	}
+
+	Key * searchKey = keyNew ("", KEY_END);
+	for (int i = 1; i < 256; ++i)
+	{
+		snprintf (name, sizeof (name), "user/%c%d/", i == '/' ? 'x' : i, i);
+		if (keySetName (searchKey, name) == -1) continue;
+		Backend * backend = elektraTrieLookup (trie, searchKey);
+		succeed_if (backend && !strcmp (keyString (backend->mountpoint), name), "wrong backend for mountpoint");
+
+		keyAddBaseName (searchKey, "below");
+		succeed_if (elektraTrieLookup (trie, searchKey) == backend, "wrong backend below mountpoint");
+	}
+
+	// only whole parts of names match
+	keySetName (searchKey, "user/a97x");
+	Backend * backend = elektraTrieLookup (trie, searchKey);
+	succeed_if (backend && !strcmp (keyString (backend->mountpoint), "user"), "should be the user backend");
+
+	keyDel (searchKey);
+	elektraTrieClose (trie, 0);
+}
+
 int main (int argc, char ** argv)
 {
 	printf ("TRIE       TESTS\n");
@@ -807,6 +836,7 @@ int main (int argc, char ** argv)
 	test_root ();
 	test_double ();
 	test_emptyvalues ();
+	test_manychildren ();
 
 	printf ("\ntest_trie RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 